@@ -0,0 +1,92 @@
+#ifndef BINARY_PROTOCOL_HPP
+#define BINARY_PROTOCOL_HPP
+
+#include <cstdint>
+#include <cstddef>
+
+class BoardManager;
+class SpiManager;
+
+// Framed binary command protocol (entered from SCPI with SYST:BIN)
+//
+// Request:  [SYNC][LEN_L][LEN_H][OPCODE][PAYLOAD x LEN][CRC_L][CRC_H]
+// Reply:    [SYNC][LEN_L][LEN_H][OPCODE|REPLY][STATUS][PAYLOAD x (LEN-1)][CRC_L][CRC_H]
+//
+// LEN counts the bytes after OPCODE (payload only). CRC is CRC-16/CCITT
+// (poly 0x1021, init 0xFFFF) over LEN, OPCODE and PAYLOAD. All multi-byte
+// fields are little-endian. No echo and no prompt are sent in binary mode.
+namespace BINARY {
+    constexpr uint8_t SYNC  = 0xA5;
+    constexpr uint8_t REPLY = 0x80;         // OR'd into the opcode of every reply
+
+    constexpr uint16_t MAX_PAYLOAD = 1024;  // Largest accepted request payload
+    constexpr uint32_t FRAME_TIMEOUT_US = 100 * 1000;  // Inter-byte gap that restarts sync
+
+    // Opcodes
+    constexpr uint8_t OP_NOP          = 0x00;  // No payload; link check
+    constexpr uint8_t OP_WRITE_CODE   = 0x01;  // N x [board][dac][ch][code_l][code_h], input register only
+    constexpr uint8_t OP_WRITE_UPDATE = 0x02;  // N x [board][dac][ch][code_l][code_h], write and update
+    constexpr uint8_t OP_SET_SPAN     = 0x03;  // N x [board][dac][ch|CH_ALL][span]
+    constexpr uint8_t OP_LDAC         = 0x04;  // No payload; pulse LDAC
+    constexpr uint8_t OP_FAULT_READ   = 0x05;  // Reply: [active][mask_0][mask_1][mask_2]
+    constexpr uint8_t OP_EXIT         = 0x7F;  // Reply OK, then return to SCPI mode
+
+    constexpr uint8_t CH_ALL = 0xFF;           // SET_SPAN: apply to every channel
+
+    constexpr size_t CODE_ENTRY_SIZE = 5;
+    constexpr size_t SPAN_ENTRY_SIZE = 4;
+
+    // Reply status codes
+    constexpr uint8_t STATUS_OK          = 0x00;
+    constexpr uint8_t STATUS_BAD_CRC     = 0x01;
+    constexpr uint8_t STATUS_BAD_OPCODE  = 0x02;
+    constexpr uint8_t STATUS_BAD_LENGTH  = 0x03;
+    constexpr uint8_t STATUS_BAD_ADDRESS = 0x04;
+    constexpr uint8_t STATUS_BAD_VALUE   = 0x05;
+    constexpr uint8_t STATUS_BUSY        = 0x06;  // Staged write while the sequencer runs
+}
+
+// Receives binary frames byte by byte and maps them onto BoardManager/SpiManager
+class BinaryProtocol {
+public:
+    // Reply byte sink; the default writes straight to stdio with putchar_raw
+    using ByteSink = void (*)(uint8_t byte);
+
+    BinaryProtocol(BoardManager& boards, SpiManager& spi);
+
+    // Redirect reply bytes (e.g. into the inter-core ring when running on core 1)
+    void set_output(ByteSink sink) { output_ = sink; }
+
+    // Feed one received byte; a complete frame is dispatched and answered
+    void feed(uint8_t byte);
+
+    // True once an EXIT frame has been answered (caller returns to SCPI mode)
+    bool exit_requested() const { return exit_requested_; }
+
+    // Discard any partial frame and clear the exit flag
+    void reset();
+
+private:
+    enum class RxState { SYNC, LEN_L, LEN_H, OPCODE, PAYLOAD, CRC_L, CRC_H };
+
+    BoardManager& boards_;
+    SpiManager& spi_;
+    ByteSink output_;
+
+    RxState state_ = RxState::SYNC;
+    uint16_t length_ = 0;
+    uint16_t received_ = 0;
+    uint16_t crc_ = 0;
+    uint64_t last_byte_us_ = 0;
+    bool exit_requested_ = false;
+
+    // Frame under construction: [LEN_L][LEN_H][OPCODE][PAYLOAD...] (CRC input)
+    uint8_t frame_[3 + BINARY::MAX_PAYLOAD];
+
+    void dispatch();
+    uint8_t handle_write(const uint8_t* payload, uint16_t len, bool update);
+    uint8_t handle_span(const uint8_t* payload, uint16_t len);
+    void send_reply(uint8_t opcode, uint8_t status, const uint8_t* payload, uint16_t len);
+};
+
+#endif // BINARY_PROTOCOL_HPP
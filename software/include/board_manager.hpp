@@ -2,15 +2,19 @@
 #define BOARD_MANAGER_HPP
 
 #include <array>
-#include <string>
 #include <memory>
 #include <cstdio>
 
 #include "dac_device.hpp"
 #include "spi_manager.hpp"
 #include "scpi_parser.hpp"
+#include "response_buffer.hpp"
 #include "ltc2662.hpp"
 #include "ltc2664.hpp"
+#include "sequencer.hpp"
+#include "fault_monitor.hpp"
+#include "external_trigger.hpp"
+#include "setpoint_transform.hpp"
 
 // Board configuration
 // Each board has 3 DACs:
@@ -20,11 +24,16 @@
 #ifdef SINGLE_BOARD_MODE
 constexpr uint8_t NUM_BOARDS = 1;  // Single-board mode: 1 board, 3 DACs
 #else
-constexpr uint8_t NUM_BOARDS = 8;  // Multi-board mode: 8 boards, 24 DACs
-// TODO: in multi-board mode, we should detect NUM_BOARDS somehow from the hardware...
+constexpr uint8_t NUM_BOARDS = 8;  // Multi-board mode: up to 8 boards, 24 DACs
+// Slots actually fitted are probed by init_all() (BoardManager::fitted_boards())
 #endif
 constexpr uint8_t DACS_PER_BOARD = 3;
 
+// Broadcast targets (bit m = DAC m on every board)
+constexpr uint8_t DAC_MASK_CURRENT = 0x03;  // DAC 0 + DAC 1 (LTC2662)
+constexpr uint8_t DAC_MASK_VOLTAGE = 0x04;  // DAC 2 (LTC2664)
+constexpr uint8_t DAC_MASK_ALL = DAC_MASK_CURRENT | DAC_MASK_VOLTAGE;
+
 // Calibration constants
 constexpr uint8_t MAX_CHANNELS_PER_DAC = 5;  // LTC2662 has 5 channels (max)
 constexpr uint8_t SERIAL_NUMBER_MAX_LEN = 32;
@@ -37,6 +46,55 @@ struct ChannelCalibration {
     bool enabled = false;   // Whether calibration is applied
 };
 
+// Piecewise-linear calibration
+// A channel with a table uses it instead of gain/offset (while calibration
+// is enabled): setpoint input[i] is written as output[i], linear in
+// between and extrapolated from the end segments. Tables come from a pool
+// shared by all channels.
+constexpr uint8_t CAL_MAX_POINTS = SETPOINT::MAX_BREAKPOINTS;
+constexpr uint8_t CAL_MAX_TABLES = 32;
+
+// Longest CAL:DATA? reply: every board's serial, every channel's gain and
+// offset at their widest "%.6f" (47 characters for -FLT_MAX) and every table
+// full, its points at their widest "%.7g" (13 characters)
+constexpr size_t CAL_DATA_MAX_LENGTH =
+    NUM_BOARDS * (sizeof("BOARD0:SN=\n") - 1 + SERIAL_NUMBER_MAX_LEN - 1) +
+    NUM_BOARDS * (2 * LTC2662::NUM_CHANNELS + LTC2664::NUM_CHANNELS) *
+        (sizeof("  DAC0:CH0:G=,O=,E=0\n") - 1 + 2 * 47) +
+    CAL_MAX_TABLES * (sizeof("  DAC0:CH0:T=\n") - 1 + 2 * CAL_MAX_POINTS * 13 + 2 * CAL_MAX_POINTS - 1) +
+    1;  // NUL
+
+struct CalibrationTable {
+    uint8_t count = 0;              // Points in use, 0 = free
+    float input[CAL_MAX_POINTS];    // Requested setpoints, strictly increasing
+    float output[CAL_MAX_POINTS];   // Physical values to write for them
+};
+
+// Batched write (APPLY) configuration
+// One entry per channel across every board is the largest useful batch
+constexpr uint8_t NUM_DACS = NUM_BOARDS * DACS_PER_BOARD;
+constexpr uint16_t MAX_BATCH_ENTRIES = NUM_DACS * MAX_CHANNELS_PER_DAC;
+
+// Single channel write staged by APPLY
+struct BatchEntry {
+    uint8_t board;
+    uint8_t dac;
+    uint8_t channel;
+    uint16_t code;
+};
+
+// Output state of one chip, from the shadow registers (SNAP:SAVE/REST)
+// Packed: stored as is by StateStorage
+struct __attribute__((packed)) DacOutputState {
+    uint8_t resolution;                     // Codes only apply at this resolution
+    uint8_t span[MAX_CHANNELS_PER_DAC];     // Span code per channel
+    uint16_t code[MAX_CHANNELS_PER_DAC];    // DAC-register code per channel
+};
+
+struct __attribute__((packed)) OutputState {
+    DacOutputState dacs[NUM_BOARDS][DACS_PER_BOARD];
+};
+
 // Default DAC resolutions (can be overridden per-board)
 // Set to 12 for LTC2662-12/LTC2664-12, 16 for LTC2662-16/LTC2664-16
 constexpr uint8_t DEFAULT_CURRENT_DAC_RESOLUTION = 16;
@@ -47,12 +105,32 @@ class BoardManager {
 public:
     BoardManager(SpiManager& spi);
 
-    // Initialize all DACs on all boards
+    // Initialize all DACs on all boards and load the calibration; returns
+    // once the frames are on the wire. Runs on core 1 at boot, so the
+    // frames go through the DMA queue.
     void init_all();
 
+    // Core 1, once it takes commands: records the boot-to-ready time
+    void mark_ready();
+    uint64_t ready_us() const { return ready_us_; }
+    uint32_t init_us() const { return init_us_; }
+
+    // Boards found by init_all() (bit n = BOARD<n>). An empty slot has no DAC
+    // objects: get_dac() returns nullptr, so loops over the rack skip it and
+    // addressing it fails with DAC_NOT_INITIALIZED.
+    uint8_t fitted_boards() const { return fitted_boards_; }
+
+    // False if no board answered the probe and fitted_boards() fell back
+    // to every slot
+    bool probe_answered() const { return probe_answered_; }
+
+    // Whether the last init_all() found calibration data in flash
+    bool calibration_loaded() const { return calibration_loaded_; }
+
     // Execute a parsed SCPI command
-    // Returns response string (empty for commands, value for queries)
-    std::string execute(const ScpiCommand& cmd);
+    // Writes the reply ("OK", a query value or "ERROR:...") to out and
+    // returns ScpiError::NONE or the failure code
+    ScpiError execute(const ScpiCommand& cmd, ResponseBuffer& out);
 
     // Reset all DACs to power-on state
     void reset_all();
@@ -60,6 +138,28 @@ public:
     // Get DAC device by board/dac index
     DacDevice* get_dac(uint8_t board, uint8_t dac);
 
+    // Broadcast to every board's DACs in dac_mask with the all-channel opcodes:
+    // one frame per chip, then one LDAC (single-board: one update per chip)
+    void broadcast_code(uint8_t dac_mask, uint16_t code);
+    void broadcast_span(uint8_t dac_mask, uint8_t span_code);
+
+    // Spans and output codes of every channel, from the shadows (no SPI)
+    void capture_output_state(OutputState& state) const;
+
+    // Write a captured state back: per chip, the spans and codes (all-channel
+    // frames where the channels agree), then one LDAC for the whole rack.
+    // Checked in full first; fails with SNAP_MISMATCH if a chip's presence,
+    // resolution or a code does not fit, writing nothing.
+    ScpiError restore_output_state(const OutputState& state);
+
+    // Global LDAC pulse; every initialized DAC's shadow follows its input registers
+    // (no-op in single-board mode, which has no LDAC line)
+    void pulse_ldac();
+
+    // Write one channel and update its output, or, while the external
+    // trigger is armed, only load its input register
+    void write_channel(DacDevice* dac, uint8_t channel, uint16_t code);
+
     // Get the current DAC type (for SCPI routing)
     // Returns 0 for LTC2662 (current DAC), 1 for LTC2664 (voltage DAC)
     uint8_t get_dac_type(uint8_t board, uint8_t dac);
@@ -72,8 +172,8 @@ public:
     uint8_t get_resolution(uint8_t board, uint8_t dac);
 
     // Set/get board serial number
-    void set_serial_number(uint8_t board, const std::string& serial);
-    std::string get_serial_number(uint8_t board) const;
+    void set_serial_number(uint8_t board, const char* serial);
+    const char* get_serial_number(uint8_t board) const;
 
     // Set/get channel calibration gain
     void set_cal_gain(uint8_t board, uint8_t dac, uint8_t channel, float gain);
@@ -90,11 +190,44 @@ public:
     // Get calibration structure (for applying calibration in DAC methods)
     const ChannelCalibration* get_calibration(uint8_t board, uint8_t dac, uint8_t channel) const;
 
+    // Set a channel's calibration table (count 0 removes it)
+    // Returns INVALID_CAL_TABLE for bad points, CAL_TABLES_FULL if the pool is used up
+    ScpiError set_cal_table(uint8_t board, uint8_t dac, uint8_t channel,
+                            const float* input, const float* output, uint8_t count);
+
+    // Get a channel's calibration table, nullptr if it has none
+    const CalibrationTable* get_cal_table(uint8_t board, uint8_t dac, uint8_t channel) const;
+
     // Clear all calibration data
     void clear_all_calibration();
 
-    // Export all calibration data as a formatted string
-    std::string export_calibration_data() const;
+    // Export all calibration data as formatted text (at most
+    // CAL_DATA_MAX_LENGTH characters)
+    void export_calibration_data(ResponseBuffer& out) const;
+
+    // Skip DAC writes that repeat the shadowed code, on every DAC (off by default)
+    void set_write_elision(bool enable);
+    bool get_write_elision() const { return write_elision_; }
+
+    // Total writes skipped by elision across all DACs
+    uint32_t get_elided_writes() const;
+
+    // Waveform sequencer (timer-driven playback)
+    Sequencer& sequencer() { return sequencer_; }
+
+    // Cached fault state (IRQ on the FAULT line)
+    FaultMonitor& fault_monitor() { return faults_; }
+
+    // External trigger input (TRIG:ARM)
+    ExternalTrigger& external_trigger() { return trigger_; }
+
+    // From the trigger IRQ: commit the staged writes (commit, i.e. it was
+    // armed) and start a sequence armed with SEQ:TRIG:SOUR EXT
+    void on_external_trigger(bool commit);
+
+    // Write "!<FAULT? reply>" if the fault state changed since the last
+    // notice and FAULT:NOTIFY is on; core 1 sends it between replies
+    bool take_fault_notice(ResponseBuffer& out);
 
 private:
     SpiManager& spi_;
@@ -118,31 +251,110 @@ private:
     // Calibration data: [board][dac][channel]
     ChannelCalibration calibration_[NUM_BOARDS][DACS_PER_BOARD][MAX_CHANNELS_PER_DAC];
 
+    // Calibration tables: pool, and the entry each channel uses (-1: none)
+    CalibrationTable tables_[CAL_MAX_TABLES];
+    int8_t table_index_[NUM_BOARDS][DACS_PER_BOARD][MAX_CHANNELS_PER_DAC];
+
+    // Setpoint -> code transforms built from the above: [board][dac][channel]
+    // and one per table
+    SetpointTransform transforms_[NUM_BOARDS][DACS_PER_BOARD][MAX_CHANNELS_PER_DAC];
+    PiecewiseTransform table_transforms_[CAL_MAX_TABLES];
+
+    // Staging buffer for batched writes (APPLY)
+    BatchEntry batch_[MAX_BATCH_ENTRIES];
+
+    // On-device waveform playback
+    Sequencer sequencer_;
+
+    // FAULT line IRQ and cached fault mask
+    FaultMonitor faults_;
+
+    // Trigger input IRQ and arm state
+    ExternalTrigger trigger_;
+
+    // Write elision setting, reapplied whenever the DACs are set up
+    bool write_elision_ = false;
+
+    // Boot timing (SYST:BOOT?): time_us_64() when core 1 was ready, and how
+    // long the last init_all() took
+    uint64_t ready_us_ = 0;
+    uint32_t init_us_ = 0;
+
+    uint8_t fitted_boards_ = 0;
+    bool probe_answered_ = true;
+    bool calibration_loaded_ = false;
+
+    // Probe every slot's DACs (DacDevice::probe); a board is fitted if any
+    // of its chips answers. Falls back to all slots if none does.
+    uint8_t probe_boards();
+
+    // Convert a physical setpoint to a DAC code, applying calibration if enabled
+    // (rebuilds the channel's transform first if it is stale)
+    uint16_t calibrated_voltage_code(uint8_t board, uint8_t channel, float voltage);
+    uint16_t calibrated_current_code(uint8_t board, uint8_t dac, uint8_t channel, float current_ma);
+    uint16_t setpoint_code(uint8_t board, uint8_t dac, uint8_t channel, float value,
+                           uint8_t span, uint16_t max_code);
+
+    // Output range of a channel's current span (V or mA)
+    void output_range(uint8_t board, uint8_t dac, uint8_t channel, float& min, float& max) const;
+
+    // Broadcast halves: load every selected chip's registers, then latch
+    // them together (LDAC, or UPDATE_ALL per chip in single-board mode)
+    void stage_code(uint8_t dac_mask, uint16_t code);
+    void stage_span(uint8_t dac_mask, uint8_t span_code);
+    void commit_staged(uint8_t dac_mask);  // Left to the edge while TRIG:ARM is on
+
+    // Inverse of the above for readback: physical output -> requested setpoint
+    float uncalibrated_value(uint8_t board, uint8_t dac, uint8_t channel, float output) const;
+
+    // Write staged entries grouped by chip, then commit with a single update
+    void write_batch(const BatchEntry* entries, size_t count);
+
+    // Append one channel's VOLT?/CURR?/CODE? answer (address already validated)
+    void append_readback(ScpiCommandType type, uint8_t board, uint8_t dac, uint8_t channel,
+                         ResponseBuffer& out);
+
     // Execute specific command types
-    std::string execute_idn();
-    std::string execute_fault_query();
-    std::string execute_set_voltage(const ScpiCommand& cmd);
-    std::string execute_set_current(const ScpiCommand& cmd);
-    std::string execute_set_code(const ScpiCommand& cmd);
-    std::string execute_set_span(const ScpiCommand& cmd);
-    std::string execute_update(const ScpiCommand& cmd);
-    std::string execute_power_down(const ScpiCommand& cmd);
-    std::string execute_get_resolution(const ScpiCommand& cmd);
-    std::string execute_set_resolution(const ScpiCommand& cmd);
-    std::string execute_set_serial(const ScpiCommand& cmd);
-    std::string execute_get_serial(const ScpiCommand& cmd);
-    std::string execute_set_cal_gain(const ScpiCommand& cmd);
-    std::string execute_get_cal_gain(const ScpiCommand& cmd);
-    std::string execute_set_cal_offset(const ScpiCommand& cmd);
-    std::string execute_get_cal_offset(const ScpiCommand& cmd);
-    std::string execute_set_cal_enable(const ScpiCommand& cmd);
-    std::string execute_get_cal_enable(const ScpiCommand& cmd);
-    std::string execute_cal_data_query();
-    std::string execute_cal_clear();
-    std::string execute_cal_save();
-    std::string execute_cal_load();
-    std::string execute_dac_fault_query(const ScpiCommand& cmd);
-    std::string execute_dac_echo_query(const ScpiCommand& cmd);
+    ScpiError execute_idn(ResponseBuffer& out);
+    ScpiError execute_fault_query(const ScpiCommand& cmd, ResponseBuffer& out);
+    ScpiError execute_set_voltage(const ScpiCommand& cmd, ResponseBuffer& out);
+    ScpiError execute_set_current(const ScpiCommand& cmd, ResponseBuffer& out);
+    ScpiError execute_set_code(const ScpiCommand& cmd, ResponseBuffer& out);
+    ScpiError execute_get_voltage(const ScpiCommand& cmd, ResponseBuffer& out);
+    ScpiError execute_get_current(const ScpiCommand& cmd, ResponseBuffer& out);
+    ScpiError execute_get_code(const ScpiCommand& cmd, ResponseBuffer& out);
+    ScpiError execute_set_all_code(const ScpiCommand& cmd, ResponseBuffer& out);
+    ScpiError execute_set_span(const ScpiCommand& cmd, ResponseBuffer& out);
+    ScpiError execute_broadcast(const ScpiCommand& cmd, ResponseBuffer& out);
+    ScpiError execute_update(const ScpiCommand& cmd, ResponseBuffer& out);
+    ScpiError execute_power_down(const ScpiCommand& cmd, ResponseBuffer& out);
+    ScpiError execute_get_resolution(const ScpiCommand& cmd, ResponseBuffer& out);
+    ScpiError execute_set_resolution(const ScpiCommand& cmd, ResponseBuffer& out);
+    ScpiError execute_set_serial(const ScpiCommand& cmd, ResponseBuffer& out);
+    ScpiError execute_get_serial(const ScpiCommand& cmd, ResponseBuffer& out);
+    ScpiError execute_set_cal_gain(const ScpiCommand& cmd, ResponseBuffer& out);
+    ScpiError execute_get_cal_gain(const ScpiCommand& cmd, ResponseBuffer& out);
+    ScpiError execute_set_cal_offset(const ScpiCommand& cmd, ResponseBuffer& out);
+    ScpiError execute_get_cal_offset(const ScpiCommand& cmd, ResponseBuffer& out);
+    ScpiError execute_set_cal_enable(const ScpiCommand& cmd, ResponseBuffer& out);
+    ScpiError execute_get_cal_enable(const ScpiCommand& cmd, ResponseBuffer& out);
+    ScpiError execute_set_cal_table(const ScpiCommand& cmd, ResponseBuffer& out);
+    ScpiError execute_get_cal_table(const ScpiCommand& cmd, ResponseBuffer& out);
+    ScpiError execute_cal_data_query(ResponseBuffer& out);
+    ScpiError execute_cal_image_query(const ScpiCommand& cmd, ResponseBuffer& out);
+    ScpiError execute_cal_image(const ScpiCommand& cmd, ResponseBuffer& out);
+    ScpiError execute_cal_clear(ResponseBuffer& out);
+    ScpiError execute_cal_save(ResponseBuffer& out);
+    ScpiError execute_cal_load(ResponseBuffer& out);
+    ScpiError execute_snapshot(const ScpiCommand& cmd, ResponseBuffer& out);
+    ScpiError execute_dac_fault_query(const ScpiCommand& cmd, ResponseBuffer& out);
+    ScpiError execute_dac_echo_query(const ScpiCommand& cmd, ResponseBuffer& out);
+    ScpiError execute_apply(const ScpiCommand& cmd, ResponseBuffer& out);
+    ScpiError execute_range(const ScpiCommand& cmd, ResponseBuffer& out);
+    ScpiError execute_seq_data(const ScpiCommand& cmd, ResponseBuffer& out);
+    ScpiError execute_seq(const ScpiCommand& cmd, ResponseBuffer& out);
+    ScpiError execute_write_elision(const ScpiCommand& cmd, ResponseBuffer& out);
+    ScpiError execute_trigger(const ScpiCommand& cmd, ResponseBuffer& out);
 };
 
 #endif // BOARD_MANAGER_HPP
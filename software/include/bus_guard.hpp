@@ -0,0 +1,27 @@
+#ifndef BUS_GUARD_HPP
+#define BUS_GUARD_HPP
+
+#include <cstdint>
+#include "hardware/sync.h"
+#include "spi_dma.hpp"
+
+// Scoped interrupt mask around one blocking SPI bus access
+// The sequencer issues DAC frames from a timer IRQ. Masking interrupts for
+// the few microseconds of a transaction keeps an IRQ-driven frame from
+// landing between the select, transfer and deselect of a main-loop one.
+// Queued DMA frames are allowed to drain first, so a blocking access never
+// overlaps the DMA engine. Never enqueue DMA frames while holding a guard.
+// Nesting is safe (the IRQ handler's own guards restore the masked state).
+class BusGuard {
+public:
+    BusGuard() : saved_(SpiDma::acquire_idle()) {}
+    ~BusGuard() { restore_interrupts(saved_); }
+
+    BusGuard(const BusGuard&) = delete;
+    BusGuard& operator=(const BusGuard&) = delete;
+
+private:
+    uint32_t saved_;
+};
+
+#endif // BUS_GUARD_HPP
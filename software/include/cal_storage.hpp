@@ -5,7 +5,15 @@
 #include "board_manager.hpp"
 
 // Flash storage for calibration data on RP2350
-// Uses the last 4KB sector of 2MB flash to avoid program code
+// Uses the last CAL_LOG_SECTORS 4KB sectors of 2MB flash to avoid program code
+//
+// The sectors hold a log in blocks of CAL_BLOCK_SECTORS: each block starts
+// with a header and a snapshot of every non-default channel and table,
+// followed by records for the channels changed by each later CAL:SAVE. A save
+// only programs the pages its records touch; once the current block is full,
+// the next one in turn is erased and takes a fresh snapshot (compaction). On
+// load, the valid block with the highest sequence number is replayed, later
+// records overriding earlier ones.
 
 namespace CalStorage {
 
@@ -14,16 +22,87 @@ constexpr uint32_t FLASH_SIZE = 2 * 1024 * 1024;        // 2MB flash
 constexpr uint32_t FLASH_SECTOR_SIZE = 4096;            // 4KB erase sector
 constexpr uint32_t FLASH_PAGE_SIZE = 256;               // 256-byte write page
 
-// Use the last sector for calibration storage
+// Log region: the last sectors of flash, used a block at a time in turn
 // This leaves plenty of room for program code
-constexpr uint32_t CAL_FLASH_OFFSET = FLASH_SIZE - FLASH_SECTOR_SIZE;  // 0x1FF000
+constexpr uint32_t CAL_LOG_SECTORS = 8;
+constexpr uint32_t CAL_BLOCK_SECTORS = 2;
+constexpr uint32_t CAL_BLOCK_SIZE = CAL_BLOCK_SECTORS * FLASH_SECTOR_SIZE;
+constexpr uint32_t CAL_LOG_BLOCKS = CAL_LOG_SECTORS / CAL_BLOCK_SECTORS;
+constexpr uint32_t CAL_FLASH_OFFSET = FLASH_SIZE - CAL_LOG_SECTORS * FLASH_SECTOR_SIZE;  // 0x1F8000
+
+// Magic number to identify a calibration log block
+constexpr uint32_t CAL_MAGIC = 0x47524D4C;  // "GRML" (greymatter Calibration Log)
+constexpr uint16_t CAL_VERSION = 4;         // 8KB blocks, table records
+
+// Log block header, programmed after the block's snapshot so a block whose
+// compaction was interrupted is never picked
+struct __attribute__((packed)) CalLogHeader {
+    uint32_t magic;              // Magic number for validation
+    uint16_t version;            // Data format version
+    uint16_t reserved;           // 0xFFFF
+    uint32_t sequence;           // Incremented by every compaction; newest block wins
+    uint32_t checksum;           // CRC-32 of sequence
+};
+
+// Record types; erased flash (0xFF) marks the end of a block's log
+enum class CalRecordType : uint8_t {
+    CHANNEL = 0x01,              // CalChannelRecord
+    SERIAL  = 0x02,              // CalSerialRecord
+    TABLE   = 0x03,              // CalTableRecord
+    FREE    = 0xFF,
+};
+
+// Every record starts with this and is padded to CAL_RECORD_ALIGN bytes.
+// Unknown types with a good checksum are skipped.
+struct __attribute__((packed)) CalRecordHeader {
+    uint8_t type;                // CalRecordType
+    uint8_t reserved;            // 0xFF
+    uint16_t length;             // Payload bytes following the header
+    uint32_t checksum;           // CRC-32 of type, length and payload
+};
+constexpr uint32_t CAL_RECORD_ALIGN = 4;
+
+struct __attribute__((packed)) CalChannelRecord {
+    uint8_t board;
+    uint8_t dac;
+    uint8_t channel;
+    uint8_t enabled;
+    float gain;
+    float offset;
+};
+
+struct __attribute__((packed)) CalSerialRecord {
+    uint8_t board;
+    char serial_number[SERIAL_NUMBER_MAX_LEN];
+};
 
-// Magic number to identify valid calibration data
-constexpr uint32_t CAL_MAGIC = 0x47524D43;  // "GRMC" (greymatter Calibration)
-constexpr uint16_t CAL_VERSION = 1;
+// Followed by count (input, output) float pairs; count 0 removes the table
+struct __attribute__((packed)) CalTableRecord {
+    uint8_t board;
+    uint8_t dac;
+    uint8_t channel;
+    uint8_t count;
+};
+constexpr uint32_t CAL_TABLE_PAYLOAD_MAX = sizeof(CalTableRecord) + CAL_MAX_POINTS * 2 * sizeof(float);
+
+constexpr uint32_t record_size(uint32_t payload) {
+    return (sizeof(CalRecordHeader) + payload + CAL_RECORD_ALIGN - 1) & ~(CAL_RECORD_ALIGN - 1);
+}
+
+// A snapshot of every channel, table and serial number must fit in one block
+static_assert(sizeof(CalLogHeader) +
+                  NUM_BOARDS * DACS_PER_BOARD * MAX_CHANNELS_PER_DAC *
+                      record_size(sizeof(CalChannelRecord)) +
+                  CAL_MAX_TABLES * record_size(CAL_TABLE_PAYLOAD_MAX) +
+                  NUM_BOARDS * record_size(sizeof(CalSerialRecord)) <= CAL_BLOCK_SIZE,
+              "Calibration snapshot exceeds log block size");
+
+// Version 1 layout: a single image in the last sector, rewritten by every
+// save. Still loaded when no log exists; the next save converts it.
+constexpr uint32_t CAL_LEGACY_OFFSET = FLASH_SIZE - FLASH_SECTOR_SIZE;  // 0x1FF000
+constexpr uint32_t CAL_LEGACY_MAGIC = 0x47524D43;  // "GRMC" (greymatter Calibration)
+constexpr uint16_t CAL_LEGACY_VERSION = 1;
 
-// Calibration data structure stored in flash
-// Total size must fit in one sector (4KB)
 struct __attribute__((packed)) FlashCalibrationData {
     // Header (8 bytes)
     uint32_t magic;              // Magic number for validation
@@ -47,25 +126,54 @@ struct __attribute__((packed)) FlashCalibrationData {
     uint8_t reserved[256];
 };
 
-// Verify structure fits in one sector
-static_assert(sizeof(FlashCalibrationData) <= FLASH_SECTOR_SIZE,
-              "Calibration data exceeds flash sector size");
+// The same image is the bulk transfer format of CAL:IMAGe, which moves it
+// in base64 chunks of up to CAL_IMAGE_CHUNK bytes
+constexpr uint16_t CAL_IMAGE_SIZE = sizeof(FlashCalibrationData);
+constexpr uint16_t CAL_IMAGE_CHUNK = 1024;
+
+// Flash access, shared with the other flash-backed stores (StateStorage)
+// Pointer to flash at offset from the start of flash (XIP mapped)
+const uint8_t* flash_ptr(uint32_t offset);
+
+// True if length bytes at offset are erased (0xFF)
+bool is_blank(uint32_t offset, size_t length);
+
+// Program bytes at any offset (already erased), then verify them
+bool program(uint32_t offset, const uint8_t* data, size_t length);
 
-// Calculate CRC-16 (CCITT) for data integrity
+// Erase the sectors from offset that are not blank
+void erase_range(uint32_t offset, uint32_t sectors);
+
+// Calculate CRC-16 (CCITT) for data integrity (version 1 data)
 uint16_t calculate_crc16(const uint8_t* data, size_t length);
 
+// Calculate CRC-32 for data integrity
+uint32_t calculate_crc32(const uint8_t* data, size_t length);
+
 // Save calibration data to flash
-// Returns true on success
+// Only channels and serial numbers that differ from the stored data are
+// written. Returns true on success.
 bool save_to_flash(const BoardManager& manager);
 
 // Load calibration data from flash
-// Returns true if valid data was found and loaded
+// Returns true if valid data was found and loaded. Runs on core 1 (boot,
+// CAL:LOAD, *RST), so it reports nothing itself: the caller's reply or
+// the BootReport does.
 bool load_from_flash(BoardManager& manager);
 
+// Fill an image with the manager's gains, offsets, enables and serial
+// numbers (tables are not part of it)
+void build_image(const BoardManager& manager, FlashCalibrationData& image);
+
+// Check an image's magic, version and checksum, then copy it into the
+// manager (RAM only; CAL:SAVE stores it). Returns false, changing nothing,
+// if the image is invalid.
+bool apply_image(BoardManager& manager, const FlashCalibrationData& image);
+
 // Check if valid calibration data exists in flash
 bool has_valid_data();
 
-// Erase calibration data from flash
+// Erase calibration data from flash (every log sector that is not blank)
 void erase_flash();
 
 }  // namespace CalStorage
@@ -0,0 +1,130 @@
+#ifndef CORE_LINK_HPP
+#define CORE_LINK_HPP
+
+#include <cstdint>
+#include <cstddef>
+
+#include "scpi_parser.hpp"
+#include "spsc_queue.hpp"
+
+class BoardManager;
+class SpiManager;
+class BinaryProtocol;
+
+// Inter-core link configuration
+namespace CORE_LINK {
+    constexpr size_t QUEUE_DEPTH = 8;        // Parsed commands in flight (core 0 -> core 1)
+    constexpr size_t BYTE_RING_SIZE = 512;   // Binary-mode bytes, each direction
+    constexpr size_t TEXT_RING_SIZE = 2048;  // Reply text streaming back to core 0
+
+    // Core 1's reply buffer; CAL:DATA? (every channel's calibration and
+    // table) is the longest reply, at most CAL_DATA_MAX_LENGTH (about 27KB
+    // with all eight boards; checked in core_link.cpp)
+    constexpr size_t RESPONSE_SIZE = 28 * 1024;
+
+    // Core 1 runs BoardManager::execute (and CAL:SAVE's sector image), far
+    // more than the SDK's default 2KB core 1 stack
+    constexpr size_t CORE1_STACK_BYTES = 16 * 1024;
+
+    // Timers in core 1's own alarm pool (sequencer timer, deferred fault capture)
+    constexpr uint32_t CORE1_MAX_TIMERS = 4;
+}
+
+// What core 1 sends back for each executed command
+// Every event is preceded by its reply text in the text ring (possibly empty)
+enum class LinkEvent : uint8_t {
+    REPLY,         // Response text printed; print a prompt
+    REPLY_PART,    // Response to a ';'-chained command with more to follow; print ';'
+    ENTER_BINARY,  // SYST:BIN executed; no prompt, forward raw bytes
+    EXIT_BINARY,   // EXIT frame answered; print a prompt, back to SCPI lines
+    NOTICE         // Unsolicited line (FAULT:NOTIFY), not the reply to any command
+};
+
+// Startup summary from core 1, printed in core 0's banner
+struct BootReport {
+    uint64_t ready_us;   // time_us_64() when core 1 started taking commands
+    uint32_t init_us;    // BoardManager::init_all(), bus traffic included
+    uint8_t boards;      // Boards fitted (bit n = BOARD<n>)
+    bool probed;         // False if no board answered and all slots are assumed
+    bool calibration;    // Calibration data loaded from flash
+    bool fault_active;   // FAULT line at the first capture
+    uint32_t fault_mask; // Faulted DACs (0 in single-board mode)
+    const char* snapshot; // Power-up snapshot (SNAP:BOOT), or nullptr if none is set
+    ScpiError snapshot_error; // Why the snapshot was not restored, or NONE
+};
+
+// Splits the firmware across the two cores
+//
+// Core 0 owns USB: it reads lines, echoes, parses and prints replies.
+// Core 1 owns the SPI bus: it drains parsed commands, runs
+// BoardManager::execute and streams the response text back. Commands are
+// parsed straight into their queue slot and executed from it, and replies
+// are NUL-terminated records in a byte ring, so nothing is copied or
+// allocated per command beyond the reply characters. In binary mode
+// core 0 forwards raw bytes and core 1 runs the frame decoder, returning
+// reply bytes through a second ring. Everything is single-producer /
+// single-consumer, so no locks are taken on the command path.
+//
+// The multicore FIFO is left alone: the SDK's flash lockout uses it.
+class CoreLink {
+public:
+    CoreLink(BoardManager& boards, SpiManager& spi, BinaryProtocol& binary);
+
+    // Start core 1. After this, only core 1 may touch SpiManager/BoardManager.
+    // Core 1 initializes the DACs itself, so the caller need not wait for
+    // USB first.
+    void launch();
+
+    // ---- Core 0 side ----
+
+    // Next free command slot to parse into, or nullptr if QUEUE_DEPTH commands
+    // are already in flight. submit() hands the claimed slot to core 1.
+    ScpiCommand* claim();
+    void submit();
+    bool can_submit() const { return outstanding_ < CORE_LINK::QUEUE_DEPTH; }
+
+    // Commands submitted whose REPLY/REPLY_PART/ENTER_BINARY has not been polled yet
+    size_t outstanding() const { return outstanding_; }
+
+    // Pass reply text to out as it arrives; returns true with the event once
+    // a whole reply has been written
+    bool poll(LinkEvent& event, void (*out)(char));
+
+    // Null until core 1 has initialized the DACs and is taking commands
+    const BootReport* boot_report() const;
+
+    // Binary mode byte pipes. Call forwarded() after a batch of
+    // forward_byte() calls to wake core 1.
+    bool forward_byte(uint8_t byte) { return rx_bytes_.push(byte); }
+    void forwarded();
+    bool rx_space() const { return !rx_bytes_.full(); }
+    bool output_byte(uint8_t& byte) { return tx_bytes_.pop(byte); }
+
+private:
+    BoardManager& boards_;
+    SpiManager& spi_;
+    BinaryProtocol& binary_;
+
+    SpscQueue<ScpiCommand, CORE_LINK::QUEUE_DEPTH> requests_;
+    SpscQueue<LinkEvent, CORE_LINK::QUEUE_DEPTH> replies_;
+    SpscQueue<char, CORE_LINK::TEXT_RING_SIZE> text_;
+    SpscQueue<uint8_t, CORE_LINK::BYTE_RING_SIZE> rx_bytes_;
+    SpscQueue<uint8_t, CORE_LINK::BYTE_RING_SIZE> tx_bytes_;
+
+    size_t outstanding_ = 0;    // Core 0 only
+    bool text_done_ = false;    // Core 0 only; current reply's NUL has been read
+    bool binary_mode_ = false;  // Core 1 only
+    bool mid_line_ = false;     // Core 1 only; REPLY_PART posted, line not finished
+
+    BootReport boot_report_{};  // Written by core 1 before ready_ is set
+    volatile bool ready_ = false;
+
+    static CoreLink* instance_;
+
+    static void core1_entry();
+    void run();                           // Core 1 main loop, never returns
+    void post(LinkEvent event, const char* text);
+    static void binary_output(uint8_t byte);
+};
+
+#endif // CORE_LINK_HPP
@@ -41,6 +41,12 @@ public:
     // Write code and immediately update the channel output
     virtual void write_and_update(uint8_t channel, uint16_t code) = 0;
 
+    // Write the same code to every channel's input register in one frame
+    virtual void write_code_all(uint16_t code) = 0;
+
+    // Write the same code to every channel and update all outputs in one frame
+    virtual void write_and_update_all(uint16_t code) = 0;
+
     // Update channel from input register to DAC register
     virtual void update_channel(uint8_t channel) = 0;
 
@@ -71,6 +77,35 @@ public:
     // Get the maximum code value (4095 for 12-bit, 65535 for 16-bit)
     virtual uint16_t get_max_code() const = 0;
 
+    // Whether span_code is one the chip defines
+    virtual bool is_valid_span(int32_t span_code) const = 0;
+
+    // Shadow registers: last code written to each channel's input register and
+    // the code latched into its DAC register (what the output is driving).
+    // Maintained by the write/update methods above; reading them costs no SPI.
+    virtual uint16_t get_input_code(uint8_t channel) const = 0;
+    virtual uint16_t get_dac_code(uint8_t channel) const = 0;
+
+    // Mirror a hardware LDAC pulse: copy every input shadow into the DAC shadow
+    // (no SPI traffic; call after SpiManager::pulse_ldac())
+    virtual void latch_inputs() = 0;
+
+    // Write elision (off by default): write_code/write_and_update skip the SPI
+    // frame when the shadow shows the register already holds that code. A
+    // channel not written since setup() is never elided, and a span change or
+    // power-down forces the next write_and_update through. The
+    // all-channel writes are never elided (init relies on them reaching the chip).
+    void set_write_elision(bool enable) { elide_writes_ = enable; }
+    bool get_write_elision() const { return elide_writes_; }
+
+    // Writes skipped by elision since boot
+    uint32_t get_elided_writes() const { return elided_writes_; }
+
+    // Check that the chip is fitted: clock a NOP carrying a marker, then
+    // look for it in the echo of the next frame. An empty slot returns
+    // whatever the idle MISO line reads (pull-up or floating).
+    bool probe();
+
 protected:
     // Low-level 24-bit SPI command
     void send_command(uint8_t command, uint8_t address, uint16_t data);
@@ -85,6 +120,9 @@ protected:
     SpiManager* spi_ = nullptr;
     uint8_t board_id_ = 0;
     uint8_t device_id_ = 0;
+
+    bool elide_writes_ = false;
+    uint32_t elided_writes_ = 0;
 };
 
 #endif // DAC_DEVICE_HPP
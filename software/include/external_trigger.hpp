@@ -0,0 +1,58 @@
+#ifndef EXTERNAL_TRIGGER_HPP
+#define EXTERNAL_TRIGGER_HPP
+
+#include <cstdint>
+#include "pico/stdlib.h"
+
+class BoardManager;
+
+// External trigger configuration
+namespace EXT_TRIGGER {
+    // Trigger input, rising edge, pulled down (TRIGGER_PIN CMake variable).
+    // GP14 is unused in both multi-board and single-board mode.
+#ifdef TRIGGER_PIN
+    constexpr uint PIN = TRIGGER_PIN;
+#else
+    constexpr uint PIN = 14;
+#endif
+}
+
+// Hardware-timed commit on an external edge (TRIG:ARM, SEQ:TRIG:SOUR EXT)
+//
+// While armed, the single-channel writes only load input registers and the
+// batched commands skip their LDAC, so setpoints are staged without changing
+// any output. The next rising edge disarms and commits them all (LDAC in
+// multi-board mode, UPDATE_ALL per chip in single-board mode) from the IRQ,
+// no host or USB timing involved: Picos sharing one trigger line update
+// within microseconds of each other. The same edge starts a sequence armed
+// with SEQ:TRIG:SOUR EXT. An edge that finds nothing armed is only counted.
+//
+// Core 1 only: the IRQ drives the bus, so it runs on the bus owner.
+class ExternalTrigger {
+public:
+    explicit ExternalTrigger(BoardManager& boards) : boards_(boards) {}
+
+    // Configure the pin and enable its IRQ on the calling core
+    void start();
+
+    // Arm (stage writes until the next edge) or disarm, leaving whatever is
+    // staged for LDAC/UPDATE:ALL
+    void set_armed(bool armed) { armed_ = armed; }
+    bool armed() const { return armed_; }
+
+    // Rising edges seen since start()
+    uint32_t edges() const { return edges_; }
+
+private:
+    BoardManager& boards_;
+
+    // Written by the IRQ
+    volatile bool armed_ = false;
+    volatile uint32_t edges_ = 0;
+
+    static ExternalTrigger* instance_;
+
+    static void irq_handler();
+};
+
+#endif // EXTERNAL_TRIGGER_HPP
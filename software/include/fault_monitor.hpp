@@ -0,0 +1,100 @@
+#ifndef FAULT_MONITOR_HPP
+#define FAULT_MONITOR_HPP
+
+#include <cstdint>
+#include "pico/stdlib.h"
+
+class SpiManager;
+
+// Fault monitor configuration
+namespace FAULT_MONITOR {
+    // Edges closer together than this share one capture, taken by a
+    // one-shot alarm once the interval is up; bounds the SPI traffic of a
+    // chattering fault line
+    constexpr uint32_t MIN_CAPTURE_INTERVAL_US = 1000;
+
+    // While the line stays asserted a second DAC can fault without a new
+    // edge, so refresh() re-reads the expanders once the capture is this old
+    constexpr uint32_t REFRESH_INTERVAL_US = 10000;
+}
+
+// Snapshot of the cached fault state
+struct FaultState {
+    bool active;          // FAULT line asserted at the last capture
+    uint32_t mask;        // Bit N = fault on DAC index N (board * 3 + device); 0 in single-board mode
+    uint64_t changed_us;  // time_us_64() when active/mask last changed
+    uint32_t edges;       // FAULT line edges seen since start()
+};
+
+// Interrupt-driven fault state
+//
+// The fault expanders compare every input against DEFVAL and hold
+// HW_PINS::FAULT low while any input differs (IOCON_MIRROR joins INTA and
+// INTB). An IRQ on both edges of that pin reads INTCAP and GPIO into a
+// cached mask, so FAULT? is answered from RAM and the bus is only used when
+// the fault state changes. In single-board mode the pin (NAND of the three
+// DAC faults) is all there is, and only `active` is cached.
+//
+// Core 1 only: the IRQ reads the expanders, so it runs on the bus owner.
+class FaultMonitor {
+public:
+    explicit FaultMonitor(SpiManager& spi) : spi_(spi) {}
+
+    // Alarm pool for deferred captures; nullptr uses the SDK default pool.
+    // The alarm reads the expanders, so the pool must belong to this core.
+    void set_alarm_pool(alarm_pool_t* pool) { alarm_pool_ = pool; }
+
+    // Take a first capture and enable the FAULT IRQ on the calling core
+    void start();
+
+    // Take a deferred capture the alarm could not be scheduled for, or
+    // re-read a fault that is still asserted once it is REFRESH_INTERVAL_US
+    // old. Only reads the pin otherwise.
+    void refresh();
+
+    FaultState state() const;
+
+    // Restrict the mask to the DACs fitted (bit N = DAC index N) and stop
+    // the expanders comparing the other inputs (BoardManager::init_all())
+    void set_fitted(uint32_t dac_mask);
+
+    // Unsolicited notifications (FAULT:NOTIFY, off by default)
+    void set_notify(bool enable);
+    bool notify() const { return notify_; }
+
+    // True once for every change of the cached state while notifications
+    // are on, with the state to report
+    bool take_notice(FaultState& state);
+
+private:
+    SpiManager& spi_;
+    alarm_pool_t* alarm_pool_ = nullptr;
+    bool started_ = false;
+    bool notify_ = false;
+    uint32_t fitted_ = 0xFFFFFFFF;
+
+    // Written by the IRQ
+    volatile bool active_ = false;
+    volatile uint32_t mask_ = 0;
+    volatile uint32_t edges_ = 0;
+    volatile bool pending_ = false;  // An edge arrived too soon after a capture
+    uint64_t changed_us_ = 0;
+    uint64_t captured_us_ = 0;
+
+    // Last state handed out by take_notice()
+    bool noticed_active_ = false;
+    uint32_t noticed_mask_ = 0;
+
+    static FaultMonitor* instance_;
+
+    static void irq_handler();
+
+    // One-shot alarm taking the capture deferred by irq_handler()
+    static int64_t deferred_capture(alarm_id_t id, void* user_data);
+
+    // Read the line (and, when asserted, the expanders) into the cache
+    // Call from the IRQ or with a BusGuard held.
+    void capture(uint64_t now);
+};
+
+#endif // FAULT_MONITOR_HPP
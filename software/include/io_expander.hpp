@@ -1,7 +1,9 @@
 #ifndef IO_EXPANDER_HPP
 #define IO_EXPANDER_HPP
 
+#include <array>
 #include <cstdint>
+#include <cstddef>
 #include "hardware/spi.h"
 #include "pico/stdlib.h"
 
@@ -133,6 +135,71 @@ namespace SIGNAL_MAP {
     constexpr uint8_t TEMP_EXPANDER = 2;
 }
 
+// Expander pin layouts as lookup tables, built at compile time
+namespace EXPANDER_LUT {
+    // CTRL_EXPANDER Port A value for each 5-bit decoder address
+    // (DAC index board_id * 3 + device_id), with D_EN asserted
+    // Hardware wiring: CS4→pin0, CS3→pin1, CS2→pin2, CS1→pin3, CS0→pin4,
+    // so the address is bit-reversed into the port
+    constexpr std::array<uint8_t, 32> build_select() {
+        std::array<uint8_t, 32> table{};
+        for (uint8_t index = 0; index < 32; index++) {
+            uint8_t value = 1 << SIGNAL_MAP::D_EN_BIT;
+            value |= ((index >> 0) & 1) << SIGNAL_MAP::CS0_BIT;
+            value |= ((index >> 1) & 1) << SIGNAL_MAP::CS1_BIT;
+            value |= ((index >> 2) & 1) << SIGNAL_MAP::CS2_BIT;
+            value |= ((index >> 3) & 1) << SIGNAL_MAP::CS3_BIT;
+            value |= ((index >> 4) & 1) << SIGNAL_MAP::CS4_BIT;
+            table[index] = value;
+        }
+        return table;
+    }
+    inline constexpr std::array<uint8_t, 32> SELECT = build_select();
+
+    // One nibble of FAULT_EXPANDER (two boards' LTC2662 faults, pins
+    // FAULT_x1, FAULT_x2, FAULT_y1, FAULT_y2, active-high) -> DAC index
+    // bits 0, 1, 3, 4 relative to the first board's DAC 0
+    constexpr std::array<uint8_t, 16> build_current_faults() {
+        std::array<uint8_t, 16> table{};
+        for (uint8_t nibble = 0; nibble < 16; nibble++) {
+            table[nibble] = static_cast<uint8_t>((nibble & 0x3) | ((nibble & 0xC) << 1));
+        }
+        return table;
+    }
+    inline constexpr std::array<uint8_t, 16> CURRENT_FAULTS = build_current_faults();
+
+    // One nibble of TEMP_EXPANDER Port A (four boards' LTC2664 temperature
+    // faults, active-high) -> DAC index bits 2, 5, 8, 11
+    constexpr std::array<uint16_t, 16> build_temp_faults() {
+        std::array<uint16_t, 16> table{};
+        for (uint8_t nibble = 0; nibble < 16; nibble++) {
+            for (uint8_t board = 0; board < 4; board++) {
+                if (nibble & (1 << board)) table[nibble] |= 1u << (board * 3 + 2);
+            }
+        }
+        return table;
+    }
+    inline constexpr std::array<uint16_t, 16> TEMP_FAULTS = build_temp_faults();
+
+    // 24-bit fault mask in DAC index order from the (inverted) fault inputs:
+    // current = FAULT_EXPANDER Port B:Port A, temp = TEMP_EXPANDER Port A
+    constexpr uint32_t remap_faults(uint16_t current, uint8_t temp) {
+        return static_cast<uint32_t>(CURRENT_FAULTS[current & 0xF]) |
+               static_cast<uint32_t>(CURRENT_FAULTS[(current >> 4) & 0xF]) << 6 |
+               static_cast<uint32_t>(CURRENT_FAULTS[(current >> 8) & 0xF]) << 12 |
+               static_cast<uint32_t>(CURRENT_FAULTS[(current >> 12) & 0xF]) << 18 |
+               static_cast<uint32_t>(TEMP_FAULTS[temp & 0xF]) |
+               static_cast<uint32_t>(TEMP_FAULTS[temp >> 4]) << 12;
+    }
+
+    static_assert(SELECT[0] == 0x20 && SELECT[1] == 0x30 && SELECT[16] == 0x21 && SELECT[23] == 0x3D,
+                  "CS bits are reversed onto Port A pins 4..0");
+    static_assert(remap_faults(0x0001, 0) == 1u << 0 && remap_faults(0x0004, 0) == 1u << 3 &&
+                  remap_faults(0x8000, 0) == 1u << 22 && remap_faults(0, 0x01) == 1u << 2 &&
+                  remap_faults(0, 0x80) == 1u << 23 && remap_faults(0xFFFF, 0xFF) == 0xFFFFFF,
+                  "Fault bits land on board_id * 3 + device_id");
+}
+
 // Handles MCP23S17 IO expanders for chip select routing and fault monitoring
 class IoExpander {
 public:
@@ -142,11 +209,22 @@ public:
 
     // Set the 5-bit DAC select address and enable decoder tree
     // board_id: 0-7, device_id: 0-2 (2x LTC2662 + 1x LTC2664 per board)
+    // Always writes Port A: every frame ends with a deselect, so D_EN is
+    // never still asserted when the next one selects.
     void set_dac_select(uint8_t board_id, uint8_t device_id);
 
     // Disable the decoder tree (deselect all DACs)
+    // The falling edge of D_EN latches the DAC frame, so this always writes.
     void deselect_dac();
 
+    // Frame builders for the DMA queue (SpiDma)
+    // Each fills a 3-byte register write for CTRL_EXPANDER (clocked with
+    // HW_PINS::SPI_CS low) and updates the latch cache as if it had been
+    // sent.
+    void prepare_select(uint8_t board_id, uint8_t device_id, uint8_t frame[3]);
+    void prepare_deselect(uint8_t frame[3]);
+    void prepare_ldac(uint8_t low_frame[3], uint8_t high_frame[3]) const;
+
     // Pulse LDAC low to update all DAC outputs
     void pulse_ldac();
 
@@ -158,6 +236,14 @@ public:
     // Returns 24-bit mask where bit N = fault on DAC N (active = fault present)
     uint32_t read_faults();
 
+    // Fault inputs as latched in INTCAP when the expanders last raised their
+    // interrupt (same layout as read_faults())
+    uint32_t read_fault_capture();
+
+    // Only compare the fault inputs of DACs in dac_mask (bit N = DAC index
+    // N), so empty slots cannot pull the FAULT line; all are on after init()
+    void enable_fault_inputs(uint32_t dac_mask);
+
     // Clear any pending interrupt flags by reading INTCAP registers
     void clear_interrupts();
 
@@ -165,6 +251,13 @@ public:
     void write_register(uint8_t hw_addr, uint8_t reg, uint8_t value);
     uint8_t read_register(uint8_t hw_addr, uint8_t reg);
 
+    // Write an A/B register pair in one sequential transaction
+    // reg_a must be the Port A register (BANK=0 places Port B at reg_a + 1)
+    void write_register_pair(uint8_t hw_addr, uint8_t reg_a, uint8_t value_a, uint8_t value_b);
+
+    // Read an A/B register pair in one sequential transaction (Port A in the low byte)
+    uint16_t read_register_pair(uint8_t hw_addr, uint8_t reg_a);
+
     // Write 16-bit value to both ports (GPIOA + GPIOB)
     void write_gpio16(uint8_t hw_addr, uint16_t value);
     uint16_t read_gpio16(uint8_t hw_addr);
@@ -175,6 +268,20 @@ private:
     // Cached output latch values for read-modify-write operations
     uint16_t expander_cache_[EXPANDER_ADDR::NUM_EXPANDERS] = {0, 0, 0};
 
+    // Port A value selecting a DAC with D_EN asserted
+    static uint8_t select_value(uint8_t board_id, uint8_t device_id) {
+        return EXPANDER_LUT::SELECT[(board_id * 3 + device_id) & 0x1F];
+    }
+
+    // Fault inputs from registers starting at reg_a (GPIOA or INTCAPA)
+    uint32_t read_fault_inputs(uint8_t reg_a);
+
+    // Build a Port A write for the control expander and update the cache
+    void prepare_ctrl_port_a(uint8_t port_a_value, uint8_t frame[3]);
+
+    // Clock one pre-built register write with the expander CS asserted
+    void write_frame(const uint8_t* frame, size_t len);
+
     // Assert/release CS for IO expander communication
     void cs_assert();
     void cs_release();
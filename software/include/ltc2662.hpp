@@ -15,6 +15,9 @@ namespace LTC2662_SPAN {
     constexpr uint8_t MA_200     = 0x7;  // 200 mA full scale
     constexpr uint8_t SWITCH_NEG = 0x8;  // Switch to V- (pull to negative supply)
     constexpr uint8_t MA_300     = 0xF;  // 300 mA full scale
+
+    // 0x9-0xE are undefined
+    constexpr bool is_valid(int32_t span) { return (span >= HI_Z && span <= SWITCH_NEG) || span == MA_300; }
 }
 
 // Full-scale current values in mA for each span code
@@ -51,6 +54,8 @@ public:
     void init() override;
     void write_code(uint8_t channel, uint16_t code) override;
     void write_and_update(uint8_t channel, uint16_t code) override;
+    void write_code_all(uint16_t code) override;
+    void write_and_update_all(uint16_t code) override;
     void update_channel(uint8_t channel) override;
     void update_all() override;
     void set_span(uint8_t channel, uint8_t span_code) override;
@@ -59,7 +64,11 @@ public:
     uint8_t get_num_channels() const override { return NUM_CHANNELS; }
     const char* get_type_name() const override { return "LTC2662"; }
     uint8_t get_resolution() const override { return resolution_bits_; }
+    bool is_valid_span(int32_t span_code) const override { return LTC2662_SPAN::is_valid(span_code); }
     uint16_t get_max_code() const override { return max_code_; }
+    uint16_t get_input_code(uint8_t channel) const override;
+    uint16_t get_dac_code(uint8_t channel) const override;
+    void latch_inputs() override;
 
     // LTC2662-specific methods
 
@@ -69,12 +78,18 @@ public:
     // Set span for all channels at once
     void set_span_all(uint8_t span_code);
 
+    // Span code last written to a channel
+    uint8_t get_span(uint8_t channel) const { return channel < NUM_CHANNELS ? span_[channel] : 0; }
+
     // Get full-scale current for current span setting
     float get_full_scale_ma(uint8_t channel) const;
 
     // Convert voltage to 16-bit code for given span
     uint16_t current_ma_to_code(uint8_t channel, float current_ma) const;
 
+    // Convert code to current in mA for given span
+    float code_to_current_ma(uint8_t channel, uint16_t code) const;
+
     // Configure device options
     // ref_disable: true = use external reference
     // thermal_disable: true = disable thermal shutdown
@@ -97,6 +112,20 @@ private:
     uint8_t span_[NUM_CHANNELS] = {0};  // Current span setting per channel
     uint8_t resolution_bits_ = 16;       // 12 or 16 bit resolution
     uint16_t max_code_ = 65535;          // 4095 for 12-bit, 65535 for 16-bit
+
+    // Register shadows, codes at the configured resolution (power-on: zero)
+    uint16_t input_reg_[NUM_CHANNELS] = {0};
+    uint16_t dac_reg_[NUM_CHANNELS] = {0};
+
+    // Channels whose output needs an update before the DAC shadow can be
+    // trusted (span written, powered down); bit n = channel n
+    uint8_t stale_ = 0;
+
+    // Channels whose input-register shadow matches the chip (written since
+    // the last clear_shadow()); writes are only elided against these
+    uint8_t input_valid_ = 0;
+
+    void clear_shadow();
 };
 
 #endif // LTC2662_HPP
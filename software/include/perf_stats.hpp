@@ -0,0 +1,94 @@
+#ifndef PERF_STATS_HPP
+#define PERF_STATS_HPP
+
+#include <cstdint>
+#include <cstddef>
+
+#ifdef PERF_STATS_ENABLED
+#include "hardware/structs/m33.h"
+#endif
+
+class ResponseBuffer;
+
+// Cycle-count instrumentation (SYST:STAT?)
+//
+// Each probe point keeps a sample count, min/avg/max and a log2 histogram
+// of its durations in CPU cycles, read from the Cortex-M33 DWT cycle
+// counter (one per core, enabled by enable_cycle_counter()). Recording a
+// sample is a few dozen cycles with interrupts briefly masked, since the
+// sequencer's timer IRQ issues SPI transactions too. With the PERF_STATS
+// CMake option off, PerfScope is empty and SYST:STAT? reports no samples.
+
+namespace PERF_STATS {
+#ifdef PERF_STATS_ENABLED
+    constexpr bool ENABLED = true;
+#else
+    constexpr bool ENABLED = false;
+#endif
+
+    // Histogram bucket b counts durations in [2^(b + FIRST_BUCKET_BITS - 1),
+    // 2^(b + FIRST_BUCKET_BITS)) cycles; bucket 0 takes everything shorter
+    // and the last one everything longer (2^21 cycles is 14 ms at 150 MHz)
+    constexpr size_t BUCKETS = 16;
+    constexpr uint32_t FIRST_BUCKET_BITS = 7;
+}
+
+enum class PerfProbe : uint8_t {
+    SPI_TRANSACTION,  // SpiManager::transaction (queued frames return early)
+    EXPANDER_WRITE,   // Blocking IO expander writes (register, CS and LDAC frames)
+    PARSE,            // ScpiParser::parse (core 0)
+    EXECUTE,          // BoardManager::execute (core 1)
+    COUNT_
+};
+
+struct PerfCounter {
+    uint32_t count;
+    uint32_t min;
+    uint32_t max;
+    uint64_t total;
+    uint32_t histogram[PERF_STATS::BUCKETS];
+};
+
+namespace PerfStats {
+
+// Start the calling core's cycle counter (each core has its own DWT)
+void enable_cycle_counter();
+
+inline uint32_t cycles() {
+#ifdef PERF_STATS_ENABLED
+    return m33_hw->dwt_cyccnt;
+#else
+    return 0;
+#endif
+}
+
+void record(PerfProbe probe, uint32_t cycles);
+
+// Write every probe's statistics and histogram on one line, then reset
+// them all. Each counter is written only by the core that records it;
+// the reset is applied by that core at its next sample.
+void report(ResponseBuffer& out);
+
+}  // namespace PerfStats
+
+// Times its own lifetime against a probe point
+class PerfScope {
+public:
+#ifdef PERF_STATS_ENABLED
+    explicit PerfScope(PerfProbe probe) : probe_(probe), start_(PerfStats::cycles()) {}
+    ~PerfScope() { PerfStats::record(probe_, PerfStats::cycles() - start_); }
+#else
+    explicit PerfScope(PerfProbe) {}
+#endif
+
+    PerfScope(const PerfScope&) = delete;
+    PerfScope& operator=(const PerfScope&) = delete;
+
+#ifdef PERF_STATS_ENABLED
+private:
+    PerfProbe probe_;
+    uint32_t start_;
+#endif
+};
+
+#endif // PERF_STATS_HPP
@@ -0,0 +1,55 @@
+#ifndef PIO_DAC_BUS_HPP
+#define PIO_DAC_BUS_HPP
+
+#ifdef SINGLE_BOARD_MODE
+
+#include <cstdint>
+#include "hardware/pio.h"
+
+// PIO-timed DAC frames for single-board mode
+//
+// Each DAC gets a state machine running dac_frame.pio, so CS assert, the
+// 24-bit shift and CS release happen back to back in hardware (tens of ns
+// of framing instead of a GPIO switch plus two sleep_us(1) guards). Frames
+// to the same DAC pipeline through its 8-deep TX FIFO; switching to another
+// DAC first waits for the previous state machine to go idle so the shared
+// SCK/MOSI pins are never driven by two machines at once.
+//
+// Readbacks still use the SPI peripheral: suspend() hands SCK/MOSI back to
+// it and the CS pins to SIO, resume() returns them to the PIO.
+class PioDacBus {
+public:
+    static constexpr uint8_t NUM_DACS = 3;
+
+    // Load the program and start one state machine per DAC
+    // Picks the integer PIO divider whose SCK is closest to, but not above, baudrate
+    void init(uint32_t baudrate);
+    bool ready() const { return ready_; }
+
+    // Queue one 24-bit frame for device_id (0-2). Returns false if invalid.
+    // Call with interrupts masked (BusGuard): the sequencer IRQ also writes frames.
+    bool write_frame(uint8_t device_id, const uint8_t tx[3]);
+
+    // Spin until every queued frame has been clocked and CS released
+    void wait_idle();
+
+    // Lend SCK/MOSI/CS to the SPI peripheral and SIO for a blocking transfer
+    void suspend();
+    void resume();
+
+    // SCK actually produced by the PIO (Hz)
+    uint32_t actual_baudrate() const { return actual_baudrate_; }
+
+private:
+    PIO pio_ = nullptr;
+    uint sm_[NUM_DACS] = {0, 0, 0};
+    uint8_t last_dac_ = 0xFF;   // Machine that may still be clocking
+    uint32_t actual_baudrate_ = 0;
+    bool ready_ = false;
+
+    void wait_sm_idle(uint sm);
+};
+
+#endif // SINGLE_BOARD_MODE
+
+#endif // PIO_DAC_BUS_HPP
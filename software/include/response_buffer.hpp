@@ -0,0 +1,45 @@
+#ifndef RESPONSE_BUFFER_HPP
+#define RESPONSE_BUFFER_HPP
+
+#include <cstdarg>
+#include <cstddef>
+#include <cstdint>
+
+#include "scpi_error.hpp"
+
+// Fixed-capacity response text over caller-owned storage
+// Commands write their reply here instead of returning a heap string.
+// Output that does not fit is cut off (and truncated() reports it); the
+// text is always NUL-terminated.
+class ResponseBuffer {
+public:
+    ResponseBuffer(char* data, size_t capacity);
+
+    void clear();
+
+    // Replace the contents / append to them
+    void set(const char* text);
+    void append(const char* text);
+    void appendf(const char* fmt, ...) __attribute__((format(printf, 2, 3)));
+
+    // Shorthands for execute functions: write "OK" or "ERROR:<message>[detail]"
+    // and return the code to the caller
+    ScpiError ok();
+    ScpiError fail(ScpiError error);
+    ScpiError fail(ScpiError error, const char* detail_fmt, ...) __attribute__((format(printf, 3, 4)));
+
+    const char* c_str() const { return data_; }
+    size_t length() const { return length_; }
+    bool empty() const { return length_ == 0; }
+    bool truncated() const { return truncated_; }
+
+private:
+    char* data_;
+    size_t capacity_;
+    size_t length_ = 0;
+    bool truncated_ = false;
+
+    void appendv(const char* fmt, va_list args);
+};
+
+#endif // RESPONSE_BUFFER_HPP
@@ -0,0 +1,98 @@
+#ifndef SCPI_ERROR_HPP
+#define SCPI_ERROR_HPP
+
+#include <cstdint>
+
+// Error codes for parse and execute
+// Commands report failure as a code; the text sent to the host is
+// "ERROR:" + scpi_error_message(code), sometimes followed by a short detail
+// (e.g. the offending APPLY entry), see ResponseBuffer::fail().
+enum class ScpiError : uint8_t {
+    NONE = 0,
+
+    // Parser
+    EMPTY_COMMAND,
+    UNKNOWN_COMMAND,
+    EXPECTED_DAC_OR_SN,
+    EXPECTED_DAC,
+    EXPECTED_DAC_COMMAND,
+    EXPECTED_CH_COMMAND,
+    INVALID_BOARD_NUMBER,
+    INVALID_DAC_NUMBER,
+    INVALID_CHANNEL_NUMBER,
+    INVALID_VOLTAGE_VALUE,
+    INVALID_CURRENT_VALUE,
+    INVALID_CODE_VALUE,
+    INVALID_SPAN_VALUE,
+    INVALID_VALUE,
+    INVALID_GAIN_VALUE,
+    INVALID_OFFSET_VALUE,
+    INVALID_ENABLE_VALUE,
+    INVALID_CAL_TABLE,
+    INVALID_CAL_IMAGE_CHUNK,
+    INVALID_SNAP_NAME,
+    INVALID_RESOLUTION_VALUE,
+    RESOLUTION_12_OR_16,
+    INVALID_SAMPLE_RATE,
+    INVALID_LOOP_COUNT,
+    INVALID_TRIGGER_SOURCE,
+    INVALID_ELISION_SETTING,
+    INVALID_QUIET_SETTING,
+    INVALID_NOTIFY_SETTING,
+    INVALID_ARM_SETTING,
+    SERIAL_REQUIRED,
+    ARGUMENT_TOO_LONG,
+    LINE_TOO_LONG,
+    INVALID_CHANNEL_LIST,
+    APPLY_REQUIRES_ENTRIES,
+    SEQ_DATA_REQUIRES_CODES,
+    BCAST_EXPECTED_TARGET,
+    BCAST_EXPECTED_OPERATION,
+    BCAST_MIXED_SPAN,
+    UNKNOWN_DAC_COMMAND,
+    UNKNOWN_CHANNEL_COMMAND,
+    UNKNOWN_CAL_COMMAND,
+    UNKNOWN_SEQ_COMMAND,
+
+    // Execution
+    MISSING_ADDRESS,
+    MISSING_CHANNEL,
+    INVALID_BOARD,
+    INVALID_BOARD_DAC,
+    INVALID_CHANNEL,
+    DAC_NOT_INITIALIZED,
+    USE_CURR,
+    USE_VOLT,
+    FAULT_CURRENT_ONLY,
+    RANGE_NOT_SUPPORTED,
+    CODE_EXCEEDS_MAX,
+    INVALID_SPAN_CODE,
+    ELISION_0_OR_1,
+    FLASH_WRITE_FAILED,
+    NO_CAL_DATA,
+    CAL_TABLES_FULL,
+    CAL_IMAGE_REJECTED,
+    REPLY_TOO_LONG,
+    SNAP_NOT_FOUND,
+    SNAP_FULL,
+    SNAP_MISMATCH,
+    TOO_MANY_ENTRIES,
+    ENTRY_INVALID_ADDRESS,
+    ENTRY_INVALID_BOARD_DAC,
+    ENTRY_INVALID_CHANNEL,
+    ENTRY_INVALID_CODE,
+    ENTRY_INVALID_VALUE,
+    SEQ_ACTIVE,
+    SEQ_INVALID_CODE,
+    SEQ_MEMORY_FULL,
+    SEQ_TOO_MANY_TRACKS,
+    SEQ_RATE_RANGE,
+    SEQ_NOT_LOADED,
+    SEQ_NOT_ARMED,
+    TRIGGER_ARMED,
+};
+
+// Human-readable text for an error code (static storage, never null)
+const char* scpi_error_message(ScpiError error);
+
+#endif // SCPI_ERROR_HPP
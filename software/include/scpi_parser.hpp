@@ -1,10 +1,17 @@
 #ifndef SCPI_PARSER_HPP
 #define SCPI_PARSER_HPP
 
-#include <string>
-#include <vector>
+#include <cstddef>
 #include <cstdint>
 
+#include "scpi_error.hpp"
+
+namespace SCPI {
+    // Longest accepted command line, sized for a full APPLY batch (one entry
+    // per channel on all boards); also bounds ScpiCommand::string_value
+    constexpr size_t MAX_LINE_LENGTH = 2048;
+}
+
 // SCPI command types
 enum class ScpiCommandType {
     UNKNOWN,
@@ -12,11 +19,14 @@ enum class ScpiCommandType {
     IDN_QUERY,       // *IDN?
     RST,             // *RST
     // Board/DAC commands
+    // <n>, <m>, <c> may be ranges or lists for the VOLT, CURR and CODE forms
     SET_VOLTAGE,     // BOARD<n>:DAC<m>:CH<c>:VOLT <value>
     GET_VOLTAGE,     // BOARD<n>:DAC<m>:CH<c>:VOLT?
     SET_CURRENT,     // BOARD<n>:DAC<m>:CH<c>:CURR <value>
     GET_CURRENT,     // BOARD<n>:DAC<m>:CH<c>:CURR?
     SET_CODE,        // BOARD<n>:DAC<m>:CH<c>:CODE <value>
+    GET_CODE,        // BOARD<n>:DAC<m>:CH<c>:CODE?
+    SET_ALL_CODE,    // BOARD<n>:DAC<m>:CODE:ALL <value> - every channel, one frame
     SET_SPAN,        // BOARD<n>:DAC<m>:SPAN <value>
     SET_ALL_SPAN,    // BOARD<n>:DAC<m>:SPAN:ALL <value>
     UPDATE,          // BOARD<n>:DAC<m>:UPDATE
@@ -32,30 +42,84 @@ enum class ScpiCommandType {
     GET_CAL_OFFSET,  // BOARD<n>:DAC<m>:CH<c>:CAL:OFFS?
     SET_CAL_ENABLE,  // BOARD<n>:DAC<m>:CH<c>:CAL:EN <0|1>
     GET_CAL_ENABLE,  // BOARD<n>:DAC<m>:CH<c>:CAL:EN?
+    SET_CAL_TABLE,   // BOARD<n>:DAC<m>:CH<c>:CAL:TABL <in>,<out>,... | NONE
+    GET_CAL_TABLE,   // BOARD<n>:DAC<m>:CH<c>:CAL:TABL?
     SET_SERIAL,      // BOARD<n>:SN <string>
     GET_SERIAL,      // BOARD<n>:SN?
     CAL_DATA_QUERY,  // CAL:DATA? - Export all calibration data
+    CAL_IMAGE_QUERY, // CAL:IMAG? <offset> - Calibration image chunk, base64
+    CAL_IMAGE,       // CAL:IMAG <offset>,<base64> - Upload a chunk; the last one applies the image
     CAL_CLEAR,       // CAL:CLEAR - Clear all calibration data
     CAL_SAVE,        // CAL:SAVE - Save calibration to flash
     CAL_LOAD,        // CAL:LOAD - Load calibration from flash
+    // Output snapshots, stored in flash
+    SNAP_SAVE,       // SNAP:SAVE <name> - Spans and codes of every channel
+    SNAP_RESTORE,    // SNAP:REST <name> - Write them back, one LDAC
+    SNAP_DELETE,     // SNAP:DEL <name>
+    SNAP_LIST_QUERY, // SNAP:LIST? - Stored names, oldest first
+    SNAP_SET_BOOT,   // SNAP:BOOT <name>|NONE - Restored at power-up
+    SNAP_GET_BOOT,   // SNAP:BOOT?
     // Per-DAC readback commands
     DAC_FAULT_QUERY, // BOARD<n>:DAC<m>:FAULT? (LTC2662 only)
     DAC_ECHO_QUERY,  // BOARD<n>:DAC<m>:ECHO?
     // System commands
     FAULT_QUERY,     // FAULT?
+    FAULT_STATUS_QUERY, // FAULT:STAT? - Cached state with age and edge count
+    FAULT_SET_NOTIFY,   // FAULT:NOTIFY <0|1> - Unsolicited "!FAULT..." lines on change
+    FAULT_GET_NOTIFY,   // FAULT:NOTIFY?
     SYST_ERR_QUERY,  // SYST:ERR?
+    SYST_BOOT_QUERY, // SYST:BOOT? - Boot-to-ready and DAC init time
+    SYST_FITTED_QUERY, // SYST:FITT? - Boards found at init, as a bitmap
+    SYST_STAT_QUERY, // SYST:STAT? - Cycle counts of the probe points, then reset
+    SYST_CONFIG_QUERY, // SYST:CONF? - Build options (SPI baud rate, single-board mode, probes)
+    SYST_BINARY,     // SYST:BIN - Switch the link to the binary protocol
+    SYST_SET_ELIDE,  // SYST:ELIDE <0|1> - Skip DAC writes that repeat the shadowed code
+    SYST_GET_ELIDE,  // SYST:ELIDE?
+    SYST_ELIDE_COUNT_QUERY, // SYST:ELIDE:COUNT? - Writes skipped so far
+    SYST_SET_QUIET,  // SYST:QUIET <0|1> - No echo or prompt (applied by the USB side)
     PULSE_LDAC,      // LDAC
+    BCAST_CODE,      // BCAST:<DAC<m>|CURR|VOLT|ALL>:CODE <value> - every board, one LDAC
+    BCAST_SPAN,      // BCAST:<DAC<m>|CURR|VOLT>:SPAN <value>
+    // Batched commands
+    APPLY,           // APPLY <b>,<d>,<c>,<value>[,<b>,<d>,<c>,<value>...]
+    APPLY_CODE,      // APPLY:CODE <b>,<d>,<c>,<code>[,...]
+    // Sequencer commands
+    SEQ_DATA,        // BOARD<n>:DAC<m>:CH<c>:SEQ:DATA <code>[,<code>...]
+    SEQ_CLEAR,       // SEQ:CLEAR
+    SEQ_SET_RATE,    // SEQ:RATE <hz>
+    SEQ_GET_RATE,    // SEQ:RATE?
+    SEQ_SET_LOOP,    // SEQ:LOOP <n> (0 = forever)
+    SEQ_GET_LOOP,    // SEQ:LOOP?
+    SEQ_SET_TRIG_SOURCE, // SEQ:TRIG:SOUR <IMM|BUS|EXT>
+    SEQ_GET_TRIG_SOURCE, // SEQ:TRIG:SOUR?
+    SEQ_TRIGGER,     // SEQ:TRIG
+    SEQ_START,       // SEQ:START
+    SEQ_STOP,        // SEQ:STOP
+    SEQ_STATUS_QUERY, // SEQ:STAT?
+    // External trigger
+    TRIG_SET_ARM,    // TRIG:ARM <0|1>
+    TRIG_GET_ARM,    // TRIG:ARM?
+    TRIG_COUNT_QUERY, // TRIG:COUNT? - Trigger edges since boot
 };
 
 // Parsed SCPI command structure
+// Plain fixed-size data: no heap, so the parser can fill a slot of the
+// inter-core queue in place and core 1 can execute it there.
 struct ScpiCommand {
     ScpiCommandType type = ScpiCommandType::UNKNOWN;
     bool is_query = false;
 
     // Addressing (for board/DAC commands)
+    // Each level also accepts a range (BOARD0:7, CH0:4) or a list
+    // (CH(@0,2:4)); the masks hold every index addressed and the ids the
+    // lowest one. BCAST targets use dac_mask alone (DAC m on every board).
     int8_t board_id = -1;     // 0-7, -1 if not specified
     int8_t dac_id = -1;       // 0-2, -1 if not specified
     int8_t channel_id = -1;   // 0-4, -1 if not specified
+    uint8_t board_mask = 0;   // Bit n = BOARD<n>
+    uint8_t dac_mask = 0;     // Bit m = DAC<m>
+    uint8_t channel_mask = 0; // Bit c = CH<c>
+    bool has_range = false;   // More than one board, DAC or channel addressed
 
     // Value (for set commands)
     float float_value = 0.0f;
@@ -63,30 +127,40 @@ struct ScpiCommand {
     bool has_float = false;
     bool has_int = false;
 
-    // String value (for serial number)
-    std::string string_value;
-    bool has_string = false;
+    // Another ';' command from the same line follows (set by the line reader)
+    bool chained = false;
 
     // Error state
     bool valid = false;
-    std::string error_msg;
+    ScpiError error = ScpiError::NONE;
+
+    // String value (for serial number, APPLY entry list, SEQ:DATA codes)
+    bool has_string = false;
+    char string_value[SCPI::MAX_LINE_LENGTH] = {0};
+
+    // Back to the default-constructed state without touching string_value's tail
+    void reset();
 };
 
+// Row of the parser's command table (defined in scpi_parser.cpp)
+struct ScpiRoute;
+
+// Split a compound line ("CMD1;CMD2;...") in place: terminates the first
+// command at its ';' and returns the start of the next one, or nullptr if
+// this was the last. ';' inside double quotes does not split.
+char* scpi_split_compound(char* line);
+
 // SCPI Parser - parses incoming commands and produces structured command objects
+// Headers are matched against a compile-time keyword table; every keyword
+// accepts its SCPI short or long form (VOLT / VOLTage), in any case.
 class ScpiParser {
 public:
-    // Parse a single SCPI command line
-    ScpiCommand parse(const char* line);
-    ScpiCommand parse(const std::string& line);
+    // Parse a single SCPI command line into `result` (reset first)
+    void parse(const char* line, ScpiCommand& result);
 
 private:
-    // Parse helpers
-    bool parse_common_command(const char* cmd, ScpiCommand& result);
-    bool parse_board_command(const char* cmd, ScpiCommand& result);
-    bool parse_system_command(const char* cmd, ScpiCommand& result);
-
-    // Extract numeric index from string like "BOARD3" -> 3
-    int extract_index(const char* str, const char* prefix);
+    // Read the text after the header as the route's argument kind
+    bool parse_argument(const ScpiRoute& route, const char* args, ScpiCommand& result);
 
     // Skip whitespace and return pointer to next non-whitespace
     const char* skip_whitespace(const char* str);
@@ -94,12 +168,9 @@ private:
     // Parse numeric value
     bool parse_float(const char* str, float& value);
     bool parse_int(const char* str, uint16_t& value);
-};
 
-// Legacy compatibility
-struct scpi_command_t {
-    std::string cmd;
-    std::vector<std::string> args;
+    // Copy an argument into result.string_value; false if it does not fit
+    bool copy_string(const char* begin, size_t length, ScpiCommand& result);
 };
 
 #endif // SCPI_PARSER_HPP
@@ -0,0 +1,124 @@
+#ifndef SEQUENCER_HPP
+#define SEQUENCER_HPP
+
+#include <cstdint>
+#include <cstddef>
+#include "pico/stdlib.h"
+
+class DacDevice;
+class BoardManager;
+
+// Sequencer configuration
+namespace SEQ {
+    constexpr uint8_t MAX_TRACKS = 16;         // Channels played back together
+    constexpr uint16_t MAX_SAMPLES = 16384;    // Shared code pool (32 KB)
+    constexpr uint32_t MIN_RATE_HZ = 1;
+    constexpr uint32_t MAX_RATE_HZ = 50000;    // Upper bound; per-tick SPI time limits real rates
+    constexpr uint32_t DEFAULT_RATE_HZ = 1000;
+}
+
+enum class SeqState : uint8_t {
+    IDLE,     // Stopped (tables retained)
+    ARMED,    // Waiting for a trigger
+    RUNNING,  // Timer active
+};
+
+enum class SeqTrigger : uint8_t {
+    IMMEDIATE,  // SEQ:START begins playback
+    BUS,        // SEQ:START arms; SEQ:TRIG begins playback
+    EXTERNAL,   // SEQ:START arms; an edge on the trigger input (or SEQ:TRIG) begins playback
+};
+
+// On-device waveform playback
+// Each track is a table of codes for one channel. On every timer tick the
+// current sample of each track is loaded with write_code() and all tracks
+// are committed together (BoardManager::pulse_ldac() in multi-board mode,
+// UPDATE_ALL per touched chip in single-board mode). Tracks shorter than
+// the longest one hold their last sample until the loop wraps.
+//
+// The LDAC latches every chip, so while playback runs nothing else may be
+// left staged: BoardManager refuses batched writes and TRIG:ARM then.
+class Sequencer {
+public:
+    explicit Sequencer(BoardManager& boards);
+
+    // Discard all tracks (stops playback)
+    void clear();
+
+    // Append codes to the track for (board, dac_id, channel), creating it if needed
+    // Only the most recently created track can be extended, so each channel's
+    // table is stored contiguously. Returns false if the pool or track list is
+    // full, the track is not the last one, or playback is active.
+    bool append(DacDevice* dac, uint8_t board, uint8_t dac_id, uint8_t channel,
+                const uint16_t* codes, size_t count);
+
+    // Playback configuration (rejected while running/armed)
+    bool set_rate(uint32_t rate_hz);
+    uint32_t get_rate() const { return rate_hz_; }
+    void set_loops(uint32_t loops) { loops_ = loops; }  // 0 = repeat forever
+    uint32_t get_loops() const { return loops_; }
+    void set_trigger_source(SeqTrigger source) { trigger_source_ = source; }
+    SeqTrigger get_trigger_source() const { return trigger_source_; }
+
+    // Alarm pool for the playback timer; nullptr uses the SDK default pool.
+    // The timer IRQ runs on the core that created the pool.
+    void set_alarm_pool(alarm_pool_t* pool) { alarm_pool_ = pool; }
+
+    // Start playback (IMMEDIATE) or arm for a trigger (BUS, EXTERNAL)
+    // Returns false if there is nothing to play or already active
+    bool start();
+
+    // Starts an armed sequence (SEQ:TRIG, or the trigger IRQ on this core).
+    // Returns false if not armed.
+    bool trigger();
+
+    // Stop playback; outputs hold the last committed sample
+    void stop();
+
+    // Status
+    SeqState state() const { return state_; }
+    uint8_t num_tracks() const { return num_tracks_; }
+    uint16_t length() const { return length_; }
+    uint16_t position() const { return position_; }
+    uint32_t loops_done() const { return loops_done_; }
+    uint16_t samples_free() const { return SEQ::MAX_SAMPLES - pool_used_; }
+
+private:
+    struct Track {
+        DacDevice* dac;
+        uint8_t board;
+        uint8_t dac_id;
+        uint8_t channel;
+        uint16_t offset;  // Start index in samples_
+        uint16_t length;
+    };
+
+    BoardManager& boards_;
+
+    Track tracks_[SEQ::MAX_TRACKS];
+    uint8_t num_tracks_ = 0;
+    uint16_t samples_[SEQ::MAX_SAMPLES];
+    uint16_t pool_used_ = 0;
+    uint16_t length_ = 0;  // Longest track
+
+    // Chips to software-update each tick (single-board mode)
+    DacDevice* touched_[SEQ::MAX_TRACKS];
+    uint8_t num_touched_ = 0;
+
+    uint32_t rate_hz_ = SEQ::DEFAULT_RATE_HZ;
+    uint32_t loops_ = 0;
+    SeqTrigger trigger_source_ = SeqTrigger::IMMEDIATE;
+
+    // Shared with the timer IRQ
+    volatile SeqState state_ = SeqState::IDLE;
+    volatile uint16_t position_ = 0;
+    volatile uint32_t loops_done_ = 0;
+    repeating_timer_t timer_;
+    alarm_pool_t* alarm_pool_ = nullptr;
+
+    void begin_playback();
+    void step();
+    static bool timer_callback(repeating_timer_t* rt);
+};
+
+#endif // SEQUENCER_HPP
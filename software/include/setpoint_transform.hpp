@@ -0,0 +1,137 @@
+#ifndef SETPOINT_TRANSFORM_HPP
+#define SETPOINT_TRANSFORM_HPP
+
+#include <cstdint>
+
+// Fixed-point format of the setpoint transform
+namespace SETPOINT {
+    // Setpoints are converted to Q20 (about 1 uV / 1 nA steps), which limits
+    // them to +/-2047 V or mA; anything past that is beyond every span anyway
+    constexpr int VALUE_FRAC_BITS = 20;
+    constexpr float VALUE_LIMIT = 2047.0f;
+
+    // Codes per unit in Q12: worst case 0.04 LSB of error at 300 mA
+    constexpr int SCALE_FRAC_BITS = 12;
+
+    // The product of the two, and the format of the bias
+    constexpr int CODE_FRAC_BITS = VALUE_FRAC_BITS + SCALE_FRAC_BITS;
+
+    // Points in a piecewise-linear calibration table
+    constexpr uint8_t MAX_BREAKPOINTS = 16;
+}
+
+// Physical setpoint (V or mA) -> DAC code for one channel
+//
+// Folds calibration ((value * gain) + offset) and the span/resolution
+// scaling ((output - min) / range * max_code) into one line:
+//     code = clamp(value * scale + bias, 0, max_code)
+// so a setpoint costs one integer multiply-add instead of two float
+// passes and a divide. Rebuilt whenever the channel's span, resolution or
+// calibration changes (see BoardManager::calibrated_voltage_code()).
+struct SetpointTransform {
+    int64_t bias = 0;      // Code at a setpoint of 0, Q32
+    int32_t scale = 0;     // Codes per unit, Q12
+    uint16_t max_code = 0;
+    uint8_t span = 0;      // Span code the transform was built for
+    bool valid = false;    // Cleared when the calibration changes
+
+    // Output range [min, max] in the same units as the setpoint; an empty
+    // range (Hi-Z or undefined span) always yields code 0
+    static SetpointTransform build(double gain, double offset, float min, float max,
+                                   uint16_t max_code, uint8_t span) {
+        SetpointTransform t;
+        t.max_code = max_code;
+        t.span = span;
+        t.valid = true;
+
+        double range = static_cast<double>(max) - min;
+        if (range <= 0.0) return t;
+
+        // Computed once per rebuild, so double (software) precision is fine here
+        double codes_per_unit = max_code / range;
+        double scale = gain * codes_per_unit * (1 << SETPOINT::SCALE_FRAC_BITS);
+        if (scale > INT32_MAX) scale = INT32_MAX;
+        if (scale < -INT32_MAX) scale = -INT32_MAX;
+        t.scale = static_cast<int32_t>(scale < 0.0 ? scale - 0.5 : scale + 0.5);
+        t.bias = static_cast<int64_t>((offset - min) * codes_per_unit *
+                                      static_cast<double>(1ULL << SETPOINT::CODE_FRAC_BITS));
+        return t;
+    }
+
+    bool matches(uint8_t span_code, uint16_t max) const {
+        return valid && span == span_code && max_code == max;
+    }
+
+    uint16_t code(float value) const { return code_fixed(to_fixed(value)); }
+
+    // Setpoint in Q20, clamped to +/-VALUE_LIMIT
+    static int32_t to_fixed(float value) {
+        // Also maps NaN to the lower limit
+        if (!(value > -SETPOINT::VALUE_LIMIT)) value = -SETPOINT::VALUE_LIMIT;
+        if (value > SETPOINT::VALUE_LIMIT) value = SETPOINT::VALUE_LIMIT;
+
+        float scaled = value * static_cast<float>(1 << SETPOINT::VALUE_FRAC_BITS);
+        return static_cast<int32_t>(scaled < 0.0f ? scaled - 0.5f : scaled + 0.5f);
+    }
+
+    uint16_t code_fixed(int32_t q) const {
+        // Round to nearest, as the float path did
+        int64_t acc = static_cast<int64_t>(q) * scale + bias +
+                      (1LL << (SETPOINT::CODE_FRAC_BITS - 1));
+        int64_t c = acc >> SETPOINT::CODE_FRAC_BITS;
+        if (c < 0) return 0;
+        if (c > max_code) return max_code;
+        return static_cast<uint16_t>(c);
+    }
+};
+
+// Setpoint -> code for a channel with a calibration table
+//
+// Breakpoint i maps setpoint input[i] to output output[i]; each segment in
+// between is linear and gets its own SetpointTransform, and the first and
+// last segments carry on past the ends of the table. A setpoint costs a
+// binary search over the breakpoints plus one multiply-add.
+struct PiecewiseTransform {
+    uint8_t segments = 0;  // 0 = not built
+    int32_t limit[SETPOINT::MAX_BREAKPOINTS - 2];  // Q20 setpoint where segment i + 1 starts
+    SetpointTransform segment[SETPOINT::MAX_BREAKPOINTS - 1];
+
+    // input strictly increasing, 2 <= count <= MAX_BREAKPOINTS
+    static PiecewiseTransform build(const float* input, const float* output, uint8_t count,
+                                    float min, float max, uint16_t max_code, uint8_t span) {
+        PiecewiseTransform t;
+        t.segments = static_cast<uint8_t>(count - 1);
+        for (uint8_t i = 0; i < t.segments; i++) {
+            double gain = (static_cast<double>(output[i + 1]) - output[i]) /
+                          (static_cast<double>(input[i + 1]) - input[i]);
+            double offset = output[i] - input[i] * gain;
+            t.segment[i] = SetpointTransform::build(gain, offset, min, max, max_code, span);
+            if (i + 1 < t.segments) {
+                t.limit[i] = SetpointTransform::to_fixed(input[i + 1]);
+            }
+        }
+        return t;
+    }
+
+    bool matches(uint8_t span_code, uint16_t max) const {
+        return segments > 0 && segment[0].matches(span_code, max);
+    }
+
+    uint16_t code(float value) const {
+        int32_t q = SetpointTransform::to_fixed(value);
+        // First segment whose limit is above the setpoint (the last has none)
+        uint8_t lo = 0;
+        uint8_t hi = static_cast<uint8_t>(segments - 1);
+        while (lo < hi) {
+            uint8_t mid = static_cast<uint8_t>((lo + hi) / 2);
+            if (q < limit[mid]) {
+                hi = mid;
+            } else {
+                lo = static_cast<uint8_t>(mid + 1);
+            }
+        }
+        return segment[lo].code_fixed(q);
+    }
+};
+
+#endif // SETPOINT_TRANSFORM_HPP
@@ -0,0 +1,82 @@
+#ifndef SPI_DMA_HPP
+#define SPI_DMA_HPP
+
+#include <cstdint>
+#include <cstddef>
+
+#include "hardware/spi.h"
+#include "spsc_queue.hpp"
+
+// DMA frame queue configuration
+namespace SPI_DMA {
+    // Queued segments; a multi-board DAC write takes up to 3 (select, frame, deselect)
+    // 512 covers a full APPLY batch (120 DAC frames) plus its LDAC pulse
+    constexpr size_t QUEUE_SEGMENTS = 512;
+
+    constexpr uint8_t MAX_SEGMENT_LEN = 4;   // 24-bit DAC frame, 32-bit readback format
+    constexpr uint8_t CS_NONE = 0xFF;        // Segment clocked with no GPIO CS (decoder-driven DAC CS)
+}
+
+// One chip-select window on the bus: CS low, `len` bytes clocked, CS high
+struct SpiSegment {
+    uint8_t cs_pin = SPI_DMA::CS_NONE;
+    uint8_t len = 0;
+    uint8_t data[SPI_DMA::MAX_SEGMENT_LEN] = {0, 0, 0, 0};
+};
+
+// DMA-driven SPI transmit queue
+//
+// Segments are clocked out back to back by a TX/RX DMA channel pair. The RX
+// channel's completion IRQ (fired once the last bit has been shifted, not
+// merely loaded into the FIFO) releases the segment's CS, asserts the next
+// one's and restarts both channels. The CPU is only involved for that CS
+// hand-off; it is free to build the next frames while bytes are on the wire.
+//
+// Producers (thread code and the sequencer timer IRQ) enqueue with
+// interrupts masked; the IRQ must be enabled on the same core. Blocking bus
+// users take a BusGuard, which waits for the queue to drain first.
+class SpiDma {
+public:
+    // Claim DMA channels and install the completion IRQ on the calling core
+    void init(spi_inst_t* spi);
+    bool ready() const { return ready_; }
+
+    // Room for `count` more segments? (call with interrupts masked)
+    bool has_space(size_t count) const {
+        return SPI_DMA::QUEUE_SEGMENTS - queue_.size() >= count;
+    }
+
+    // Append a segment (call with interrupts masked, after has_space())
+    void push(const SpiSegment& segment) { queue_.push(segment); }
+
+    // Start the engine if it is idle (call with interrupts masked, after push())
+    void kick();
+
+    // No segment queued or in flight
+    bool idle() const { return !running_; }
+
+    // Spin (interrupts enabled) until the queue has drained
+    void wait_idle() const;
+
+    // Mask interrupts once the bus is free of DMA traffic; returns the saved
+    // state for restore_interrupts(). Used by BusGuard.
+    static uint32_t acquire_idle();
+
+private:
+    spi_inst_t* spi_ = nullptr;
+    int tx_chan_ = -1;
+    int rx_chan_ = -1;
+    bool ready_ = false;
+    volatile bool running_ = false;
+
+    SpscQueue<SpiSegment, SPI_DMA::QUEUE_SEGMENTS> queue_;
+    SpiSegment current_;      // Segment being clocked (DMA reads from here)
+    uint8_t rx_discard_ = 0;  // RX sink; the DAC and expander writes return nothing useful
+
+    static SpiDma* instance_;
+
+    void start_next();        // Pop and launch the next segment, or go idle
+    static void irq_handler();
+};
+
+#endif // SPI_DMA_HPP
@@ -6,6 +6,8 @@
 
 #include "hardware/spi.h"
 #include "io_expander.hpp"  // HW_PINS (multi-board) or HW_PINS_SINGLE (single-board)
+#include "spi_dma.hpp"
+#include "pio_dac_bus.hpp"  // Single-board mode only
 
 // SPI Configuration Constants
 namespace SPI_CONFIG {
@@ -37,9 +39,23 @@ public:
     // This is the main hardware initialization entry point
     void init();
 
+    // Switch write-only DAC traffic to the DMA frame queue
+    // The queue's completion IRQ is installed on the calling core, which must
+    // be the core that issues all further bus traffic. Until this is called
+    // every transaction is blocking. (Single-board mode: no-op, write-only
+    // frames already go through the PIO from init() on.)
+    void start_dma();
+
+    // Wait until every queued DMA frame is on the wire
+    void flush();
+
     // Perform SPI transaction to a specific DAC
     // board_id: 0-7, device_id: 0-2 (2x LTC2662 + 1x LTC2664 per board)
     // For DAC transactions, the decoder tree handles CS via IO expander
+    // Write-only frames (rx_data == nullptr) are queued for DMA once
+    // start_dma() has run (single-board: pushed to the PIO) and return
+    // before they are clocked; readbacks wait for the queue to drain and
+    // then run blocking.
     void transaction(uint8_t board_id, uint8_t device_id,
                      const uint8_t* tx_data, uint8_t* rx_data, size_t len);
 
@@ -47,13 +63,18 @@ public:
     // This is used internally and for direct IO expander access
     void raw_transfer(const uint8_t* tx_data, uint8_t* rx_data, size_t len);
 
-    // Pulse LDAC to update all DAC outputs
+    // Pulse LDAC to update all DAC outputs (queued behind pending DMA frames)
     void pulse_ldac();
 
     // Assert/release CLR line (clear all DACs)
     void assert_clear();
     void release_clear();
 
+#ifdef SINGLE_BOARD_MODE
+    // SCK of PIO-timed write frames (integer divider of clk_sys, <= BAUDRATE)
+    uint32_t pio_baudrate() const { return pio_bus_.actual_baudrate(); }
+#endif
+
 #ifndef SINGLE_BOARD_MODE
     // Access to IO expander for fault monitoring, etc. (multi-board only)
     IoExpander& io_expander() { return io_expander_; }
@@ -65,10 +86,12 @@ public:
 private:
 #ifdef SINGLE_BOARD_MODE
     uint8_t current_selected_dac_ = 0xFF;  // 0xFF = none selected
+    PioDacBus pio_bus_;                    // Write-only frames
 #else
     IoExpander io_expander_;
 #endif
     bool initialized_ = false;
+    SpiDma dma_;
 
     // Internal helpers
     void init_gpio();          // Configure GPIO pins
@@ -79,6 +102,18 @@ private:
 
     void select_downstream(uint8_t board_id, uint8_t device_id);
     void deselect();
+
+    // Queue select/frame/deselect segments for one write-only DAC frame
+    void queue_transaction(uint8_t board_id, uint8_t device_id,
+                           const uint8_t* tx_data, size_t len);
+
+    // Mask interrupts once the DMA queue has room for `count` segments
+    uint32_t reserve_segments(size_t count);
+
+#ifdef SINGLE_BOARD_MODE
+    // Direct CS GPIO for a DAC (SPI_DMA::CS_NONE if device_id is invalid)
+    static uint8_t dac_cs_pin(uint8_t device_id);
+#endif
 };
 
 #endif // SPI_MANAGER_HPP
@@ -0,0 +1,82 @@
+#ifndef SPSC_QUEUE_HPP
+#define SPSC_QUEUE_HPP
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+
+// Lock-free single-producer / single-consumer ring buffer
+// One core pushes, the other pops. Indices run freely and are masked on
+// access, so all N slots are usable. Slots are reused, not destroyed: a
+// popped item is moved out and the slot keeps its (moved-from) object.
+// Large items can skip the moves entirely with claim/publish and front/release.
+template <typename T, size_t N>
+class SpscQueue {
+    static_assert(N > 0 && (N & (N - 1)) == 0, "SpscQueue size must be a power of two");
+
+public:
+    // Producer side. Returns false (item untouched) if the queue is full.
+    bool push(T&& item) {
+        uint32_t head = head_.load(std::memory_order_relaxed);
+        if (head - tail_.load(std::memory_order_acquire) >= N) return false;
+        slots_[head & (N - 1)] = std::move(item);
+        head_.store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+    bool push(const T& item) {
+        T copy = item;
+        return push(std::move(copy));
+    }
+
+    // Consumer side. Returns false if the queue is empty.
+    bool pop(T& out) {
+        uint32_t tail = tail_.load(std::memory_order_relaxed);
+        if (tail == head_.load(std::memory_order_acquire)) return false;
+        out = std::move(slots_[tail & (N - 1)]);
+        tail_.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Zero-copy producer side: claim() returns the next free slot (nullptr if
+    // full) to be filled in place, publish() hands it to the consumer
+    T* claim() {
+        uint32_t head = head_.load(std::memory_order_relaxed);
+        if (head - tail_.load(std::memory_order_acquire) >= N) return nullptr;
+        return &slots_[head & (N - 1)];
+    }
+
+    void publish() {
+        head_.store(head_.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+    }
+
+    // Zero-copy consumer side: front() returns the oldest item (nullptr if
+    // empty) to be used in place, release() frees its slot
+    T* front() {
+        uint32_t tail = tail_.load(std::memory_order_relaxed);
+        if (tail == head_.load(std::memory_order_acquire)) return nullptr;
+        return &slots_[tail & (N - 1)];
+    }
+
+    void release() {
+        tail_.store(tail_.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+    }
+
+    // Approximate when called from the other side; exact from either end's own view
+    bool empty() const {
+        return head_.load(std::memory_order_acquire) == tail_.load(std::memory_order_acquire);
+    }
+    bool full() const { return size() >= N; }
+    size_t size() const {
+        return head_.load(std::memory_order_acquire) - tail_.load(std::memory_order_acquire);
+    }
+    static constexpr size_t capacity() { return N; }
+
+private:
+    T slots_[N];
+    std::atomic<uint32_t> head_{0};  // Written by the producer only
+    std::atomic<uint32_t> tail_{0};  // Written by the consumer only
+};
+
+#endif // SPSC_QUEUE_HPP
@@ -0,0 +1,71 @@
+#ifndef STATE_STORAGE_HPP
+#define STATE_STORAGE_HPP
+
+#include <cstdint>
+#include "board_manager.hpp"
+#include "cal_storage.hpp"
+
+class ResponseBuffer;
+
+// Named output-state snapshots in flash (SNAP:SAVE/REST)
+// Uses the STATE_SLOTS sectors just below the calibration log, one snapshot
+// per sector, with one sector always kept free. A save programs the new
+// snapshot into the free sector before it erases the one it replaces, so an
+// interrupted save keeps either the old or the new copy; if two valid copies of a name are found, the higher sequence
+// number wins. One snapshot may be marked for restore at power-up.
+
+namespace StateStorage {
+
+constexpr uint32_t STATE_SLOTS = 8;
+constexpr uint32_t STATE_FLASH_OFFSET =
+    CalStorage::CAL_FLASH_OFFSET - STATE_SLOTS * CalStorage::FLASH_SECTOR_SIZE;  // 0x1F0000
+
+// Magic number to identify a snapshot sector
+constexpr uint32_t STATE_MAGIC = 0x47524D53;  // "GRMS" (greymatter Snapshot)
+constexpr uint16_t STATE_VERSION = 1;
+
+// Names are 1-15 letters, digits or '_', stored upper case
+constexpr size_t STATE_NAME_MAX_LEN = 16;
+
+constexpr uint8_t STATE_FLAG_BOOT = 0x01;  // Restored by restore_boot()
+
+struct __attribute__((packed)) StateSlot {
+    uint32_t magic;              // Magic number for validation
+    uint16_t version;            // Data format version
+    uint8_t flags;               // STATE_FLAG_*
+    uint8_t reserved;            // 0xFF
+    uint32_t sequence;           // Incremented by every write; newest copy wins
+    char name[STATE_NAME_MAX_LEN];
+    OutputState state;
+    uint32_t checksum;           // CRC-32 of everything above
+};
+static_assert(sizeof(StateSlot) <= CalStorage::FLASH_SECTOR_SIZE, "Snapshot exceeds a sector");
+
+// Capture the manager's spans and codes under name, replacing any snapshot
+// of that name. At most STATE_SLOTS - 1 names are kept. Fails with
+// INVALID_SNAP_NAME, SNAP_FULL or FLASH_WRITE_FAILED.
+ScpiError save(const BoardManager& manager, const char* name);
+
+// Write a snapshot back to the DACs (BoardManager::restore_output_state)
+ScpiError restore(BoardManager& manager, const char* name);
+
+// Erase a snapshot
+ScpiError erase(const char* name);
+
+// Mark a snapshot for restore at power-up, or none with nullptr
+ScpiError set_boot(const char* name);
+
+// Name of the power-up snapshot, or nullptr
+const char* boot_name();
+
+// Comma-separated snapshot names, oldest first
+void list(ResponseBuffer& out);
+
+// Restore the power-up snapshot, if any. Returns its name, or nullptr if
+// none is set; error is set if it no longer fits the DACs. Runs on core 1
+// at boot, so the caller reports the outcome (BootReport).
+const char* restore_boot(BoardManager& manager, ScpiError& error);
+
+}  // namespace StateStorage
+
+#endif // STATE_STORAGE_HPP
@@ -12,6 +12,19 @@ namespace utils {
     uint16_t parse_hex(const std::string &s);
     bool parse_int(const std::string &s, int32_t &out);
     bool parse_float(const std::string &s, float &out);
+
+    // CRC-16/CCITT (poly 0x1021); pass a previous result as crc to continue
+    uint16_t crc16_ccitt(const uint8_t* data, size_t length, uint16_t crc = 0xFFFF);
+
+    // CRC-32 (IEEE 802.3, as zlib); pass a previous result as crc to continue
+    uint32_t crc32(const uint8_t* data, size_t length, uint32_t crc = 0);
+
+    // Base64 (RFC 4648, padded). encode writes base64_length(length) chars
+    // plus a terminating NUL; decode returns the byte count, or -1 if the
+    // text is malformed or the result does not fit in capacity.
+    constexpr size_t base64_length(size_t length) { return (length + 2) / 3 * 4; }
+    void base64_encode(const uint8_t* data, size_t length, char* out);
+    int32_t base64_decode(const char* text, size_t length, uint8_t* out, size_t capacity);
 }
 
 #endif // UTILS_HPP
@@ -1,4 +1,15 @@
-"""Allow running `python -m greymatter.server` as `python -m greymatter`."""
-from .server import main
+"""``python -m greymatter`` runs the ZMQ server (as ``python -m greymatter.server``).
 
-main()
+``python -m greymatter bench ...`` runs the benchmarks instead (see
+:mod:`greymatter.bench`).
+"""
+import sys
+
+if len(sys.argv) > 1 and sys.argv[1] == "bench":
+    from .bench import main
+
+    main(sys.argv[2:])
+else:
+    from .server import main
+
+    main()
@@ -0,0 +1,279 @@
+"""End-to-end command benchmarks for the greymatter firmware.
+
+Usage::
+
+    python -m greymatter bench --port /dev/ttyACM0
+    python -m greymatter bench --port /dev/ttyACM0 --pipelined
+    python -m greymatter bench --address 192.168.1.100 --pico pico_0
+    python -m greymatter bench --port /dev/ttyACM0 --output fw-0.3.json
+
+Each case sends the same command many times and reports commands per
+second and round-trip latency percentiles as JSON, tagged with the
+firmware build (``SYST:CONF?``: SPI baud rate, single-board mode) and
+``*IDN?``, so runs of different firmware versions can be compared. Add
+``--firmware-stats`` to include the on-device cycle counts (``SYST:STAT?``)
+taken over each case.
+
+The benchmarks write DAC codes on the first fitted board and rewrite the
+calibration image it already holds; the board's codes are restored at
+the end. Nothing is saved to flash.
+"""
+
+from __future__ import annotations
+
+import argparse
+import json
+import math
+import platform
+import sys
+import time
+from datetime import datetime, timezone
+
+from .calibration import GreyMatterCalibration
+from .controller import GreyMatter
+from .errors import GreyMatterError
+
+# Output format version of the JSON report
+_REPORT_VERSION = 1
+
+# Channels per DAC (DAC 0 and 1: LTC2662, DAC 2: LTC2664)
+_CHANNELS = (5, 5, 4)
+
+# Codes alternated by the write benchmarks (valid at any resolution), so
+# write elision never skips one
+_CODES = (0x0000, 0x0100)
+
+
+def _percentile(sorted_values: list[float], fraction: float) -> float:
+    """Nearest-rank percentile of an already sorted list."""
+    index = max(0, math.ceil(fraction * len(sorted_values)) - 1)
+    return sorted_values[index]
+
+
+def _summarize(name: str, latencies: list[float], elapsed: float,
+               items_per_op: int = 1) -> dict:
+    """Build one result row from per-operation latencies (seconds)."""
+    ordered = sorted(latencies)
+    ops = len(ordered)
+    return {
+        "name": name,
+        "ops": ops,
+        "items_per_op": items_per_op,
+        "seconds": round(elapsed, 6),
+        "ops_per_sec": round(ops / elapsed, 2) if elapsed > 0 else None,
+        "items_per_sec": round(ops * items_per_op / elapsed, 2) if elapsed > 0 else None,
+        "latency_us": {
+            "min": round(ordered[0] * 1e6, 1),
+            "p50": round(_percentile(ordered, 0.50) * 1e6, 1),
+            "p99": round(_percentile(ordered, 0.99) * 1e6, 1),
+            "max": round(ordered[-1] * 1e6, 1),
+            "mean": round(sum(ordered) / ops * 1e6, 1),
+        },
+    }
+
+
+def _timed(op, count: int, warmup: int) -> tuple[list[float], float]:
+    """Run op(i) count times after warmup untimed runs.
+
+    Returns the latency of every call and the total elapsed time.
+    """
+    for i in range(warmup):
+        op(i)
+    latencies = []
+    start = time.perf_counter()
+    for i in range(count):
+        t0 = time.perf_counter()
+        op(i)
+        latencies.append(time.perf_counter() - t0)
+    return latencies, time.perf_counter() - start
+
+
+class Bench:
+    """Benchmark cases against one connected board."""
+
+    def __init__(self, gm: GreyMatter, count: int, warmup: int,
+                 firmware_stats: bool = False):
+        self._gm = gm
+        self._count = count
+        self._warmup = warmup
+        self._firmware_stats = firmware_stats
+        self._board = self._first_board()
+
+    # -- Board information --
+
+    def _first_board(self) -> int:
+        try:
+            fitted = self._gm.fitted_boards()
+        except GreyMatterError:
+            return 0  # Firmware without SYST:FITT?
+        return fitted[0] if fitted else 0
+
+    def firmware(self) -> dict:
+        """Identification and build options of the firmware under test."""
+        info: dict = {"idn": self._gm.identify(), "board": self._board}
+        try:
+            fields = dict(item.split("=", 1)
+                          for item in self._gm.query("SYST:CONF?").split(","))
+            info["spi_baudrate"] = int(fields["SPI"])
+            info["single_board_mode"] = fields["SINGLE"] == "1"
+            info["perf_stats"] = fields["PERF"] == "1"
+        except (GreyMatterError, KeyError, ValueError):
+            # Firmware without SYST:CONF?
+            info.update(spi_baudrate=None, single_board_mode=None, perf_stats=None)
+        return info
+
+    # -- Cases --
+
+    def single_write(self) -> dict:
+        """One raw code write per command."""
+        header = f"BOARD{self._board}:DAC0:CH0:CODE"
+        return self._run("single_write",
+                         lambda i: self._gm.command(f"{header} {_CODES[i & 1]}"))
+
+    def batched_write(self) -> dict:
+        """Every channel of the board in one APPLY:CODE, one LDAC."""
+        entries = [(self._board, dac, ch)
+                   for dac, channels in enumerate(_CHANNELS)
+                   for ch in range(channels)]
+        commands = [
+            "APPLY:CODE " + ",".join(f"{b},{d},{c},{code}" for b, d, c in entries)
+            for code in _CODES
+        ]
+        return self._run("batched_write",
+                         lambda i: self._gm.command(commands[i & 1]),
+                         items_per_op=len(entries))
+
+    def pipelined_write(self) -> dict:
+        """Single writes sent as one batch; latency is per whole batch.
+
+        Only differs from single_write on a pipelined transport, which
+        sends every command before reading the first reply.
+        """
+        header = f"BOARD{self._board}:DAC0:CH0:CODE"
+        commands = [f"{header} {_CODES[i & 1]}" for i in range(100)]
+        runs = max(1, self._count // len(commands))
+        return self._run("pipelined_write", lambda i: self._gm.batch(commands),
+                         count=runs, items_per_op=len(commands))
+
+    def query(self) -> dict:
+        """Code readback (answered from the firmware's register shadow)."""
+        cmd = f"BOARD{self._board}:DAC0:CH0:CODE?"
+        return self._run("query", lambda i: self._gm.query(cmd))
+
+    def fault_poll(self) -> dict:
+        """FAULT? polling (answered from the cached fault state)."""
+        return self._run("fault_poll", lambda i: self._gm.fault_status())
+
+    def cal_read(self) -> dict:
+        """Whole calibration image read over CAL:IMAG?."""
+        cal = GreyMatterCalibration(self._gm)
+        return self._run("cal_read", lambda i: cal.read_image(),
+                         count=max(1, self._count // 50))
+
+    def cal_write(self) -> dict:
+        """Whole calibration image written back over CAL:IMAG (RAM only)."""
+        cal = GreyMatterCalibration(self._gm)
+        image = cal.read_image()
+        return self._run("cal_write", lambda i: cal.write_image(image),
+                         count=max(1, self._count // 50))
+
+    CASES = ("single_write", "batched_write", "pipelined_write", "query",
+             "fault_poll", "cal_read", "cal_write")
+
+    def run(self, cases=CASES) -> list[dict]:
+        """Run the named cases in order, restoring the board's codes after."""
+        saved = self._save_codes()
+        try:
+            return [getattr(self, name)() for name in cases]
+        finally:
+            self._gm.apply_codes(saved)
+
+    # -- Helpers --
+
+    def _run(self, name: str, op, count: int | None = None,
+             items_per_op: int = 1) -> dict:
+        count = self._count if count is None else count
+        warmup = min(self._warmup, count)
+        if self._firmware_stats:
+            self._gm.perf_stats()  # Reset the counters
+        latencies, elapsed = _timed(op, count, warmup)
+        result = _summarize(name, latencies, elapsed, items_per_op)
+        if self._firmware_stats:
+            # Includes the warmup runs
+            result["firmware_stats"] = self._gm.perf_stats()
+        return result
+
+    def _save_codes(self) -> list[tuple[int, int, int, int]]:
+        saved = []
+        for dac, channels in enumerate(_CHANNELS):
+            codes = self._gm.get_codes(self._board, dac, range(channels))
+            saved += [(self._board, dac, ch, code) for ch, code in enumerate(codes)]
+        return saved
+
+
+def _print_table(report: dict, stream) -> None:
+    print(f"{'case':<16} {'ops/s':>10} {'items/s':>10} {'p50 us':>10} "
+          f"{'p99 us':>10} {'max us':>10}", file=stream)
+    for row in report["results"]:
+        lat = row["latency_us"]
+        print(f"{row['name']:<16} {row['ops_per_sec']:>10} {row['items_per_sec']:>10} "
+              f"{lat['p50']:>10} {lat['p99']:>10} {lat['max']:>10}", file=stream)
+
+
+def main(argv: list[str] | None = None) -> None:
+    parser = argparse.ArgumentParser(
+        prog="python -m greymatter bench",
+        description="Benchmark greymatter command throughput and latency",
+    )
+    target = parser.add_mutually_exclusive_group(required=True)
+    target.add_argument("--port", help="Serial port of the board (direct connection)")
+    target.add_argument("--address", help="Address of a greymatter ZMQ server")
+    parser.add_argument("--pico", help="Pico name on the server (default: first one)")
+    parser.add_argument("--zmq-port", type=int, default=5556,
+                        help="ZMQ server port (default: 5556)")
+    parser.add_argument("--baudrate", type=int, default=115200,
+                        help="Serial baud rate (default: 115200)")
+    parser.add_argument("--pipelined", action="store_true",
+                        help="Use the pipelined serial transport")
+    parser.add_argument("-n", "--count", type=int, default=1000,
+                        help="Commands per case (default: 1000)")
+    parser.add_argument("--warmup", type=int, default=20,
+                        help="Untimed commands before each case (default: 20)")
+    parser.add_argument("--cases", nargs="+", choices=Bench.CASES, default=list(Bench.CASES),
+                        help="Cases to run (default: all)")
+    parser.add_argument("--firmware-stats", action="store_true",
+                        help="Include the on-device cycle counts (SYST:STAT?) of each case")
+    parser.add_argument("-o", "--output", help="Write the JSON report here instead of stdout")
+    args = parser.parse_args(argv)
+
+    if args.address is not None:
+        transport = "zmq"
+        gm = GreyMatter(address=args.address, pico=args.pico, zmq_port=args.zmq_port)
+    else:
+        transport = "serial-pipelined" if args.pipelined else "serial"
+        gm = GreyMatter(args.port, baudrate=args.baudrate, pipelined=args.pipelined)
+
+    with gm:
+        bench = Bench(gm, args.count, args.warmup, args.firmware_stats)
+        report = {
+            "version": _REPORT_VERSION,
+            "timestamp": datetime.now(timezone.utc).isoformat(timespec="seconds"),
+            "host": platform.node(),
+            "transport": transport,
+            "target": args.address or args.port,
+            "firmware": bench.firmware(),
+            "results": bench.run(args.cases),
+        }
+
+    text = json.dumps(report, indent=2)
+    if args.output:
+        with open(args.output, "w") as f:
+            f.write(text + "\n")
+        _print_table(report, sys.stdout)
+    else:
+        print(text)
+        _print_table(report, sys.stderr)
+
+
+if __name__ == "__main__":
+    main()
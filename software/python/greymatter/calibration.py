@@ -1,10 +1,83 @@
 from __future__ import annotations
 
+import base64
+import binascii
+import struct
 from typing import TYPE_CHECKING
 
 if TYPE_CHECKING:
     from .controller import GreyMatter
 
+_IMAGE_MAGIC = 0x47524D43        # "GRMC"
+_IMAGE_VERSION = 1
+_IMAGE_HEADER = struct.Struct("<IHH")
+_IMAGE_CHANNEL = struct.Struct("<ffB")
+_IMAGE_CHUNK = 1024              # Bytes per CAL:IMAG command (CAL_IMAGE_CHUNK)
+_SERIAL_LEN = 32
+_DACS_PER_BOARD = 3
+_CHANNELS_PER_DAC = 5
+_RESERVED_LEN = 256
+
+
+class CalibrationImage:
+    """Gains, offsets, enables and serial numbers of every channel.
+
+    The firmware's calibration image (``FlashCalibrationData``), as moved
+    by ``CAL:IMAG``. ``channels`` maps ``(board, dac, channel)`` to
+    ``(gain, offset, enabled)``; ``serials`` holds one string per board.
+    Calibration tables are not part of the image.
+    """
+
+    _PER_BOARD = (_SERIAL_LEN
+                  + _DACS_PER_BOARD * _CHANNELS_PER_DAC * _IMAGE_CHANNEL.size)
+
+    def __init__(self, num_boards: int):
+        self.serials = [""] * num_boards
+        self.channels = {
+            (b, d, c): (1.0, 0.0, False)
+            for b in range(num_boards)
+            for d in range(_DACS_PER_BOARD)
+            for c in range(_CHANNELS_PER_DAC)
+        }
+
+    @property
+    def num_boards(self) -> int:
+        return len(self.serials)
+
+    @classmethod
+    def from_bytes(cls, data: bytes) -> CalibrationImage:
+        body = len(data) - _IMAGE_HEADER.size - _RESERVED_LEN
+        if body <= 0 or body % cls._PER_BOARD:
+            raise ValueError(f"unexpected calibration image size {len(data)}")
+        magic, version, crc = _IMAGE_HEADER.unpack_from(data)
+        if magic != _IMAGE_MAGIC or version != _IMAGE_VERSION:
+            raise ValueError("not a calibration image")
+        if binascii.crc_hqx(data[_IMAGE_HEADER.size:], 0xFFFF) != crc:
+            raise ValueError("calibration image CRC mismatch")
+
+        image = cls(body // cls._PER_BOARD)
+        pos = _IMAGE_HEADER.size
+        for b in range(image.num_boards):
+            raw = data[pos:pos + _SERIAL_LEN]
+            image.serials[b] = raw.split(b"\0", 1)[0].decode("ascii", "replace")
+            pos += _SERIAL_LEN
+        for key in image.channels:  # board, dac, channel order
+            gain, offset, enabled = _IMAGE_CHANNEL.unpack_from(data, pos)
+            image.channels[key] = (gain, offset, bool(enabled))
+            pos += _IMAGE_CHANNEL.size
+        return image
+
+    def to_bytes(self) -> bytes:
+        body = bytearray()
+        for serial in self.serials:
+            raw = serial.encode("ascii")[:_SERIAL_LEN - 1]
+            body += raw.ljust(_SERIAL_LEN, b"\0")
+        for gain, offset, enabled in self.channels.values():
+            body += _IMAGE_CHANNEL.pack(gain, offset, 1 if enabled else 0)
+        body += b"\xff" * _RESERVED_LEN
+        crc = binascii.crc_hqx(bytes(body), 0xFFFF)
+        return _IMAGE_HEADER.pack(_IMAGE_MAGIC, _IMAGE_VERSION, crc) + bytes(body)
+
 
 class GreyMatterCalibration:
     """Calibration interface for the greymatter DAC controller.
@@ -16,6 +89,14 @@ class GreyMatterCalibration:
         cal = GreyMatterCalibration(gm)
         cal.set_gain(board=0, dac=0, channel=0, gain=0.999)
         cal.save()
+
+    To provision many channels, edit a CalibrationImage and write it in
+    one go::
+
+        image = cal.read_image()
+        image.channels[(0, 2, 0)] = (0.999313, 0.0068, True)
+        cal.write_image(image)
+        cal.save()
     """
 
     def __init__(self, gm: GreyMatter):
@@ -42,6 +123,48 @@ class GreyMatterCalibration:
     def set_enabled(self, board: int, dac: int, channel: int, enabled: bool) -> None:
         self._gm.command(f"{self._ch_prefix(board, dac, channel)}:CAL:EN {1 if enabled else 0}")
 
+    def get_table(self, board: int, dac: int, channel: int) -> list[tuple[float, float]]:
+        """Return the channel's calibration table as (input, output) pairs.
+
+        An empty list means the channel has no table.
+        """
+        resp = self._gm.query(f"{self._ch_prefix(board, dac, channel)}:CAL:TABL?")
+        if resp.upper() == "NONE":
+            return []
+        values = [float(v) for v in resp.split(",")]
+        return list(zip(values[0::2], values[1::2]))
+
+    def set_table(self, board: int, dac: int, channel: int, points) -> None:
+        """Set a piecewise-linear calibration table for a channel.
+
+        ``points`` is 2-16 (input, output) pairs with increasing inputs.
+        While calibration is enabled the table is used instead of gain and
+        offset. The whole table is sent as one command.
+        """
+        self._gm.command(self._table_command(board, dac, channel, points))
+
+    def clear_table(self, board: int, dac: int, channel: int) -> None:
+        """Remove a channel's calibration table (gain and offset apply again)."""
+        self._gm.command(f"{self._ch_prefix(board, dac, channel)}:CAL:TABL NONE")
+
+    def set_tables(self, tables) -> None:
+        """Set many tables at once.
+
+        ``tables`` maps (board, dac, channel) to a list of (input, output)
+        pairs, or to an empty list to remove the table. The commands are
+        sent as one batch.
+        """
+        self._gm.batch(
+            self._table_command(b, d, c, points)
+            for (b, d, c), points in tables.items()
+        )
+
+    def _table_command(self, board: int, dac: int, channel: int, points) -> str:
+        prefix = f"{self._ch_prefix(board, dac, channel)}:CAL:TABL"
+        if not points:
+            return f"{prefix} NONE"
+        return f"{prefix} " + ",".join(f"{float(x)!r},{float(y)!r}" for x, y in points)
+
     def save(self) -> None:
         """Save calibration data to flash."""
         self._gm.command("CAL:SAVE")
@@ -54,6 +177,33 @@ class GreyMatterCalibration:
         """Clear all calibration data (RAM and flash)."""
         self._gm.command("CAL:CLEAR")
 
+    def read_image(self) -> CalibrationImage:
+        """Read every channel's gain, offset and enable at once.
+
+        Takes one query per 1 KB chunk of the image instead of three per
+        channel.
+        """
+        size, first = self._gm.query("CAL:IMAG? 0").split(",", 1)
+        chunks = [first]
+        offsets = range(_IMAGE_CHUNK, int(size), _IMAGE_CHUNK)
+        for resp in self._gm.batch(f"CAL:IMAG? {offset}" for offset in offsets):
+            chunks.append(resp.split(",", 1)[1])
+        return CalibrationImage.from_bytes(
+            b"".join(base64.b64decode(chunk) for chunk in chunks))
+
+    def write_image(self, image: CalibrationImage) -> None:
+        """Replace every channel's gain, offset and enable, and the serials.
+
+        The firmware checks the whole image before applying it, so a bad
+        transfer changes nothing. Tables are kept. Call save() to store it.
+        """
+        data = image.to_bytes()
+        self._gm.batch(
+            f"CAL:IMAG {offset},"
+            + base64.b64encode(data[offset:offset + _IMAGE_CHUNK]).decode("ascii")
+            for offset in range(0, len(data), _IMAGE_CHUNK)
+        )
+
     def export_data(self) -> str:
         """Export all calibration data as a formatted string."""
         return self._gm.query("CAL:DATA?")
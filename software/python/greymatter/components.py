@@ -66,6 +66,10 @@ class CurrentDAC:
         """Set span for all channels."""
         self._gm.command(f"{self._prefix()}:SPAN:ALL {int(span)}")
 
+    def set_code_all(self, code: int) -> None:
+        """Write one raw code to every channel and update them (single frame)."""
+        self._gm.command(f"{self._prefix()}:CODE:ALL {code}")
+
     @property
     def resolution(self) -> int:
         return int(self._gm.query(f"{self._prefix()}:RES?"))
@@ -128,6 +132,10 @@ class VoltageDAC:
         """Set span for all channels."""
         self._gm.command(f"{self._prefix()}:SPAN:ALL {int(span)}")
 
+    def set_code_all(self, code: int) -> None:
+        """Write one raw code to every channel and update them (single frame)."""
+        self._gm.command(f"{self._prefix()}:CODE:ALL {code}")
+
     @property
     def resolution(self) -> int:
         return int(self._gm.query(f"{self._prefix()}:RES?"))
@@ -162,6 +170,10 @@ class CurrentChannel:
         """Set output current in mA."""
         self._gm.command(f"{self._prefix}:CURR {milliamps}")
 
+    def get_current(self) -> float:
+        """Output current in mA, as last set (answered from the firmware's shadow)."""
+        return float(self._gm.query(f"{self._prefix}:CURR?"))
+
     def set_span(self, span: CurrentSpan) -> None:
         """Set span for this channel."""
         self._gm.command(f"{self._prefix}:SPAN {int(span)}")
@@ -170,6 +182,10 @@ class CurrentChannel:
         """Set raw DAC code."""
         self._gm.command(f"{self._prefix}:CODE {code}")
 
+    def get_code(self) -> int:
+        """Raw code currently latched in the DAC register."""
+        return int(self._gm.query(f"{self._prefix}:CODE?"))
+
     def power_down(self) -> None:
         self._gm.command(f"{self._prefix}:PDOWN")
 
@@ -185,6 +201,10 @@ class VoltageChannel:
         """Set output voltage in volts."""
         self._gm.command(f"{self._prefix}:VOLT {volts}")
 
+    def get_voltage(self) -> float:
+        """Output voltage in volts, as last set (answered from the firmware's shadow)."""
+        return float(self._gm.query(f"{self._prefix}:VOLT?"))
+
     def set_span(self, span: VoltageSpan) -> None:
         """Set span for this channel."""
         self._gm.command(f"{self._prefix}:SPAN {int(span)}")
@@ -193,5 +213,9 @@ class VoltageChannel:
         """Set raw DAC code."""
         self._gm.command(f"{self._prefix}:CODE {code}")
 
+    def get_code(self) -> int:
+        """Raw code currently latched in the DAC register."""
+        return int(self._gm.query(f"{self._prefix}:CODE?"))
+
     def power_down(self) -> None:
         self._gm.command(f"{self._prefix}:PDOWN")
@@ -1,7 +1,16 @@
 from __future__ import annotations
 
+from concurrent.futures import Future
+
 from .errors import GreyMatterError
-from .transport import SerialTransport, ZmqTransport, _CMD_TIMEOUT
+from .transport import (
+    PipelinedSerialTransport, SerialTransport, ZmqTransport, _CMD_TIMEOUT,
+)
+
+
+# Longest command line the firmware accepts (SCPI::MAX_LINE_LENGTH less the
+# terminating NUL)
+_MAX_LINE_LENGTH = 2047
 
 
 class GreyMatter:
@@ -26,6 +35,11 @@ class GreyMatter:
 
         with GreyMatter("/dev/tty.usbmodem1101") as gm:
             gm.board(0).dac(0).channel(0).set_current(50.0)
+
+    Pipelined serial (many commands in flight, see :meth:`batch`)::
+
+        gm = GreyMatter("/dev/tty.usbmodem1101", pipelined=True)
+        gm.batch([f"BOARD0:DAC0:CH{c}:CURR 10" for c in range(5)])
     """
 
     def __init__(
@@ -38,10 +52,13 @@ class GreyMatter:
         baudrate: int = 115200,
         num_boards: int = 8,
         timeout: float = _CMD_TIMEOUT,
+        pipelined: bool = False,
     ):
         self._num_boards = num_boards
 
-        if port is not None:
+        if port is not None and pipelined:
+            self._transport = PipelinedSerialTransport(port, baudrate, timeout)
+        elif port is not None:
             self._transport = SerialTransport(port, baudrate, timeout)
         elif address is not None:
             self._transport = ZmqTransport(
@@ -112,6 +129,168 @@ class GreyMatter:
         """Send LDAC to pulse the load-DAC line."""
         self.command("LDAC")
 
+    def arm_trigger(self, enable: bool = True) -> None:
+        """Stage writes until the next edge on the trigger input (``TRIG:ARM``).
+
+        While armed, channel writes, :meth:`apply` and broadcasts only load
+        the DACs' input registers; the next rising edge commits them all and
+        disarms. Picos wired to one trigger line then update together::
+
+            for gm in picos:
+                gm.arm_trigger()
+                gm.apply(setpoints[gm])
+            # ...pulse the shared trigger line...
+
+        ``enable=False`` disarms and leaves the staged writes for
+        :meth:`pulse_ldac`.
+        """
+        self.command(f"TRIG:ARM {1 if enable else 0}")
+
+    def trigger_armed(self) -> bool:
+        """True until the trigger edge has committed the staged writes."""
+        return self.query("TRIG:ARM?") == "1"
+
+    def trigger_count(self) -> int:
+        """Rising edges seen on the trigger input since power-up."""
+        return int(self.query("TRIG:COUNT?"))
+
+    def apply(self, entries) -> None:
+        """Set many channels in one round trip with a single LDAC commit.
+
+        ``entries`` is an iterable of ``(board, dac, channel, value)``
+        tuples. Values are volts for DAC 2 and milliamps for DAC 0/1,
+        with calibration applied by the firmware. All outputs change
+        together when the batch is committed::
+
+            gm.apply([(0, 0, 0, 1.5), (0, 0, 1, 2.0), (0, 2, 0, -3.3)])
+
+        Values are sent with 7 significant digits (float precision). A
+        batch too long for one command line is split into several
+        commands, each committed on its own.
+        """
+        self.batch(_format_batches("APPLY", entries, "{:.7g}"))
+
+    def apply_codes(self, entries) -> None:
+        """Like :meth:`apply`, but with raw DAC codes as values."""
+        self.batch(_format_batches("APPLY:CODE", entries, "{:d}"))
+
+    def set_currents(self, milliamps: float, boards, dacs=(0, 1), channels=range(5)) -> None:
+        """Set one current on a range of channels in a single command.
+
+        ``boards``, ``dacs`` and ``channels`` are an index or an iterable of
+        indices; the firmware expands them into one batch committed with a
+        single LDAC. To set every current source on boards 0-7::
+
+            gm.set_currents(10.0, boards=range(8))
+        """
+        self.command(f"{_range_header(boards, dacs, channels)}:CURR {milliamps}")
+
+    def set_voltages(self, volts: float, boards, channels=range(4)) -> None:
+        """Set one voltage on a range of DAC 2 channels (see :meth:`set_currents`)."""
+        self.command(f"{_range_header(boards, 2, channels)}:VOLT {volts}")
+
+    def set_codes(self, code: int, boards, dacs, channels) -> None:
+        """Write one raw code to a range of channels (see :meth:`set_currents`)."""
+        self.command(f"{_range_header(boards, dacs, channels)}:CODE {code}")
+
+    def get_codes(self, boards, dacs, channels) -> list[int]:
+        """Read back the codes of a range of channels, in board/DAC/channel order."""
+        resp = self.query(f"{_range_header(boards, dacs, channels)}:CODE?")
+        return [int(v) for v in resp.split(",")]
+
+    def broadcast_code(self, target: str, code: int) -> None:
+        """Write one raw code to every channel of a DAC group on all boards.
+
+        ``target`` is ``"DAC0"``-``"DAC2"``, ``"CURR"`` (DAC 0 and 1),
+        ``"VOLT"`` (DAC 2) or ``"ALL"``. One frame per chip, committed
+        with a single LDAC, e.g. ``gm.broadcast_code("ALL", 0)``.
+        """
+        self.command(f"BCAST:{target}:CODE {code}")
+
+    def broadcast_span(self, target: str, span: int) -> None:
+        """Set the span of every channel of a DAC group on all boards.
+
+        ``target`` is as for :meth:`broadcast_code`, except ``"ALL"``
+        (the span codes differ between the two DAC types).
+        """
+        self.command(f"BCAST:{target}:SPAN {int(span)}")
+
+    def set_write_elision(self, enable: bool) -> None:
+        """Skip DAC writes that repeat the code already on the channel.
+
+        Useful for control loops that resend steady setpoints every cycle;
+        only changed channels generate SPI traffic.
+        """
+        self.command(f"SYST:ELIDE {1 if enable else 0}")
+
+    def elided_writes(self) -> int:
+        """Number of DAC writes the firmware has skipped via elision."""
+        return int(self.query("SYST:ELIDE:COUNT?"))
+
+    def boot_time(self) -> tuple[float, float]:
+        """Return (seconds from reset to ready, seconds of DAC init)."""
+        ready_us, init_us = self.query("SYST:BOOT?").split(",")
+        return int(ready_us) / 1e6, int(init_us) / 1e6
+
+    def fitted_boards(self) -> list[int]:
+        """Indices of the boards the firmware found at init (``SYST:FITT?``)."""
+        mask = int(self.query("SYST:FITT?"), 16)
+        return [board for board in range(8) if mask & (1 << board)]
+
+    def perf_stats(self) -> dict:
+        """Read and reset the firmware's cycle counters (``SYST:STAT?``).
+
+        Returns ``{"clock_hz": int, "SPI": {...}, "EXPW": {...}, "PARSE":
+        {...}, "EXEC": {...}}``; each probe has ``count``, ``min``, ``avg``
+        and ``max`` in cycles and a 16-entry log2 ``histogram`` (bucket 0
+        below 128 cycles, bucket n from 2**(n+6) cycles).
+        """
+        fields = self.query("SYST:STAT?").split(";")
+        stats: dict = {"clock_hz": int(fields[0].split("=", 1)[1])}
+        for field in fields[1:]:
+            name, values = field.split(":", 1)
+            probe = dict(item.split("=", 1) for item in values.split(","))
+            stats[name] = {
+                "count": int(probe["N"]),
+                "min": int(probe["MIN"]),
+                "avg": int(probe["AVG"]),
+                "max": int(probe["MAX"]),
+                "histogram": [int(v) for v in probe["HIST"].split("/")],
+            }
+        return stats
+
+    # -- Output snapshots --
+
+    def save_state(self, name: str) -> None:
+        """Store every channel's span and code in flash under ``name``.
+
+        Names are 1-15 letters, digits or ``_`` (case-insensitive); saving
+        an existing name replaces it. Up to 8 snapshots are kept.
+        """
+        self.command(f"SNAP:SAVE {name}")
+
+    def restore_state(self, name: str) -> None:
+        """Write a saved snapshot back to all DACs, committed with one LDAC."""
+        self.command(f"SNAP:REST {name}")
+
+    def delete_state(self, name: str) -> None:
+        """Erase a saved snapshot."""
+        self.command(f"SNAP:DEL {name}")
+
+    def list_states(self) -> list[str]:
+        """Names of the saved snapshots, oldest first."""
+        resp = self.query("SNAP:LIST?")
+        return resp.split(",") if resp else []
+
+    def set_boot_state(self, name: str | None) -> None:
+        """Restore snapshot ``name`` at every power-up, or none with ``None``."""
+        self.command(f"SNAP:BOOT {name if name else 'NONE'}")
+
+    def boot_state(self) -> str | None:
+        """Name of the snapshot restored at power-up, or ``None``."""
+        resp = self.query("SNAP:BOOT?")
+        return None if resp == "NONE" else resp
+
     # -- Raw SCPI --
 
     def command(self, cmd: str) -> str:
@@ -131,6 +310,48 @@ class GreyMatter:
         """
         return self.command(cmd)
 
+    def submit(self, cmd: str) -> Future:
+        """Send a SCPI command without waiting for it.
+
+        Returns a future for the raw response. ERROR: responses are not
+        raised here. With ``pipelined=True`` many submits can be in flight;
+        other transports complete the command before returning.
+        """
+        return self._transport.submit(cmd)
+
+    def batch(self, cmds, check: bool = True) -> list[str]:
+        """Send many SCPI commands and return their responses in order.
+
+        Pipelined transports send every command before reading any
+        response. With ``check`` (the default), GreyMatterError is raised
+        after all responses are in if any of them is an ERROR: response.
+        """
+        responses = self._transport.send_many(list(cmds))
+        if check:
+            failed = [(i, r) for i, r in enumerate(responses)
+                      if r.startswith("ERROR:")]
+            if failed:
+                index, resp = failed[0]
+                raise GreyMatterError(
+                    f"{resp} (command {index}; {len(failed)} failed)"
+                )
+        return responses
+
+    def command_all(self, cmd: str) -> dict[str, str]:
+        """Send a SCPI command to every Pico on the server at once.
+
+        Only for ZMQ connections. Returns a dict mapping Pico name ->
+        response; raises GreyMatterError if any Pico failed.
+
+        Example::
+
+            gm = GreyMatter(address="192.168.1.100")
+            gm.command_all("*RST")
+        """
+        if not isinstance(self._transport, ZmqTransport):
+            raise GreyMatterError("command_all() needs a ZMQ connection")
+        return self._transport.send_all(cmd)
+
     # -- Server utilities --
 
     @staticmethod
@@ -164,3 +385,39 @@ class GreyMatter:
         finally:
             socket.close()
             context.destroy()
+
+
+def _index_spec(indices) -> str:
+    """Format indices as SCPI addressing: 3, 0:4 or (@0,2,4)."""
+    if isinstance(indices, int):
+        return str(indices)
+    values = sorted(set(int(i) for i in indices))
+    if not values:
+        raise ValueError("index list must not be empty")
+    if len(values) == 1:
+        return str(values[0])
+    if values == list(range(values[0], values[-1] + 1)):
+        return f"{values[0]}:{values[-1]}"
+    return "(@" + ",".join(str(v) for v in values) + ")"
+
+
+def _range_header(boards, dacs, channels) -> str:
+    return f"BOARD{_index_spec(boards)}:DAC{_index_spec(dacs)}:CH{_index_spec(channels)}"
+
+
+def _format_batches(cmd: str, entries, value_format: str) -> list[str]:
+    """Format entries as few commands as fit the firmware's line limit."""
+    fields = [f"{int(b)},{int(d)},{int(c)}," + value_format.format(v)
+              for b, d, c, v in entries]
+    if not fields:
+        raise ValueError("entries must not be empty")
+    commands = []
+    line = cmd
+    for field in fields:
+        sep = " " if line == cmd else ","
+        if len(line) + len(sep) + len(field) > _MAX_LINE_LENGTH and line != cmd:
+            commands.append(line)
+            line, sep = cmd, " "
+        line += sep + field
+    commands.append(line)
+    return commands
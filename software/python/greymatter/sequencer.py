@@ -0,0 +1,83 @@
+from __future__ import annotations
+
+from typing import TYPE_CHECKING, Iterable
+
+if TYPE_CHECKING:
+    from .controller import GreyMatter
+
+# Codes per SEQ:DATA line; keeps each line well inside the firmware's
+# 2048-byte input buffer
+_CHUNK = 256
+
+
+class GreyMatterSequencer:
+    """On-device waveform sequencer for the greymatter DAC controller.
+
+    Tables of raw codes are uploaded per channel, then played back by a
+    hardware timer with all channels committed together on every sample.
+
+    Usage::
+
+        from greymatter.sequencer import GreyMatterSequencer
+
+        seq = GreyMatterSequencer(gm)
+        seq.clear()
+        seq.upload(board=0, dac=2, channel=0, codes=range(0, 4096, 16))
+        seq.configure(rate_hz=10000, loops=0)
+        seq.start()
+    """
+
+    def __init__(self, gm: GreyMatter):
+        self._gm = gm
+
+    def clear(self) -> None:
+        """Stop playback and discard every uploaded table."""
+        self._gm.command("SEQ:CLEAR")
+
+    def upload(self, board: int, dac: int, channel: int,
+               codes: Iterable[int]) -> None:
+        """Append raw codes to the table for one channel.
+
+        Upload each channel's table completely before starting the next.
+        """
+        codes = [int(c) for c in codes]
+        prefix = f"BOARD{board}:DAC{dac}:CH{channel}:SEQ:DATA"
+        for i in range(0, len(codes), _CHUNK):
+            chunk = ",".join(str(c) for c in codes[i:i + _CHUNK])
+            self._gm.command(f"{prefix} {chunk}")
+
+    def configure(self, rate_hz: int | None = None, loops: int | None = None,
+                  trigger: str | None = None) -> None:
+        """Set sample rate, loop count (0 = forever) and trigger source.
+
+        ``trigger`` is ``"IMM"`` (start immediately), ``"BUS"``
+        (:meth:`start` arms, :meth:`trigger` begins playback) or ``"EXT"``
+        (:meth:`start` arms, an edge on the trigger input begins playback).
+        """
+        if rate_hz is not None:
+            self._gm.command(f"SEQ:RATE {int(rate_hz)}")
+        if loops is not None:
+            self._gm.command(f"SEQ:LOOP {int(loops)}")
+        if trigger is not None:
+            self._gm.command(f"SEQ:TRIG:SOUR {trigger}")
+
+    def start(self) -> None:
+        self._gm.command("SEQ:START")
+
+    def trigger(self) -> None:
+        """Software trigger for a sequence armed with trigger source BUS or EXT."""
+        self._gm.command("SEQ:TRIG")
+
+    def stop(self) -> None:
+        self._gm.command("SEQ:STOP")
+
+    def status(self) -> dict:
+        """Return state, tracks, length, position and completed loops."""
+        state, tracks, length, pos, loops = self._gm.query("SEQ:STAT?").split(",")
+        return {
+            "state": state,
+            "tracks": int(tracks),
+            "length": int(length),
+            "position": int(pos),
+            "loops_done": int(loops),
+        }
@@ -10,12 +10,20 @@ Usage::
     python -m greymatter.server --port 5556 --scan '/dev/ttyACM*'
 
 The server auto-discovers Pico boards by scanning serial ports and
-sending ``*IDN?``.  Each board is assigned a name (``pico_0``, ``pico_1``,
-etc.) in the order they are discovered.
+sending ``*IDN?``; all ports are probed at once.  Each board is assigned a
+name (``pico_0``, ``pico_1``, etc.) in port order.  ``__rescan__`` only
+probes ports that are not already connected, in the background, and keeps
+the existing connections and names.
 
 Clients connect with::
 
     gm = GreyMatter(address="<host-ip>", pico="pico_0")
+
+Requests arrive on a ROUTER socket and are handed to one worker thread per
+Pico over an inproc ROUTER/DEALER pair, so a slow command on one Pico does
+not hold up clients of the others. A request with ``"pico": "*"`` runs on
+every Pico in parallel; its reply maps each Pico name to that Pico's
+``{"ok": ..., "data"/"error": ...}`` result.
 """
 
 from __future__ import annotations
@@ -23,12 +31,29 @@ from __future__ import annotations
 import argparse
 import json
 import glob as glob_module
+import itertools
+import threading
+from concurrent.futures import ThreadPoolExecutor
 from datetime import datetime
 
 from .transport import SerialTransport
 from .errors import GreyMatterError
 
 
+# Backend endpoint shared by the router loop and the Pico workers
+_BACKEND = "inproc://greymatter-workers"
+
+# Control frames between the router loop and a worker
+_READY = b"__ready__"
+_STOP = b"__stop__"
+
+# Backend identity of the background __rescan__ thread
+_RESCAN = b"__rescan__"
+
+# Pico name that fans a request out to every board
+_ALL_PICOS = "*"
+
+
 def _log(msg: str) -> None:
     print(f"[{datetime.now().strftime('%Y-%m-%d %H:%M:%S')}] {msg}", flush=True)
 
@@ -44,13 +69,104 @@ class PicoConnection:
         self.idn = idn
 
 
+def _run_command(pico: PicoConnection, cmd: str) -> dict:
+    """Forward one SCPI command to a Pico and build the reply object."""
+    try:
+        _log(f"[{pico.name}] {cmd}")
+        return {"ok": True, "data": pico.transport.send_command(cmd)}
+    except GreyMatterError as exc:
+        _log(f"[{pico.name}] ERROR: {exc}")
+        return {"ok": False, "error": str(exc)}
+    except Exception as exc:
+        _log(f"[{pico.name}] COMM ERROR: {exc}")
+        return {"ok": False, "error": f"Communication error: {exc}"}
+
+
+class PicoWorker(threading.Thread):
+    """Runs the commands for one Pico, one at a time, in its own thread.
+
+    The worker's DEALER socket connects to the router loop's backend
+    ROUTER with the Pico name as identity. Each request is
+    ``[token, cmd]``; the reply is ``[token, reply_json]``.
+    """
+
+    def __init__(self, pico: PicoConnection, context):
+        super().__init__(name=f"worker:{pico.name}", daemon=True)
+        self.pico = pico
+        self._context = context
+
+    def run(self) -> None:
+        import zmq
+
+        socket = self._context.socket(zmq.DEALER)
+        socket.setsockopt(zmq.IDENTITY, self.pico.name.encode())
+        socket.setsockopt(zmq.LINGER, 0)
+        socket.connect(_BACKEND)
+        socket.send(_READY)
+        try:
+            while True:
+                token, cmd = socket.recv_multipart()
+                if token == _STOP:
+                    socket.send(_STOP)
+                    break
+                reply = _run_command(self.pico, cmd.decode())
+                socket.send_multipart([token, json.dumps(reply).encode()])
+        finally:
+            socket.close()
+
+
+class _Job:
+    """A client request waiting on one or more workers."""
+
+    def __init__(self, envelope: list[bytes], names: list[str],
+                 fan_out: bool):
+        self.envelope = envelope
+        self.pending = set(names)
+        self.results: dict[str, dict] = {}
+        self.fan_out = fan_out
+
+    def reply(self) -> dict:
+        if not self.fan_out:
+            return next(iter(self.results.values()))
+        failed = [n for n, r in self.results.items() if not r.get("ok")]
+        reply = {"ok": not failed, "data": self.results}
+        if failed:
+            reply["error"] = (
+                f"{len(failed)} of {len(self.results)} pico(s) failed: "
+                f"{failed}"
+            )
+        return reply
+
+
+def _probe(port: str, baudrate: int,
+           timeout: float) -> tuple[SerialTransport, str] | None:
+    """Open one port and ask ``*IDN?``; None if it is not a Pico."""
+    try:
+        _log(f"Trying {port} ...")
+        transport = SerialTransport(port, baudrate, timeout)
+    except Exception as exc:
+        _log(f"  {port} -> skip: {exc}")
+        return None
+    try:
+        return transport, transport.send_command("*IDN?")
+    except Exception as exc:
+        _log(f"  {port} -> skip: {exc}")
+        transport.close()
+        return None
+
+
 def discover_picos(
     patterns: list[str] | None = None,
     baudrate: int = 115200,
     timeout: float = 2.0,
+    known: dict[str, PicoConnection] | None = None,
 ) -> dict[str, PicoConnection]:
     """Scan serial ports for greymatter Pico boards.
 
+    New ports are probed concurrently. Connections in ``known`` whose port
+    still exists are kept as they are, with their names, and not probed
+    again; the caller closes the ones left out of the result.
+
     Returns:
         dict mapping name -> PicoConnection for each board that responds
         to ``*IDN?``.
@@ -62,46 +178,252 @@ def discover_picos(
     for pattern in patterns:
         ports.extend(sorted(glob_module.glob(pattern)))
 
-    picos: dict[str, PicoConnection] = {}
+    picos: dict[str, PicoConnection] = {
+        p.name: p for p in (known or {}).values() if p.port in ports
+    }
+    connected = {p.port for p in picos.values()}
+    new_ports = [port for port in ports if port not in connected]
+    if not new_ports:
+        return picos
+
+    with ThreadPoolExecutor(max_workers=len(new_ports)) as pool:
+        found = list(pool.map(
+            lambda port: _probe(port, baudrate, timeout), new_ports
+        ))
+
     idx = 0
-    for port in ports:
-        try:
-            _log(f"Trying {port} ...")
-            transport = SerialTransport(port, baudrate, timeout)
-            idn = transport.send_command("*IDN?")
-            name = f"pico_{idx}"
-            picos[name] = PicoConnection(name, port, transport, idn)
-            _log(f"  -> {name}: {idn}")
+    for port, result in zip(new_ports, found):
+        if result is None:
+            continue
+        while f"pico_{idx}" in picos:
             idx += 1
-        except Exception as exc:
-            _log(f"  -> skip: {exc}")
+        name = f"pico_{idx}"
+        transport, idn = result
+        picos[name] = PicoConnection(name, port, transport, idn)
+        _log(f"  {port} -> {name}: {idn}")
 
     return picos
 
 
-def _handle_meta(cmd: str, picos: dict[str, PicoConnection],
-                 scan_kw: dict) -> str:
-    """Handle server meta-commands (prefixed with ``__``)."""
+def _handle_meta(cmd: str, picos: dict[str, PicoConnection]) -> dict:
+    """Handle server meta-commands (prefixed with ``__``).
+
+    ``__rescan__`` runs in the background and is handled by the router.
+    """
     if cmd == "__list__":
         info = [
             {"name": p.name, "port": p.port, "idn": p.idn}
             for p in picos.values()
         ]
-        return json.dumps({"ok": True, "data": info})
+        return {"ok": True, "data": info}
+
+    return {"ok": False, "error": f"Unknown meta command: {cmd}"}
+
+
+def _close_transport(pico: PicoConnection) -> None:
+    try:
+        pico.transport.close()
+    except Exception:
+        pass
+
+
+class _Router:
+    """Router loop state: connected Picos, their workers and open jobs."""
+
+    def __init__(self, context, frontend, scan_kw: dict):
+        import zmq
+
+        self._context = context
+        self._frontend = frontend
+        self._scan_kw = scan_kw
+        self._backend = context.socket(zmq.ROUTER)
+        self._backend.setsockopt(zmq.ROUTER_MANDATORY, 1)
+        # __rescan__ can give a departed Pico's name to a new worker
+        self._backend.setsockopt(zmq.ROUTER_HANDOVER, 1)
+        self._backend.bind(_BACKEND)
+        self._tokens = itertools.count()
+        self._jobs: dict[bytes, _Job] = {}
+        self.picos: dict[str, PicoConnection] = {}
+        self._workers: dict[str, PicoWorker] = {}
+        # Control replies still expected from workers
+        self._starting: set[str] = set()
+        self._stopping: set[str] = set()
+        # Clients waiting on the running rescan (None when idle)
+        self._rescan_waiters: list[list[bytes]] | None = None
+        self._rescan_result: dict[str, PicoConnection] = {}
+
+    def start_workers(self, picos: list[PicoConnection]) -> None:
+        for pico in picos:
+            self.picos[pico.name] = pico
+            worker = PicoWorker(pico, self._context)
+            self._workers[pico.name] = worker
+            self._starting.add(pico.name)
+            worker.start()
+        # ROUTER drops messages for peers that have not connected yet
+        while self._starting:
+            self.on_backend(self._backend.recv_multipart())
+
+    def stop_workers(self, names: list[str]) -> None:
+        """Stop workers after the commands already queued on them."""
+        for name in names:
+            self._backend.send_multipart([name.encode(), _STOP, b""])
+            self._stopping.add(name)
+        while self._stopping:
+            self.on_backend(self._backend.recv_multipart())
+        for name in names:
+            self._workers.pop(name).join()
+
+    def serve(self) -> None:
+        import zmq
+
+        poller = zmq.Poller()
+        poller.register(self._frontend, zmq.POLLIN)
+        poller.register(self._backend, zmq.POLLIN)
+        while True:
+            events = dict(poller.poll())
+            # Drain worker replies first so finished jobs go out promptly
+            while self._backend.poll(0):
+                self.on_backend(self._backend.recv_multipart())
+            if self._frontend in events:
+                self.on_request(self._frontend.recv_multipart())
+
+    def on_backend(self, frames: list[bytes]) -> None:
+        if frames[0] == _RESCAN:
+            self._finish_rescan()
+        elif frames[1] == _READY:
+            self._starting.discard(frames[0].decode())
+        elif frames[1] == _STOP:
+            self._stopping.discard(frames[0].decode())
+        else:
+            self._on_job_reply(frames)
+
+    def _on_job_reply(self, frames: list[bytes]) -> None:
+        name, token, payload = frames
+        job = self._jobs.get(token)
+        if job is None:
+            return
+        job.results[name.decode()] = json.loads(payload)
+        job.pending.discard(name.decode())
+        if not job.pending:
+            del self._jobs[token]
+            self._send(job.envelope, job.reply())
+
+    def on_request(self, frames: list[bytes]) -> None:
+        envelope, raw = frames[:-1], frames[-1]
+
+        # Parse request
+        try:
+            request = json.loads(raw)
+        except json.JSONDecodeError:
+            self._send(envelope, {"ok": False, "error": "Invalid JSON"})
+            return
+
+        cmd = request.get("cmd", "")
+        pico_name = request.get("pico")
+
+        # Meta commands
+        if cmd == "__rescan__":
+            self._start_rescan(envelope)
+            return
+        if cmd.startswith("__") and cmd.endswith("__"):
+            self._send(envelope, _handle_meta(cmd, self.picos))
+            return
+
+        # Resolve which Pico(s) to route to
+        if pico_name == _ALL_PICOS:
+            names = list(self.picos)
+            if not names:
+                self._send(envelope, {
+                    "ok": False,
+                    "error": "No Pico boards connected"
+                })
+                return
+        elif pico_name is None:
+            if len(self.picos) == 1:
+                names = list(self.picos)
+            elif len(self.picos) == 0:
+                self._send(envelope, {
+                    "ok": False,
+                    "error": "No Pico boards connected"
+                })
+                return
+            else:
+                self._send(envelope, {
+                    "ok": False,
+                    "error": (
+                        f"Multiple picos connected, specify one of: "
+                        f"{list(self.picos.keys())}"
+                    ),
+                })
+                return
+        else:
+            if pico_name not in self.picos:
+                self._send(envelope, {
+                    "ok": False,
+                    "error": (
+                        f"Unknown pico '{pico_name}'. "
+                        f"Available: {list(self.picos.keys())}"
+                    ),
+                })
+                return
+            names = [pico_name]
+
+        # Queue the SCPI command on each worker
+        token = str(next(self._tokens)).encode()
+        self._jobs[token] = _Job(envelope, names, pico_name == _ALL_PICOS)
+        for name in names:
+            self._backend.send_multipart([name.encode(), token, cmd.encode()])
+
+    def _start_rescan(self, envelope: list[bytes]) -> None:
+        """Probe new ports in a thread; the connected Picos stay in service."""
+        if self._rescan_waiters is not None:
+            self._rescan_waiters.append(envelope)
+            return
+        self._rescan_waiters = [envelope]
+        known = dict(self.picos)
+
+        def scan() -> None:
+            import zmq
 
-    if cmd == "__rescan__":
-        for p in picos.values():
             try:
-                p.transport.close()
-            except Exception:
-                pass
-        picos.clear()
-        picos.update(discover_picos(**scan_kw))
-        return json.dumps(
-            {"ok": True, "data": f"Found {len(picos)} pico(s)"}
+                self._rescan_result = discover_picos(known=known,
+                                                     **self._scan_kw)
+            except Exception as exc:
+                _log(f"Rescan failed: {exc}")
+                self._rescan_result = known
+            socket = self._context.socket(zmq.DEALER)
+            socket.setsockopt(zmq.IDENTITY, _RESCAN)
+            socket.connect(_BACKEND)
+            socket.send(b"")
+            socket.close()
+
+        threading.Thread(target=scan, name="rescan", daemon=True).start()
+
+    def _finish_rescan(self) -> None:
+        found = self._rescan_result
+        # By identity: a departed Pico's name can go to a new port
+        gone = [name for name, p in self.picos.items()
+                if found.get(name) is not p]
+        self.stop_workers(gone)
+        for name in gone:
+            _log(f"[{name}] gone from {self.picos[name].port}")
+            _close_transport(self.picos.pop(name))
+        self.start_workers(
+            [p for name, p in found.items() if name not in self.picos]
         )
+        reply = {"ok": True, "data": f"Found {len(self.picos)} pico(s)"}
+        for envelope in self._rescan_waiters:
+            self._send(envelope, reply)
+        self._rescan_waiters = None
+
+    def _send(self, envelope: list[bytes], reply: dict) -> None:
+        self._frontend.send_multipart(envelope + [json.dumps(reply).encode()])
 
-    return json.dumps({"ok": False, "error": f"Unknown meta command: {cmd}"})
+    def close(self) -> None:
+        self.stop_workers(list(self._workers))
+        for p in self.picos.values():
+            _close_transport(p)
+        self._backend.close()
 
 
 def run_server(
@@ -112,7 +434,7 @@ def run_server(
     """Start the ZMQ server loop.
 
     Args:
-        port: TCP port for the ZMQ REP socket.
+        port: TCP port for the ZMQ ROUTER socket (REQ clients connect here).
         scan_patterns: Glob patterns for serial port discovery.
         baudrate: Baud rate for Pico serial connections.
     """
@@ -130,88 +452,18 @@ def run_server(
     _log(f"Managing {len(picos)} Pico board(s)")
 
     context = zmq.Context()
-    socket = context.socket(zmq.REP)
+    socket = context.socket(zmq.ROUTER)
     socket.bind(f"tcp://*:{port}")
     _log(f"Listening on tcp://*:{port}")
 
+    router = _Router(context, socket, scan_kw)
+    router.start_workers(list(picos.values()))
     try:
-        while True:
-            raw = socket.recv_string()
-
-            # Parse request
-            try:
-                request = json.loads(raw)
-            except json.JSONDecodeError:
-                socket.send_string(
-                    json.dumps({"ok": False, "error": "Invalid JSON"})
-                )
-                continue
-
-            cmd = request.get("cmd", "")
-            pico_name = request.get("pico")
-
-            # Meta commands
-            if cmd.startswith("__") and cmd.endswith("__"):
-                reply = _handle_meta(cmd, picos, scan_kw)
-                socket.send_string(reply)
-                continue
-
-            # Resolve which Pico to route to
-            if pico_name is None:
-                if len(picos) == 1:
-                    pico = next(iter(picos.values()))
-                elif len(picos) == 0:
-                    socket.send_string(json.dumps({
-                        "ok": False,
-                        "error": "No Pico boards connected"
-                    }))
-                    continue
-                else:
-                    socket.send_string(json.dumps({
-                        "ok": False,
-                        "error": (
-                            f"Multiple picos connected, specify one of: "
-                            f"{list(picos.keys())}"
-                        ),
-                    }))
-                    continue
-            else:
-                pico = picos.get(pico_name)
-                if pico is None:
-                    socket.send_string(json.dumps({
-                        "ok": False,
-                        "error": (
-                            f"Unknown pico '{pico_name}'. "
-                            f"Available: {list(picos.keys())}"
-                        ),
-                    }))
-                    continue
-
-            # Forward SCPI command to the Pico
-            try:
-                _log(f"[{pico.name}] {cmd}")
-                result = pico.transport.send_command(cmd)
-                socket.send_string(json.dumps({"ok": True, "data": result}))
-            except GreyMatterError as exc:
-                _log(f"[{pico.name}] ERROR: {exc}")
-                socket.send_string(
-                    json.dumps({"ok": False, "error": str(exc)})
-                )
-            except Exception as exc:
-                _log(f"[{pico.name}] COMM ERROR: {exc}")
-                socket.send_string(json.dumps({
-                    "ok": False,
-                    "error": f"Communication error: {exc}",
-                }))
-
+        router.serve()
     except KeyboardInterrupt:
         _log("Shutting down")
     finally:
-        for p in picos.values():
-            try:
-                p.transport.close()
-            except Exception:
-                pass
+        router.close()
         socket.close()
         context.destroy()
 
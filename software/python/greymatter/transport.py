@@ -1,7 +1,12 @@
 from __future__ import annotations
 
+import binascii
+import struct
 import threading
+import time
 from abc import ABC, abstractmethod
+from collections import deque
+from concurrent.futures import Future, TimeoutError as FutureTimeout
 
 from .errors import GreyMatterError
 
@@ -14,6 +19,37 @@ _CONNECT_TIMEOUT = 5.0
 # Per-command timeout (seconds)
 _CMD_TIMEOUT = 2.0
 
+# Serial read timeout for the pipelined reader thread (seconds); bounds how
+# long close() waits for it
+_READ_POLL = 0.05
+
+# Binary protocol framing (see firmware include/binary_protocol.hpp)
+_BIN_SYNC = 0xA5
+_BIN_REPLY = 0x80
+_BIN_CH_ALL = 0xFF
+
+OP_NOP = 0x00
+OP_WRITE_CODE = 0x01
+OP_WRITE_UPDATE = 0x02
+OP_SET_SPAN = 0x03
+OP_LDAC = 0x04
+OP_FAULT_READ = 0x05
+OP_EXIT = 0x7F
+
+_BIN_STATUS = {
+    0x01: "bad CRC",
+    0x02: "bad opcode",
+    0x03: "bad length",
+    0x04: "invalid address",
+    0x05: "invalid value",
+    0x06: "busy (sequencer active)",
+}
+
+
+def _crc16(data: bytes, crc: int = 0xFFFF) -> int:
+    """CRC-16/CCITT (poly 0x1021, init 0xFFFF), matching the firmware."""
+    return binascii.crc_hqx(data, crc)
+
 
 class Transport(ABC):
     """Abstract transport for sending SCPI commands to a greymatter board."""
@@ -27,6 +63,24 @@ class Transport(ABC):
         """
         ...
 
+    def submit(self, cmd: str) -> Future:
+        """Send a command without waiting; the future resolves to the response.
+
+        Transports that cannot pipeline run the command now and return a
+        completed future.
+        """
+        future: Future = Future()
+        try:
+            future.set_result(self.send_command(cmd))
+        except Exception as exc:
+            future.set_exception(exc)
+        return future
+
+    def send_many(self, cmds) -> list[str]:
+        """Send several commands and return their responses in order."""
+        futures = [self.submit(cmd) for cmd in cmds]
+        return [f.result() for f in futures]
+
     @abstractmethod
     def close(self) -> None:
         """Release the underlying connection."""
@@ -44,11 +98,21 @@ class SerialTransport(Transport):
                  timeout: float = _CMD_TIMEOUT):
         import serial
         self._lock = threading.Lock()
+        self._binary = False
         self._ser = serial.Serial(port, baudrate, timeout=timeout)
+        # Ask for a prompt rather than waiting for the startup banner: an
+        # idle board never prints one. This also undoes quiet mode left by
+        # a pipelined session; a board still booting drops the line and
+        # ends its banner with a prompt instead.
+        self._ser.write(b"SYST:QUIET 0\n")
         self._drain_until_prompt(_CONNECT_TIMEOUT)
 
     def send_command(self, cmd: str) -> str:
         with self._lock:
+            if self._binary:
+                raise GreyMatterError(
+                    "Transport is in binary mode; call exit_binary() first"
+                )
             self._ser.reset_input_buffer()
             self._ser.write((cmd + "\n").encode("ascii"))
 
@@ -78,6 +142,112 @@ class SerialTransport(Transport):
         if self._ser and self._ser.is_open:
             self._ser.close()
 
+    # -- Binary protocol --
+
+    @property
+    def binary_mode(self) -> bool:
+        return self._binary
+
+    def enter_binary(self) -> None:
+        """Switch the link to the framed binary protocol (``SYST:BIN``)."""
+        with self._lock:
+            if self._binary:
+                return
+            self._ser.reset_input_buffer()
+            self._ser.write(b"SYST:BIN\n")
+            buf = b""
+            while not buf.endswith(b"\r\nOK\r\n"):
+                byte = self._ser.read(1)
+                if not byte:
+                    raise GreyMatterError("Timeout entering binary mode")
+                buf += byte
+                if buf.endswith(_PROMPT):
+                    raise GreyMatterError(
+                        buf.decode("ascii", errors="replace").strip()
+                    )
+            self._binary = True
+
+    def exit_binary(self) -> None:
+        """Return the link to SCPI text mode."""
+        if not self._binary:
+            return
+        self.binary_request(OP_EXIT)
+        with self._lock:
+            self._drain_until_prompt(self._ser.timeout)
+            self._binary = False
+
+    def binary_request(self, opcode: int, payload: bytes = b"") -> bytes:
+        """Send one binary frame and return the reply payload.
+
+        Raises GreyMatterError on timeout, a corrupt reply, or a non-zero
+        status from the firmware.
+        """
+        with self._lock:
+            if not self._binary:
+                raise GreyMatterError("Transport is not in binary mode")
+            body = struct.pack("<HB", len(payload), opcode) + payload
+            self._ser.write(bytes([_BIN_SYNC]) + body
+                            + struct.pack("<H", _crc16(body)))
+
+            while True:
+                byte = self._read_exact(1)
+                if byte[0] == _BIN_SYNC:
+                    break
+            header = self._read_exact(2)
+            (length,) = struct.unpack("<H", header)
+            rest = self._read_exact(length + 1 + 2)  # OPCODE, STATUS+PAYLOAD, CRC
+            frame = header + rest[:-2]
+            (crc,) = struct.unpack("<H", rest[-2:])
+            if _crc16(frame) != crc:
+                raise GreyMatterError("Binary reply failed CRC check")
+
+            reply_op, status = frame[2], frame[3]
+            if reply_op != (opcode | _BIN_REPLY):
+                raise GreyMatterError(
+                    f"Unexpected binary reply opcode 0x{reply_op:02X}"
+                )
+            if status != 0:
+                reason = _BIN_STATUS.get(status, f"status 0x{status:02X}")
+                raise GreyMatterError(f"ERROR:{reason}")
+            return frame[4:]
+
+    def write_codes(self, entries, update: bool = False) -> None:
+        """Write raw codes for ``(board, dac, channel, code)`` entries.
+
+        With ``update=False`` only the input registers are loaded; follow
+        with :meth:`pulse_ldac_binary` to commit them together.
+        """
+        payload = b"".join(struct.pack("<BBBH", b, d, c, code)
+                           for b, d, c, code in entries)
+        self.binary_request(OP_WRITE_UPDATE if update else OP_WRITE_CODE,
+                            payload)
+
+    def set_spans(self, entries) -> None:
+        """Set spans for ``(board, dac, channel, span)`` entries.
+
+        Use ``channel=None`` to set every channel on that DAC.
+        """
+        payload = b"".join(
+            struct.pack("<BBBB", b, d, _BIN_CH_ALL if c is None else c,
+                        int(span))
+            for b, d, c, span in entries
+        )
+        self.binary_request(OP_SET_SPAN, payload)
+
+    def pulse_ldac_binary(self) -> None:
+        self.binary_request(OP_LDAC)
+
+    def read_faults(self) -> tuple[bool, int]:
+        """Return ``(fault_line_active, 24-bit per-DAC fault mask)``."""
+        reply = self.binary_request(OP_FAULT_READ)
+        return bool(reply[0]), reply[1] | (reply[2] << 8) | (reply[3] << 16)
+
+    def _read_exact(self, n: int) -> bytes:
+        data = self._ser.read(n)
+        if len(data) != n:
+            raise GreyMatterError("Timeout waiting for binary reply")
+        return data
+
     def _drain_until_prompt(self, timeout: float) -> None:
         """Read and discard bytes until the '> ' prompt is seen."""
         old_timeout = self._ser.timeout
@@ -95,6 +265,135 @@ class SerialTransport(Transport):
             self._ser.timeout = old_timeout
 
 
+class PipelinedSerialTransport(Transport):
+    """USB serial connection with many commands in flight.
+
+    Switches the firmware to quiet mode (``SYST:QUIET 1``: no echo, no
+    prompt), where every command line yields exactly one response line.
+    Commands are written as soon as they are submitted. A reader thread
+    reads in bulk and resolves one future per response line, in order, so
+    the host never waits for a round trip between commands::
+
+        t = PipelinedSerialTransport("/dev/ttyACM0")
+        futures = [t.submit(f"BOARD0:DAC0:CH{c}:CURR 10") for c in range(5)]
+        print([f.result() for f in futures])
+
+    Responses must be single lines. ``CAL:DATA?`` and the binary protocol
+    need :class:`SerialTransport`. ``close()`` restores echo and prompt.
+
+    Unsolicited lines (``FAULT:NOTIFY 1`` sends ``!FAULT:...`` when the
+    fault state changes) are passed to ``on_notice`` from the reader
+    thread instead of being taken as a response.
+    """
+
+    def __init__(self, port: str, baudrate: int = 115200,
+                 timeout: float = _CMD_TIMEOUT, on_notice=None):
+        import serial
+        self._timeout = timeout
+        self._on_notice = on_notice
+        self._ser = serial.Serial(port, baudrate, timeout=_READ_POLL)
+        self._write_lock = threading.Lock()
+        self._pending: deque[Future] = deque()
+        self._buf = bytearray()
+        self._closed = False
+
+        self._enter_quiet()
+        self._reader = threading.Thread(
+            target=self._read_loop, name=f"greymatter-rx:{port}", daemon=True
+        )
+        self._reader.start()
+
+    def submit(self, cmd: str) -> Future:
+        if "\n" in cmd or "\r" in cmd:
+            raise ValueError("command must be a single line")
+        future: Future = Future()
+        data = (cmd + "\n").encode("ascii")
+        with self._write_lock:
+            if self._closed:
+                raise GreyMatterError("Transport is closed")
+            # Queue before writing: the reply can arrive before write() returns
+            self._pending.append(future)
+            self._ser.write(data)
+        return future
+
+    def send_command(self, cmd: str) -> str:
+        return self._wait(self.submit(cmd))
+
+    def send_many(self, cmds) -> list[str]:
+        futures = [self.submit(cmd) for cmd in cmds]
+        return [self._wait(f) for f in futures]
+
+    def close(self) -> None:
+        if self._closed:
+            return
+        try:
+            self.send_command("SYST:QUIET 0")
+        except Exception:
+            pass
+        with self._write_lock:
+            self._closed = True
+        self._reader.join(timeout=1.0)
+        self._fail_pending(GreyMatterError("Transport closed"))
+        if self._ser.is_open:
+            self._ser.close()
+
+    def _wait(self, future: Future) -> str:
+        try:
+            return future.result(timeout=self._timeout)
+        except FutureTimeout:
+            raise GreyMatterError("Timeout waiting for response")
+
+    def _enter_quiet(self) -> None:
+        # The reply is "OK\r\n" in either mode (after the echoed line in
+        # echo mode) and has no prompt after it. A prompt instead means the
+        # board was still booting and dropped the line, so send it again.
+        deadline = time.monotonic() + _CONNECT_TIMEOUT
+        while True:
+            self._buf.clear()
+            self._ser.write(b"SYST:QUIET 1\n")
+            if not self._read_until(
+                lambda: self._buf.endswith((b"OK\r\n", _PROMPT)), deadline
+            ):
+                raise GreyMatterError("No response to SYST:QUIET")
+            if self._buf.endswith(b"OK\r\n"):
+                break
+        self._buf.clear()
+
+    def _read_until(self, done, deadline: float) -> bool:
+        while not done():
+            if time.monotonic() > deadline:
+                return False
+            self._buf += self._ser.read(max(1, self._ser.in_waiting))
+        return True
+
+    def _read_loop(self) -> None:
+        try:
+            while not self._closed:
+                chunk = self._ser.read(max(1, self._ser.in_waiting))
+                if not chunk:
+                    continue
+                self._buf += chunk
+                while True:
+                    end = self._buf.find(b"\r\n")
+                    if end < 0:
+                        break
+                    line = self._buf[:end].decode("ascii", errors="replace")
+                    del self._buf[: end + 2]
+                    if line.startswith("!"):
+                        if self._on_notice is not None:
+                            self._on_notice(line[1:])
+                    elif self._pending:
+                        self._pending.popleft().set_result(line)
+        except Exception as exc:
+            self._fail_pending(GreyMatterError(f"Serial read failed: {exc}"))
+
+    def _fail_pending(self, exc: Exception) -> None:
+        while self._pending:
+            future = self._pending.popleft()
+            if not future.done():
+                future.set_exception(exc)
+
+
 class ZmqTransport(Transport):
     """Remote connection to a greymatter board via a ZMQ server.
 
@@ -115,24 +414,44 @@ class ZmqTransport(Transport):
         self._socket.connect(f"tcp://{address}:{port}")
 
     def send_command(self, cmd: str) -> str:
+        reply = self._request(self._pico, cmd)
+        if reply.get("ok"):
+            return reply.get("data", "")
+        else:
+            raise GreyMatterError(
+                reply.get("error", "Unknown server error")
+            )
+
+    def send_all(self, cmd: str) -> dict[str, str]:
+        """Run a command on every Pico the server manages, in parallel.
+
+        Returns a dict mapping Pico name -> response. Raises GreyMatterError
+        if any Pico failed.
+        """
+        reply = self._request("*", cmd)
+        if "data" not in reply:
+            raise GreyMatterError(reply.get("error", "Unknown server error"))
+        results = reply["data"]
+        failed = {n: r.get("error", "") for n, r in results.items()
+                  if not r.get("ok")}
+        if failed:
+            raise GreyMatterError(
+                "; ".join(f"{n}: {e}" for n, e in failed.items())
+            )
+        return {n: r.get("data", "") for n, r in results.items()}
+
+    def _request(self, pico: str | None, cmd: str) -> dict:
         import json
         import zmq
 
         with self._lock:
-            request = json.dumps({"pico": self._pico, "cmd": cmd})
+            request = json.dumps({"pico": pico, "cmd": cmd})
             try:
                 self._socket.send_string(request)
-                reply = json.loads(self._socket.recv_string())
+                return json.loads(self._socket.recv_string())
             except zmq.Again:
                 raise GreyMatterError("Server timeout")
 
-            if reply.get("ok"):
-                return reply.get("data", "")
-            else:
-                raise GreyMatterError(
-                    reply.get("error", "Unknown server error")
-                )
-
     def close(self) -> None:
         self._socket.close()
         self._context.destroy()
@@ -0,0 +1,207 @@
+#include "binary_protocol.hpp"
+#include "board_manager.hpp"
+#include "spi_manager.hpp"
+#include "utils.hpp"
+#include "pico/stdlib.h"
+
+// putchar_raw bypasses CR/LF translation
+static void stdio_output(uint8_t byte) {
+    putchar_raw(byte);
+}
+
+BinaryProtocol::BinaryProtocol(BoardManager& boards, SpiManager& spi)
+    : boards_(boards), spi_(spi), output_(stdio_output) {}
+
+void BinaryProtocol::reset() {
+    state_ = RxState::SYNC;
+    exit_requested_ = false;
+}
+
+void BinaryProtocol::feed(uint8_t byte) {
+    // A long gap inside a frame means the host gave up on it: resync
+    uint64_t now = time_us_64();
+    if (state_ != RxState::SYNC && (now - last_byte_us_) > BINARY::FRAME_TIMEOUT_US) {
+        state_ = RxState::SYNC;
+    }
+    last_byte_us_ = now;
+
+    switch (state_) {
+        case RxState::SYNC:
+            if (byte == BINARY::SYNC) state_ = RxState::LEN_L;
+            break;
+
+        case RxState::LEN_L:
+            frame_[0] = byte;
+            state_ = RxState::LEN_H;
+            break;
+
+        case RxState::LEN_H:
+            frame_[1] = byte;
+            length_ = static_cast<uint16_t>(frame_[0] | (byte << 8));
+            if (length_ > BINARY::MAX_PAYLOAD) {
+                // Cannot buffer it; report and wait for the next sync byte
+                send_reply(0, BINARY::STATUS_BAD_LENGTH, nullptr, 0);
+                state_ = RxState::SYNC;
+                break;
+            }
+            state_ = RxState::OPCODE;
+            break;
+
+        case RxState::OPCODE:
+            frame_[2] = byte;
+            received_ = 0;
+            state_ = (length_ > 0) ? RxState::PAYLOAD : RxState::CRC_L;
+            break;
+
+        case RxState::PAYLOAD:
+            frame_[3 + received_++] = byte;
+            if (received_ == length_) state_ = RxState::CRC_L;
+            break;
+
+        case RxState::CRC_L:
+            crc_ = byte;
+            state_ = RxState::CRC_H;
+            break;
+
+        case RxState::CRC_H:
+            crc_ |= static_cast<uint16_t>(byte << 8);
+            state_ = RxState::SYNC;
+            if (utils::crc16_ccitt(frame_, 3 + length_) != crc_) {
+                send_reply(frame_[2], BINARY::STATUS_BAD_CRC, nullptr, 0);
+            } else {
+                dispatch();
+            }
+            break;
+    }
+}
+
+void BinaryProtocol::dispatch() {
+    uint8_t opcode = frame_[2];
+    const uint8_t* payload = &frame_[3];
+
+    switch (opcode) {
+        case BINARY::OP_NOP:
+            send_reply(opcode, BINARY::STATUS_OK, nullptr, 0);
+            break;
+
+        case BINARY::OP_WRITE_CODE:
+        case BINARY::OP_WRITE_UPDATE:
+            send_reply(opcode, handle_write(payload, length_, opcode == BINARY::OP_WRITE_UPDATE),
+                       nullptr, 0);
+            break;
+
+        case BINARY::OP_SET_SPAN:
+            send_reply(opcode, handle_span(payload, length_), nullptr, 0);
+            break;
+
+        case BINARY::OP_LDAC:
+            boards_.pulse_ldac();
+            send_reply(opcode, BINARY::STATUS_OK, nullptr, 0);
+            break;
+
+        case BINARY::OP_FAULT_READ: {
+            // Cached by the FAULT IRQ (per-DAC mask is 0 in single-board mode)
+            FaultMonitor& faults = boards_.fault_monitor();
+            faults.refresh();
+            FaultState state = faults.state();
+            uint8_t reply[4] = {
+                static_cast<uint8_t>(state.active ? 1 : 0),
+                static_cast<uint8_t>(state.mask & 0xFF),
+                static_cast<uint8_t>((state.mask >> 8) & 0xFF),
+                static_cast<uint8_t>((state.mask >> 16) & 0xFF)
+            };
+            send_reply(opcode, BINARY::STATUS_OK, reply, sizeof(reply));
+            break;
+        }
+
+        case BINARY::OP_EXIT:
+            send_reply(opcode, BINARY::STATUS_OK, nullptr, 0);
+            exit_requested_ = true;
+            break;
+
+        default:
+            send_reply(opcode, BINARY::STATUS_BAD_OPCODE, nullptr, 0);
+            break;
+    }
+}
+
+uint8_t BinaryProtocol::handle_write(const uint8_t* payload, uint16_t len, bool update) {
+    if (len == 0 || len % BINARY::CODE_ENTRY_SIZE != 0) {
+        return BINARY::STATUS_BAD_LENGTH;
+    }
+
+    // A playback tick would commit staged codes before OP_LDAC
+    if (!update && boards_.sequencer().state() != SeqState::IDLE) {
+        return BINARY::STATUS_BUSY;
+    }
+
+    // Validate every entry before touching the bus
+    for (uint16_t i = 0; i < len; i += BINARY::CODE_ENTRY_SIZE) {
+        DacDevice* dac = boards_.get_dac(payload[i], payload[i + 1]);
+        if (!dac || payload[i + 2] >= dac->get_num_channels()) {
+            return BINARY::STATUS_BAD_ADDRESS;
+        }
+        uint16_t code = static_cast<uint16_t>(payload[i + 3] | (payload[i + 4] << 8));
+        if (code > dac->get_max_code()) {
+            return BINARY::STATUS_BAD_VALUE;
+        }
+    }
+
+    for (uint16_t i = 0; i < len; i += BINARY::CODE_ENTRY_SIZE) {
+        DacDevice* dac = boards_.get_dac(payload[i], payload[i + 1]);
+        uint16_t code = static_cast<uint16_t>(payload[i + 3] | (payload[i + 4] << 8));
+        if (update) {
+            boards_.write_channel(dac, payload[i + 2], code);
+        } else {
+            dac->write_code(payload[i + 2], code);
+        }
+    }
+    return BINARY::STATUS_OK;
+}
+
+uint8_t BinaryProtocol::handle_span(const uint8_t* payload, uint16_t len) {
+    if (len == 0 || len % BINARY::SPAN_ENTRY_SIZE != 0) {
+        return BINARY::STATUS_BAD_LENGTH;
+    }
+
+    for (uint16_t i = 0; i < len; i += BINARY::SPAN_ENTRY_SIZE) {
+        DacDevice* dac = boards_.get_dac(payload[i], payload[i + 1]);
+        uint8_t ch = payload[i + 2];
+        if (!dac || (ch != BINARY::CH_ALL && ch >= dac->get_num_channels())) {
+            return BINARY::STATUS_BAD_ADDRESS;
+        }
+        // LTC2664 spans stop at ±2.5V; LTC2662 leaves 0x9-0xE undefined
+        if (!dac->is_valid_span(payload[i + 3])) {
+            return BINARY::STATUS_BAD_VALUE;
+        }
+    }
+
+    for (uint16_t i = 0; i < len; i += BINARY::SPAN_ENTRY_SIZE) {
+        DacDevice* dac = boards_.get_dac(payload[i], payload[i + 1]);
+        if (payload[i + 2] == BINARY::CH_ALL) {
+            dac->set_span_all(payload[i + 3]);
+        } else {
+            dac->set_span(payload[i + 2], payload[i + 3]);
+        }
+    }
+    return BINARY::STATUS_OK;
+}
+
+void BinaryProtocol::send_reply(uint8_t opcode, uint8_t status,
+                                const uint8_t* payload, uint16_t len) {
+    // [LEN_L][LEN_H][OPCODE][STATUS][PAYLOAD] is covered by the CRC
+    uint8_t header[4] = {
+        static_cast<uint8_t>((len + 1) & 0xFF),
+        static_cast<uint8_t>(((len + 1) >> 8) & 0xFF),
+        static_cast<uint8_t>(opcode | BINARY::REPLY),
+        status
+    };
+    uint16_t crc = utils::crc16_ccitt(header, sizeof(header));
+    if (len > 0) crc = utils::crc16_ccitt(payload, len, crc);
+
+    output_(BINARY::SYNC);
+    for (uint8_t b : header) output_(b);
+    for (uint16_t i = 0; i < len; i++) output_(payload[i]);
+    output_(crc & 0xFF);
+    output_((crc >> 8) & 0xFF);
+}
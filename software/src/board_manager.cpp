@@ -1,10 +1,14 @@
 #include "board_manager.hpp"
-#include "utils.hpp"
 #include "cal_storage.hpp"
+#include "state_storage.hpp"
+#include "perf_stats.hpp"
+#include "utils.hpp"
 #include <cstdio>
 #include <cstring>
+#include <cstdlib>
 
-BoardManager::BoardManager(SpiManager& spi) : spi_(spi) {
+BoardManager::BoardManager(SpiManager& spi)
+    : spi_(spi), sequencer_(*this), faults_(spi), trigger_(*this) {
     // Initialize DAC pointers and storage
     // Each board has: DAC0=LTC2662, DAC1=LTC2662, DAC2=LTC2664
     for (uint8_t board = 0; board < NUM_BOARDS; board++) {
@@ -27,12 +31,15 @@ BoardManager::BoardManager(SpiManager& spi) : spi_(spi) {
                 calibration_[board][dac][ch].gain = 1.0f;
                 calibration_[board][dac][ch].offset = 0.0f;
                 calibration_[board][dac][ch].enabled = false;
+                table_index_[board][dac][ch] = -1;
             }
         }
     }
 }
 
 void BoardManager::init_all() {
+    uint64_t start_us = time_us_64();
+
     // Setup and initialize all DAC devices
     for (uint8_t board = 0; board < NUM_BOARDS; board++) {
         // Setup LTC2662 current DACs at device_id 0 and 1
@@ -48,17 +55,75 @@ void BoardManager::init_all() {
         voltage_dac_storage_[board].setup(&spi_, board, 2, resolution_[board][2]);
         voltage_dacs_[board] = &voltage_dac_storage_[board];
 
-        // Initialize each DAC
-        current_dacs_[board][0]->init();
-        current_dacs_[board][1]->init();
-        voltage_dacs_[board]->init();
+        current_dacs_[board][0]->set_write_elision(write_elision_);
+        current_dacs_[board][1]->set_write_elision(write_elision_);
+        voltage_dacs_[board]->set_write_elision(write_elision_);
     }
 
+    // Drop the empty slots, so nothing below (or later) clocks frames at them
+    fitted_boards_ = probe_boards();
+    for (uint8_t board = 0; board < NUM_BOARDS; board++) {
+        if (fitted_boards_ & (1u << board)) continue;
+        current_dacs_[board][0] = nullptr;
+        current_dacs_[board][1] = nullptr;
+        voltage_dacs_[board] = nullptr;
+    }
+
+    // Fault inputs of empty slots would only report phantom faults
+    uint32_t fitted_dacs = 0;
+    for (uint8_t board = 0; board < NUM_BOARDS; board++) {
+        if (fitted_boards_ & (1u << board)) fitted_dacs |= 0x7u << (board * DACS_PER_BOARD);
+    }
+    faults_.set_fitted(fitted_dacs);
+
+    // Initialize in one pass over the chips instead of per-chip init():
+    // default spans (lowest current range, most conservative voltage range)
+    // and zero-scale codes, all latched by a single LDAC. Writing the codes
+    // also clears anything a power-down (*RST) left in the input registers.
+    stage_span(DAC_MASK_CURRENT, LTC2662_SPAN::MA_3_125);
+    stage_span(DAC_MASK_VOLTAGE, LTC2664_SPAN::V_0_5);
+    stage_code(DAC_MASK_ALL, 0);
+    commit_staged(DAC_MASK_ALL);
+
     // Load calibration data from flash (if valid data exists)
-    CalStorage::load_from_flash(*this);
+    calibration_loaded_ = CalStorage::load_from_flash(*this);
+
+    // Outputs are configured once the queued frames are out
+    spi_.flush();
+    init_us_ = static_cast<uint32_t>(time_us_64() - start_us);
+}
+
+uint8_t BoardManager::probe_boards() {
+#ifdef SINGLE_BOARD_MODE
+    // The board the Pico sits on
+    return 0x01;
+#else
+    uint8_t found = 0;
+    for (uint8_t board = 0; board < NUM_BOARDS; board++) {
+        for (uint8_t dac_id = 0; dac_id < DACS_PER_BOARD; dac_id++) {
+            if (get_dac(board, dac_id)->probe()) {
+                found |= 1u << board;
+                break;
+            }
+        }
+    }
+    // No echo at all points at the bus (MISO), not an empty rack
+    probe_answered_ = found != 0;
+    if (!probe_answered_) return static_cast<uint8_t>((1u << NUM_BOARDS) - 1);
+    return found;
+#endif
+}
+
+void BoardManager::mark_ready() {
+    ready_us_ = time_us_64();
 }
 
 void BoardManager::reset_all() {
+    // Stop waveform playback before touching the DACs, and disarm the
+    // trigger, which would hold back the init commit
+    sequencer_.stop();
+    trigger_.set_armed(false);
+
     // Power down and re-initialize all DACs
     for (uint8_t board = 0; board < NUM_BOARDS; board++) {
         if (current_dacs_[board][0]) current_dacs_[board][0]->power_down_chip();
@@ -97,126 +162,562 @@ uint8_t BoardManager::get_resolution(uint8_t board, uint8_t dac) {
     return resolution_[board][dac];
 }
 
-std::string BoardManager::execute_idn() {
-    return "greymatter,DAC Controller,001,0.1"; // TODO: set some global variables to populate the version information
+ScpiError BoardManager::execute_idn(ResponseBuffer& out) {
+    out.set("greymatter,DAC Controller,001,0.1"); // TODO: set some global variables to populate the version information
+    return ScpiError::NONE;
 }
 
-std::string BoardManager::execute_fault_query() {
+// "OK", or the faulted DACs
+static void append_fault_state(const FaultState& state, ResponseBuffer& out) {
+    if (!state.active) {
+        out.append("OK");
+        return;
+    }
 #ifdef SINGLE_BOARD_MODE
     // Single-board mode: FAULT is NAND of all 3 DAC faults
     // Can only detect "any fault" vs "no fault", not which DAC
-    if (spi_.is_fault_active()) {
-        return "FAULT:ACTIVE";
-    }
-    return "OK";
+    out.append("FAULT:ACTIVE");
 #else
-    // Multi-board mode: Per-DAC fault detection via IO expanders
-    if (spi_.is_fault_active()) {
-        uint32_t faults = spi_.io_expander().read_faults();
-        char buf[32];
-        snprintf(buf, sizeof(buf), "FAULT:0x%06lX", faults);
-        return buf;
-    }
-    return "OK";
+    // Multi-board mode: Per-DAC fault mask captured from the IO expanders
+    out.appendf("FAULT:0x%06lX", (unsigned long)state.mask);
 #endif
 }
 
-std::string BoardManager::execute_set_voltage(const ScpiCommand& cmd) {
+ScpiError BoardManager::execute_fault_query(const ScpiCommand& cmd, ResponseBuffer& out) {
+    // Answered from the state cached by the FAULT IRQ; the expanders are
+    // only read here when an edge's capture was deferred or a fault has
+    // been asserted for a while
+    faults_.refresh();
+    FaultState state = faults_.state();
+
+    switch (cmd.type) {
+        case ScpiCommandType::FAULT_STATUS_QUERY:
+            // <active>,<mask>,<us since last change>,<edges>
+            out.appendf("%d,0x%06lX,%llu,%lu", state.active ? 1 : 0, (unsigned long)state.mask,
+                        (unsigned long long)(time_us_64() - state.changed_us),
+                        (unsigned long)state.edges);
+            return ScpiError::NONE;
+
+        case ScpiCommandType::FAULT_SET_NOTIFY:
+            faults_.set_notify(cmd.int_value != 0);
+            return out.ok();
+
+        case ScpiCommandType::FAULT_GET_NOTIFY:
+            out.set(faults_.notify() ? "1" : "0");
+            return ScpiError::NONE;
+
+        default:  // ScpiCommandType::FAULT_QUERY
+            append_fault_state(state, out);
+            return ScpiError::NONE;
+    }
+}
+
+bool BoardManager::take_fault_notice(ResponseBuffer& out) {
+    if (!faults_.notify()) return false;
+    faults_.refresh();
+    FaultState state;
+    if (!faults_.take_notice(state)) return false;
+    out.set("!");
+    append_fault_state(state, out);
+    return true;
+}
+
+ScpiError BoardManager::execute_set_voltage(const ScpiCommand& cmd, ResponseBuffer& out) {
     if (cmd.board_id < 0 || cmd.dac_id < 0 || cmd.channel_id < 0) {
-        return "ERROR:Missing address";
+        return out.fail(ScpiError::MISSING_ADDRESS);
     }
 
     // Voltage commands only apply to LTC2664 (DAC 2)
     if (cmd.dac_id != 2) {
-        return "ERROR:Use CURR for current DACs";
+        return out.fail(ScpiError::USE_CURR);
     }
 
     LTC2664* dac = voltage_dacs_[cmd.board_id];
     if (!dac) {
-        return "ERROR:DAC not initialized";
+        return out.fail(ScpiError::DAC_NOT_INITIALIZED);
     }
 
     if (cmd.channel_id >= dac->get_num_channels()) {
-        return "ERROR:Invalid channel";
+        return out.fail(ScpiError::INVALID_CHANNEL);
     }
 
-    // Apply calibration if enabled
-    // Calibrated output = (ideal_output * gain) + offset
-    float voltage = cmd.float_value;
-    const ChannelCalibration* cal = get_calibration(cmd.board_id, cmd.dac_id, cmd.channel_id);
-    if (cal && cal->enabled) {
-        voltage = (voltage * cal->gain) + cal->offset;
-    }
-
-    dac->set_voltage(cmd.channel_id, voltage);
-    return "OK";
+    write_channel(dac, cmd.channel_id,
+                  calibrated_voltage_code(cmd.board_id, cmd.channel_id, cmd.float_value));
+    return out.ok();
 }
 
-std::string BoardManager::execute_set_current(const ScpiCommand& cmd) {
+ScpiError BoardManager::execute_set_current(const ScpiCommand& cmd, ResponseBuffer& out) {
     if (cmd.board_id < 0 || cmd.dac_id < 0 || cmd.channel_id < 0) {
-        return "ERROR:Missing address";
+        return out.fail(ScpiError::MISSING_ADDRESS);
     }
 
     // Current commands only apply to LTC2662 (DAC 0, 1)
     if (cmd.dac_id == 2) {
-        return "ERROR:Use VOLT for voltage DACs";
+        return out.fail(ScpiError::USE_VOLT);
     }
 
     LTC2662* dac = current_dacs_[cmd.board_id][cmd.dac_id];
     if (!dac) {
-        return "ERROR:DAC not initialized";
+        return out.fail(ScpiError::DAC_NOT_INITIALIZED);
     }
 
     if (cmd.channel_id >= dac->get_num_channels()) {
-        return "ERROR:Invalid channel";
+        return out.fail(ScpiError::INVALID_CHANNEL);
     }
 
-    // Apply calibration if enabled
-    // Calibrated output = (ideal_output * gain) + offset
-    float current_ma = cmd.float_value;
-    const ChannelCalibration* cal = get_calibration(cmd.board_id, cmd.dac_id, cmd.channel_id);
-    if (cal && cal->enabled) {
-        current_ma = (current_ma * cal->gain) + cal->offset;
+    write_channel(dac, cmd.channel_id,
+                  calibrated_current_code(cmd.board_id, cmd.dac_id, cmd.channel_id,
+                                          cmd.float_value));
+    return out.ok();
+}
+
+uint16_t BoardManager::calibrated_voltage_code(uint8_t board, uint8_t channel, float voltage) {
+    const LTC2664* dac = voltage_dacs_[board];
+    return setpoint_code(board, 2, channel, voltage, dac->get_span(channel), dac->get_max_code());
+}
+
+uint16_t BoardManager::calibrated_current_code(uint8_t board, uint8_t dac, uint8_t channel,
+                                               float current_ma) {
+    const LTC2662* chip = current_dacs_[board][dac];
+    return setpoint_code(board, dac, channel, current_ma, chip->get_span(channel),
+                         chip->get_max_code());
+}
+
+uint16_t BoardManager::setpoint_code(uint8_t board, uint8_t dac, uint8_t channel, float value,
+                                     uint8_t span, uint16_t max_code) {
+    const ChannelCalibration& cal = calibration_[board][dac][channel];
+    int8_t table = table_index_[board][dac][channel];
+    float min, max;
+
+    if (cal.enabled && table >= 0) {
+        PiecewiseTransform& t = table_transforms_[table];
+        if (!t.matches(span, max_code)) {
+            const CalibrationTable& points = tables_[table];
+            output_range(board, dac, channel, min, max);
+            t = PiecewiseTransform::build(points.input, points.output, points.count,
+                                          min, max, max_code, span);
+        }
+        return t.code(value);
     }
 
-    dac->set_current_ma(cmd.channel_id, current_ma);
-    return "OK";
+    SetpointTransform& t = transforms_[board][dac][channel];
+    if (!t.matches(span, max_code)) {
+        // Calibrated output = (ideal_output * gain) + offset
+        output_range(board, dac, channel, min, max);
+        t = SetpointTransform::build(cal.enabled ? cal.gain : 1.0f, cal.enabled ? cal.offset : 0.0f,
+                                     min, max, max_code, span);
+    }
+    return t.code(value);
+}
+
+void BoardManager::output_range(uint8_t board, uint8_t dac, uint8_t channel,
+                                float& min, float& max) const {
+    if (dac == 2) {
+        min = voltage_dacs_[board]->get_min_voltage(channel);
+        max = voltage_dacs_[board]->get_max_voltage(channel);
+    } else {
+        min = 0.0f;
+        max = current_dacs_[board][dac]->get_full_scale_ma(channel);
+    }
 }
 
-std::string BoardManager::execute_set_code(const ScpiCommand& cmd) {
+ScpiError BoardManager::execute_set_code(const ScpiCommand& cmd, ResponseBuffer& out) {
     if (cmd.board_id < 0 || cmd.dac_id < 0 || cmd.channel_id < 0) {
-        return "ERROR:Missing address";
+        return out.fail(ScpiError::MISSING_ADDRESS);
     }
 
     DacDevice* dac = get_dac(cmd.board_id, cmd.dac_id);
     if (!dac) {
-        return "ERROR:DAC not initialized";
+        return out.fail(ScpiError::DAC_NOT_INITIALIZED);
     }
 
     if (cmd.channel_id >= dac->get_num_channels()) {
-        return "ERROR:Invalid channel";
+        return out.fail(ScpiError::INVALID_CHANNEL);
     }
 
     // Validate code is within DAC's resolution range
     if (cmd.int_value > dac->get_max_code()) {
-        char buf[64];
-        snprintf(buf, sizeof(buf), "ERROR:Code exceeds max (%u for %u-bit)",
+        return out.fail(ScpiError::CODE_EXCEEDS_MAX, " (%u for %u-bit)",
                  dac->get_max_code(), dac->get_resolution());
-        return buf;
     }
 
-    dac->write_and_update(cmd.channel_id, cmd.int_value);
-    return "OK";
+    write_channel(dac, cmd.channel_id, cmd.int_value);
+    return out.ok();
 }
 
-std::string BoardManager::execute_set_span(const ScpiCommand& cmd) {
+ScpiError BoardManager::execute_set_all_code(const ScpiCommand& cmd, ResponseBuffer& out) {
     if (cmd.board_id < 0 || cmd.dac_id < 0) {
-        return "ERROR:Missing address";
+        return out.fail(ScpiError::MISSING_ADDRESS);
     }
 
     DacDevice* dac = get_dac(cmd.board_id, cmd.dac_id);
     if (!dac) {
-        return "ERROR:DAC not initialized";
+        return out.fail(ScpiError::DAC_NOT_INITIALIZED);
+    }
+
+    if (cmd.int_value > dac->get_max_code()) {
+        return out.fail(ScpiError::CODE_EXCEEDS_MAX, " (%u for %u-bit)",
+                 dac->get_max_code(), dac->get_resolution());
+    }
+
+    if (trigger_.armed()) {
+        dac->write_code_all(cmd.int_value);  // Committed by the trigger edge
+    } else {
+        dac->write_and_update_all(cmd.int_value);
+    }
+    return out.ok();
+}
+
+ScpiError BoardManager::execute_broadcast(const ScpiCommand& cmd, ResponseBuffer& out) {
+    // Staged chip by chip, like APPLY: a playback tick would commit part of it
+    if (sequencer_.state() != SeqState::IDLE) {
+        return out.fail(ScpiError::SEQ_ACTIVE);
+    }
+
+    // Validate against every targeted chip before touching any of them
+    // (empty slots are left out of the broadcast)
+    for (uint8_t board = 0; board < NUM_BOARDS; board++) {
+        for (uint8_t dac_id = 0; dac_id < DACS_PER_BOARD; dac_id++) {
+            if (!(cmd.dac_mask & (1u << dac_id))) continue;
+            DacDevice* dac = get_dac(board, dac_id);
+            if (!dac) continue;
+            if (cmd.type == ScpiCommandType::BCAST_CODE && cmd.int_value > dac->get_max_code()) {
+                return out.fail(ScpiError::CODE_EXCEEDS_MAX, " (%u for %u-bit)",
+                         dac->get_max_code(), dac->get_resolution());
+            }
+        }
+    }
+
+    if (cmd.type == ScpiCommandType::BCAST_SPAN) {
+        // The same code is a current range on one type and a voltage
+        // range on the other (BCAST:DAC0:2:SPAN, BCAST:DAC(@0,2):SPAN)
+        if ((cmd.dac_mask & DAC_MASK_CURRENT) && (cmd.dac_mask & DAC_MASK_VOLTAGE)) {
+            return out.fail(ScpiError::BCAST_MIXED_SPAN);
+        }
+        bool valid = (cmd.dac_mask & DAC_MASK_VOLTAGE) ? LTC2664_SPAN::is_valid(cmd.int_value)
+                                                       : LTC2662_SPAN::is_valid(cmd.int_value);
+        if (!valid) {
+            return out.fail(ScpiError::INVALID_SPAN_CODE);
+        }
+        broadcast_span(cmd.dac_mask, static_cast<uint8_t>(cmd.int_value));
+    } else {
+        broadcast_code(cmd.dac_mask, cmd.int_value);
+    }
+    return out.ok();
+}
+
+void BoardManager::broadcast_code(uint8_t dac_mask, uint16_t code) {
+    stage_code(dac_mask, code);
+    commit_staged(dac_mask);
+}
+
+void BoardManager::broadcast_span(uint8_t dac_mask, uint8_t span_code) {
+    stage_span(dac_mask, span_code);
+    commit_staged(dac_mask);
+}
+
+void BoardManager::stage_code(uint8_t dac_mask, uint16_t code) {
+    for (uint8_t board = 0; board < NUM_BOARDS; board++) {
+        for (uint8_t dac_id = 0; dac_id < DACS_PER_BOARD; dac_id++) {
+            if (!(dac_mask & (1u << dac_id))) continue;
+            DacDevice* dac = get_dac(board, dac_id);
+            if (dac) dac->write_code_all(code);
+        }
+    }
+}
+
+void BoardManager::stage_span(uint8_t dac_mask, uint8_t span_code) {
+    for (uint8_t board = 0; board < NUM_BOARDS; board++) {
+        for (uint8_t dac_id = 0; dac_id < DACS_PER_BOARD; dac_id++) {
+            if (!(dac_mask & (1u << dac_id))) continue;
+            DacDevice* dac = get_dac(board, dac_id);
+            if (dac) dac->set_span_all(span_code);
+        }
+    }
+}
+
+void BoardManager::capture_output_state(OutputState& state) const {
+    memset(&state, 0, sizeof(state));
+    for (uint8_t board = 0; board < NUM_BOARDS; board++) {
+        for (uint8_t dac_id = 0; dac_id < DACS_PER_BOARD; dac_id++) {
+            DacOutputState& chip = state.dacs[board][dac_id];
+            const DacDevice* dac = (dac_id < 2) ? static_cast<const DacDevice*>(current_dacs_[board][dac_id])
+                                                : voltage_dacs_[board];
+            if (!dac) continue;
+            chip.resolution = dac->get_resolution();
+            for (uint8_t ch = 0; ch < dac->get_num_channels(); ch++) {
+                chip.span[ch] = (dac_id < 2) ? current_dacs_[board][dac_id]->get_span(ch)
+                                             : voltage_dacs_[board]->get_span(ch);
+                chip.code[ch] = dac->get_dac_code(ch);
+            }
+        }
+    }
+}
+
+ScpiError BoardManager::restore_output_state(const OutputState& state) {
+    for (uint8_t board = 0; board < NUM_BOARDS; board++) {
+        for (uint8_t dac_id = 0; dac_id < DACS_PER_BOARD; dac_id++) {
+            const DacOutputState& chip = state.dacs[board][dac_id];
+            DacDevice* dac = get_dac(board, dac_id);
+            if (!dac) {
+                // Absent then and now (resolution 0) is fine
+                if (chip.resolution != 0) return ScpiError::SNAP_MISMATCH;
+                continue;
+            }
+            if (chip.resolution != dac->get_resolution()) return ScpiError::SNAP_MISMATCH;
+            for (uint8_t ch = 0; ch < dac->get_num_channels(); ch++) {
+                if (!dac->is_valid_span(chip.span[ch]) || chip.code[ch] > dac->get_max_code()) {
+                    return ScpiError::SNAP_MISMATCH;
+                }
+            }
+        }
+    }
+
+    for (uint8_t board = 0; board < NUM_BOARDS; board++) {
+        for (uint8_t dac_id = 0; dac_id < DACS_PER_BOARD; dac_id++) {
+            const DacOutputState& chip = state.dacs[board][dac_id];
+            DacDevice* dac = get_dac(board, dac_id);
+            if (!dac) continue;
+            uint8_t num_ch = dac->get_num_channels();
+
+            // Spans and then codes, into the input registers of one chip at a time
+            bool same_span = true;
+            bool same_code = true;
+            for (uint8_t ch = 1; ch < num_ch; ch++) {
+                same_span = same_span && chip.span[ch] == chip.span[0];
+                same_code = same_code && chip.code[ch] == chip.code[0];
+            }
+            if (same_span) {
+                dac->set_span_all(chip.span[0]);
+            } else {
+                for (uint8_t ch = 0; ch < num_ch; ch++) dac->set_span(ch, chip.span[ch]);
+            }
+            if (same_code) {
+                dac->write_code_all(chip.code[0]);
+            } else {
+                for (uint8_t ch = 0; ch < num_ch; ch++) dac->write_code(ch, chip.code[ch]);
+            }
+        }
+    }
+    commit_staged(DAC_MASK_ALL);
+    return ScpiError::NONE;
+}
+
+void BoardManager::commit_staged(uint8_t dac_mask) {
+    if (trigger_.armed()) return;  // The trigger edge commits everything staged
+
+#ifdef SINGLE_BOARD_MODE
+    // No LDAC line in single-board mode: software update each selected chip
+    for (uint8_t dac_id = 0; dac_id < DACS_PER_BOARD; dac_id++) {
+        if (!(dac_mask & (1u << dac_id))) continue;
+        DacDevice* dac = get_dac(0, dac_id);
+        if (dac) dac->update_all();
+    }
+#else
+    (void)dac_mask;  // LDAC latches every chip at once
+    pulse_ldac();
+#endif
+}
+
+// Readback queries answer from the DAC-register shadow (no SPI traffic): the
+// code the output is actually driving, converted back through the span and,
+// when enabled, the inverse of the channel calibration.
+
+ScpiError BoardManager::execute_get_voltage(const ScpiCommand& cmd, ResponseBuffer& out) {
+    if (cmd.board_id < 0 || cmd.dac_id < 0 || cmd.channel_id < 0) {
+        return out.fail(ScpiError::MISSING_ADDRESS);
+    }
+
+    if (cmd.dac_id != 2) {
+        return out.fail(ScpiError::USE_CURR);
+    }
+
+    LTC2664* dac = voltage_dacs_[cmd.board_id];
+    if (!dac) {
+        return out.fail(ScpiError::DAC_NOT_INITIALIZED);
+    }
+
+    if (cmd.channel_id >= dac->get_num_channels()) {
+        return out.fail(ScpiError::INVALID_CHANNEL);
+    }
+
+    append_readback(cmd.type, cmd.board_id, 2, cmd.channel_id, out);
+    return ScpiError::NONE;
+}
+
+ScpiError BoardManager::execute_get_current(const ScpiCommand& cmd, ResponseBuffer& out) {
+    if (cmd.board_id < 0 || cmd.dac_id < 0 || cmd.channel_id < 0) {
+        return out.fail(ScpiError::MISSING_ADDRESS);
+    }
+
+    if (cmd.dac_id == 2) {
+        return out.fail(ScpiError::USE_VOLT);
+    }
+
+    LTC2662* dac = current_dacs_[cmd.board_id][cmd.dac_id];
+    if (!dac) {
+        return out.fail(ScpiError::DAC_NOT_INITIALIZED);
+    }
+
+    if (cmd.channel_id >= dac->get_num_channels()) {
+        return out.fail(ScpiError::INVALID_CHANNEL);
+    }
+
+    append_readback(cmd.type, cmd.board_id, cmd.dac_id, cmd.channel_id, out);
+    return ScpiError::NONE;
+}
+
+ScpiError BoardManager::execute_get_code(const ScpiCommand& cmd, ResponseBuffer& out) {
+    if (cmd.board_id < 0 || cmd.dac_id < 0 || cmd.channel_id < 0) {
+        return out.fail(ScpiError::MISSING_ADDRESS);
+    }
+
+    DacDevice* dac = get_dac(cmd.board_id, cmd.dac_id);
+    if (!dac) {
+        return out.fail(ScpiError::DAC_NOT_INITIALIZED);
+    }
+
+    if (cmd.channel_id >= dac->get_num_channels()) {
+        return out.fail(ScpiError::INVALID_CHANNEL);
+    }
+
+    append_readback(cmd.type, cmd.board_id, cmd.dac_id, cmd.channel_id, out);
+    return ScpiError::NONE;
+}
+
+void BoardManager::append_readback(ScpiCommandType type, uint8_t board, uint8_t dac_id,
+                                   uint8_t channel, ResponseBuffer& out) {
+    if (type == ScpiCommandType::GET_VOLTAGE) {
+        LTC2664* dac = voltage_dacs_[board];
+        float voltage = dac->code_to_voltage(channel, dac->get_dac_code(channel));
+        out.appendf("%.6f", uncalibrated_value(board, 2, channel, voltage));
+    } else if (type == ScpiCommandType::GET_CURRENT) {
+        LTC2662* dac = current_dacs_[board][dac_id];
+        float current_ma = dac->code_to_current_ma(channel, dac->get_dac_code(channel));
+        out.appendf("%.6f", uncalibrated_value(board, dac_id, channel, current_ma));
+    } else {
+        out.appendf("%u", get_dac(board, dac_id)->get_dac_code(channel));
+    }
+}
+
+float BoardManager::uncalibrated_value(uint8_t board, uint8_t dac, uint8_t channel,
+                                       float output) const {
+    const ChannelCalibration* cal = get_calibration(board, dac, channel);
+    const CalibrationTable* table = get_cal_table(board, dac, channel);
+    if (cal && cal->enabled && table) {
+        // Segment holding the output (assumes the outputs increase with the inputs)
+        uint8_t i = 0;
+        while (i + 2 < table->count && output >= table->output[i + 1]) i++;
+        float rise = table->output[i + 1] - table->output[i];
+        if (rise == 0.0f) return table->input[i];
+        return table->input[i] +
+               (output - table->output[i]) * (table->input[i + 1] - table->input[i]) / rise;
+    }
+
+    // Undo calibrated output = (ideal_output * gain) + offset
+    if (cal && cal->enabled && cal->gain != 0.0f) {
+        return (output - cal->offset) / cal->gain;
+    }
+    return output;
+}
+
+void BoardManager::set_write_elision(bool enable) {
+    write_elision_ = enable;
+    for (uint8_t board = 0; board < NUM_BOARDS; board++) {
+        for (uint8_t dac_id = 0; dac_id < DACS_PER_BOARD; dac_id++) {
+            DacDevice* dac = get_dac(board, dac_id);
+            if (dac) dac->set_write_elision(enable);
+        }
+    }
+}
+
+uint32_t BoardManager::get_elided_writes() const {
+    uint32_t total = 0;
+    for (uint8_t board = 0; board < NUM_BOARDS; board++) {
+        if (current_dacs_[board][0]) total += current_dacs_[board][0]->get_elided_writes();
+        if (current_dacs_[board][1]) total += current_dacs_[board][1]->get_elided_writes();
+        if (voltage_dacs_[board]) total += voltage_dacs_[board]->get_elided_writes();
+    }
+    return total;
+}
+
+ScpiError BoardManager::execute_write_elision(const ScpiCommand& cmd, ResponseBuffer& out) {
+    switch (cmd.type) {
+        case ScpiCommandType::SYST_SET_ELIDE:
+            if (cmd.int_value > 1) {
+                return out.fail(ScpiError::ELISION_0_OR_1);
+            }
+            set_write_elision(cmd.int_value != 0);
+            return out.ok();
+
+        case ScpiCommandType::SYST_GET_ELIDE:
+            out.set(write_elision_ ? "1" : "0");
+            return ScpiError::NONE;
+
+        default:  // ScpiCommandType::SYST_ELIDE_COUNT_QUERY
+            out.appendf("%lu", (unsigned long)get_elided_writes());
+            return ScpiError::NONE;
+    }
+}
+
+void BoardManager::write_channel(DacDevice* dac, uint8_t channel, uint16_t code) {
+    if (trigger_.armed()) {
+        dac->write_code(channel, code);  // Committed by the trigger edge
+    } else {
+        dac->write_and_update(channel, code);
+    }
+}
+
+void BoardManager::on_external_trigger(bool commit) {
+    if (commit) commit_staged(DAC_MASK_ALL);
+    if (sequencer_.get_trigger_source() == SeqTrigger::EXTERNAL) {
+        sequencer_.trigger();  // Only starts an armed sequence
+    }
+}
+
+ScpiError BoardManager::execute_trigger(const ScpiCommand& cmd, ResponseBuffer& out) {
+    switch (cmd.type) {
+        case ScpiCommandType::TRIG_SET_ARM:
+            // Every playback tick pulses LDAC, which would commit the staged writes
+            if (cmd.int_value != 0 && sequencer_.state() == SeqState::RUNNING) {
+                return out.fail(ScpiError::SEQ_ACTIVE);
+            }
+            trigger_.set_armed(cmd.int_value != 0);
+            return out.ok();
+
+        case ScpiCommandType::TRIG_GET_ARM:
+            out.set(trigger_.armed() ? "1" : "0");
+            return ScpiError::NONE;
+
+        default:  // ScpiCommandType::TRIG_COUNT_QUERY
+            out.appendf("%lu", (unsigned long)trigger_.edges());
+            return ScpiError::NONE;
+    }
+}
+
+void BoardManager::pulse_ldac() {
+    spi_.pulse_ldac();
+#ifndef SINGLE_BOARD_MODE
+    for (uint8_t board = 0; board < NUM_BOARDS; board++) {
+        for (uint8_t dac_id = 0; dac_id < DACS_PER_BOARD; dac_id++) {
+            DacDevice* dac = get_dac(board, dac_id);
+            if (dac) dac->latch_inputs();
+        }
+    }
+#endif
+}
+
+ScpiError BoardManager::execute_set_span(const ScpiCommand& cmd, ResponseBuffer& out) {
+    if (cmd.board_id < 0 || cmd.dac_id < 0) {
+        return out.fail(ScpiError::MISSING_ADDRESS);
+    }
+
+    DacDevice* dac = get_dac(cmd.board_id, cmd.dac_id);
+    if (!dac) {
+        return out.fail(ScpiError::DAC_NOT_INITIALIZED);
+    }
+    if (!dac->is_valid_span(cmd.int_value)) {
+        return out.fail(ScpiError::INVALID_SPAN_VALUE);
     }
 
     if (cmd.type == ScpiCommandType::SET_ALL_SPAN) {
@@ -228,15 +729,15 @@ std::string BoardManager::execute_set_span(const ScpiCommand& cmd) {
     } else { // ScpiCommandType::SET_SPAN
         // Need channel for single-channel span
         if (cmd.channel_id < 0) {
-            return "ERROR:Missing channel";
+            return out.fail(ScpiError::MISSING_CHANNEL);
         }
         dac->set_span(cmd.channel_id, static_cast<uint8_t>(cmd.int_value));
     }
 
-    return "OK";
+    return out.ok();
 }
 
-std::string BoardManager::execute_update(const ScpiCommand& cmd) {
+ScpiError BoardManager::execute_update(const ScpiCommand& cmd, ResponseBuffer& out) {
     if (cmd.type == ScpiCommandType::UPDATE_ALL) {
         // Update all DACs on all boards
         for (uint8_t board = 0; board < NUM_BOARDS; board++) {
@@ -244,67 +745,69 @@ std::string BoardManager::execute_update(const ScpiCommand& cmd) {
             if (current_dacs_[board][1]) current_dacs_[board][1]->update_all();
             if (voltage_dacs_[board]) voltage_dacs_[board]->update_all();
         }
-        spi_.pulse_ldac();  // Global LDAC pulse
-        return "OK";
+        pulse_ldac();  // Global LDAC pulse
+        return out.ok();
     }
 
     if (cmd.board_id < 0 || cmd.dac_id < 0) {
-        return "ERROR:Missing address";
+        return out.fail(ScpiError::MISSING_ADDRESS);
     }
 
     DacDevice* dac = get_dac(cmd.board_id, cmd.dac_id);
     if (!dac) {
-        return "ERROR:DAC not initialized";
+        return out.fail(ScpiError::DAC_NOT_INITIALIZED);
     }
 
     dac->update_all();
-    return "OK";
+    return out.ok();
 }
 
-std::string BoardManager::execute_power_down(const ScpiCommand& cmd) {
+ScpiError BoardManager::execute_power_down(const ScpiCommand& cmd, ResponseBuffer& out) {
     if (cmd.board_id < 0 || cmd.dac_id < 0) {
-        return "ERROR:Missing address";
+        return out.fail(ScpiError::MISSING_ADDRESS);
     }
 
     DacDevice* dac = get_dac(cmd.board_id, cmd.dac_id);
     if (!dac) {
-        return "ERROR:DAC not initialized";
+        return out.fail(ScpiError::DAC_NOT_INITIALIZED);
     }
 
     if (cmd.type == ScpiCommandType::POWER_DOWN_CHIP) {
         dac->power_down_chip();
     } else {
         if (cmd.channel_id < 0) {
-            return "ERROR:Missing channel";
+            return out.fail(ScpiError::MISSING_CHANNEL);
         }
         dac->power_down(cmd.channel_id);
     }
 
-    return "OK";
+    return out.ok();
 }
 
-std::string BoardManager::execute_get_resolution(const ScpiCommand& cmd) {
+ScpiError BoardManager::execute_get_resolution(const ScpiCommand& cmd, ResponseBuffer& out) {
     if (cmd.board_id < 0 || cmd.dac_id < 0) {
-        return "ERROR:Missing address";
+        return out.fail(ScpiError::MISSING_ADDRESS);
     }
 
     DacDevice* dac = get_dac(cmd.board_id, cmd.dac_id);
     if (!dac) {
-        return "ERROR:DAC not initialized";
+        return out.fail(ScpiError::DAC_NOT_INITIALIZED);
     }
 
-    char buf[16];
-    snprintf(buf, sizeof(buf), "%u", dac->get_resolution());
-    return buf;
+    out.appendf("%u", dac->get_resolution());
+    return ScpiError::NONE;
 }
 
-std::string BoardManager::execute_set_resolution(const ScpiCommand& cmd) {
+ScpiError BoardManager::execute_set_resolution(const ScpiCommand& cmd, ResponseBuffer& out) {
     if (cmd.board_id < 0 || cmd.dac_id < 0) {
-        return "ERROR:Missing address";
+        return out.fail(ScpiError::MISSING_ADDRESS);
     }
 
     if (cmd.board_id >= NUM_BOARDS || cmd.dac_id >= DACS_PER_BOARD) {
-        return "ERROR:Invalid board/DAC";
+        return out.fail(ScpiError::INVALID_BOARD_DAC);
+    }
+    if (!get_dac(cmd.board_id, cmd.dac_id)) {
+        return out.fail(ScpiError::DAC_NOT_INITIALIZED);
     }
 
     uint8_t new_res = static_cast<uint8_t>(cmd.int_value);
@@ -314,22 +817,26 @@ std::string BoardManager::execute_set_resolution(const ScpiCommand& cmd) {
     if (cmd.dac_id < 2) {
         uint8_t idx = cmd.board_id * 2 + cmd.dac_id;
         current_dac_storage_[idx].setup(&spi_, cmd.board_id, cmd.dac_id, new_res);
-        current_dacs_[cmd.board_id][cmd.dac_id]->init();
     } else {
         voltage_dac_storage_[cmd.board_id].setup(&spi_, cmd.board_id, 2, new_res);
-        voltage_dacs_[cmd.board_id]->init();
     }
 
-    return "OK";
+    // Zero-scale codes as in init_all(), so the chip matches the cleared
+    // shadow instead of latching whatever its input registers held
+    DacDevice* dac = get_dac(cmd.board_id, cmd.dac_id);
+    dac->write_code_all(0);
+    dac->init();
+
+    return out.ok();
 }
 
-void BoardManager::set_serial_number(uint8_t board, const std::string& serial) {
+void BoardManager::set_serial_number(uint8_t board, const char* serial) {
     if (board >= NUM_BOARDS) return;
-    strncpy(serial_numbers_[board], serial.c_str(), SERIAL_NUMBER_MAX_LEN - 1);
+    strncpy(serial_numbers_[board], serial, SERIAL_NUMBER_MAX_LEN - 1);
     serial_numbers_[board][SERIAL_NUMBER_MAX_LEN - 1] = '\0';
 }
 
-std::string BoardManager::get_serial_number(uint8_t board) const {
+const char* BoardManager::get_serial_number(uint8_t board) const {
     if (board >= NUM_BOARDS) return "";
     return serial_numbers_[board];
 }
@@ -337,6 +844,7 @@ std::string BoardManager::get_serial_number(uint8_t board) const {
 void BoardManager::set_cal_gain(uint8_t board, uint8_t dac, uint8_t channel, float gain) {
     if (board >= NUM_BOARDS || dac >= DACS_PER_BOARD || channel >= MAX_CHANNELS_PER_DAC) return;
     calibration_[board][dac][channel].gain = gain;
+    transforms_[board][dac][channel].valid = false;
 }
 
 float BoardManager::get_cal_gain(uint8_t board, uint8_t dac, uint8_t channel) const {
@@ -347,6 +855,7 @@ float BoardManager::get_cal_gain(uint8_t board, uint8_t dac, uint8_t channel) co
 void BoardManager::set_cal_offset(uint8_t board, uint8_t dac, uint8_t channel, float offset) {
     if (board >= NUM_BOARDS || dac >= DACS_PER_BOARD || channel >= MAX_CHANNELS_PER_DAC) return;
     calibration_[board][dac][channel].offset = offset;
+    transforms_[board][dac][channel].valid = false;
 }
 
 float BoardManager::get_cal_offset(uint8_t board, uint8_t dac, uint8_t channel) const {
@@ -357,6 +866,7 @@ float BoardManager::get_cal_offset(uint8_t board, uint8_t dac, uint8_t channel)
 void BoardManager::set_cal_enable(uint8_t board, uint8_t dac, uint8_t channel, bool enable) {
     if (board >= NUM_BOARDS || dac >= DACS_PER_BOARD || channel >= MAX_CHANNELS_PER_DAC) return;
     calibration_[board][dac][channel].enabled = enable;
+    transforms_[board][dac][channel].valid = false;
 }
 
 bool BoardManager::get_cal_enable(uint8_t board, uint8_t dac, uint8_t channel) const {
@@ -369,6 +879,56 @@ const ChannelCalibration* BoardManager::get_calibration(uint8_t board, uint8_t d
     return &calibration_[board][dac][channel];
 }
 
+ScpiError BoardManager::set_cal_table(uint8_t board, uint8_t dac, uint8_t channel,
+                                      const float* input, const float* output, uint8_t count) {
+    if (board >= NUM_BOARDS || dac >= DACS_PER_BOARD || channel >= MAX_CHANNELS_PER_DAC) {
+        return ScpiError::INVALID_CHANNEL;
+    }
+    int8_t& index = table_index_[board][dac][channel];
+
+    if (count == 0) {
+        if (index >= 0) {
+            tables_[index].count = 0;
+            table_transforms_[index].segments = 0;
+            index = -1;
+        }
+        return ScpiError::NONE;
+    }
+
+    if (count < 2 || count > CAL_MAX_POINTS) return ScpiError::INVALID_CAL_TABLE;
+    for (uint8_t i = 0; i < count; i++) {
+        // Also rejects NaN, which every comparison fails
+        if (!(input[i] >= -SETPOINT::VALUE_LIMIT && input[i] <= SETPOINT::VALUE_LIMIT) ||
+            !(output[i] >= -SETPOINT::VALUE_LIMIT && output[i] <= SETPOINT::VALUE_LIMIT) ||
+            (i > 0 && !(input[i] > input[i - 1]))) {
+            return ScpiError::INVALID_CAL_TABLE;
+        }
+    }
+
+    if (index < 0) {
+        for (int8_t i = 0; i < static_cast<int8_t>(CAL_MAX_TABLES); i++) {
+            if (tables_[i].count == 0) {
+                index = i;
+                break;
+            }
+        }
+        if (index < 0) return ScpiError::CAL_TABLES_FULL;
+    }
+
+    CalibrationTable& table = tables_[index];
+    table.count = count;
+    std::memcpy(table.input, input, count * sizeof(float));
+    std::memcpy(table.output, output, count * sizeof(float));
+    table_transforms_[index].segments = 0;
+    return ScpiError::NONE;
+}
+
+const CalibrationTable* BoardManager::get_cal_table(uint8_t board, uint8_t dac, uint8_t channel) const {
+    if (board >= NUM_BOARDS || dac >= DACS_PER_BOARD || channel >= MAX_CHANNELS_PER_DAC) return nullptr;
+    int8_t index = table_index_[board][dac][channel];
+    return index >= 0 ? &tables_[index] : nullptr;
+}
+
 void BoardManager::clear_all_calibration() {
     for (uint8_t board = 0; board < NUM_BOARDS; board++) {
         serial_numbers_[board][0] = '\0';
@@ -377,21 +937,31 @@ void BoardManager::clear_all_calibration() {
                 calibration_[board][dac][ch].gain = 1.0f;
                 calibration_[board][dac][ch].offset = 0.0f;
                 calibration_[board][dac][ch].enabled = false;
+                transforms_[board][dac][ch].valid = false;
+                table_index_[board][dac][ch] = -1;
             }
         }
     }
+    for (uint8_t i = 0; i < CAL_MAX_TABLES; i++) {
+        tables_[i].count = 0;
+        table_transforms_[i].segments = 0;
+    }
 }
 
-std::string BoardManager::export_calibration_data() const {
+// "<in>,<out>,..." for CAL:TABL? and CAL:DATA?
+static void append_table(const CalibrationTable& table, ResponseBuffer& out) {
+    for (uint8_t i = 0; i < table.count; i++) {
+        out.appendf(i ? ",%.7g,%.7g" : "%.7g,%.7g", table.input[i], table.output[i]);
+    }
+}
+
+void BoardManager::export_calibration_data(ResponseBuffer& out) const {
     // Export calibration data in a compact format
     // Format: BOARD<n>:SN=<serial>;DAC<m>:CH<c>:G=<gain>,O=<offset>,E=<0|1>
-    std::string result;
-    char buf[128];
-
+    // plus DAC<m>:CH<c>:T=<in>,<out>,... for channels with a table
     for (uint8_t board = 0; board < NUM_BOARDS; board++) {
         // Output board header with serial number
-        snprintf(buf, sizeof(buf), "BOARD%d:SN=%s\n", board, serial_numbers_[board]);
-        result += buf;
+        out.appendf("BOARD%d:SN=%s\n", board, serial_numbers_[board]);
 
         for (uint8_t dac = 0; dac < DACS_PER_BOARD; dac++) {
             uint8_t num_ch = (dac < 2) ? LTC2662::NUM_CHANNELS : LTC2664::NUM_CHANNELS;
@@ -399,156 +969,321 @@ std::string BoardManager::export_calibration_data() const {
                 const ChannelCalibration& cal = calibration_[board][dac][ch];
                 // Only output non-default calibrations
                 if (cal.enabled || cal.gain != 1.0f || cal.offset != 0.0f) {
-                    snprintf(buf, sizeof(buf), "  DAC%d:CH%d:G=%.6f,O=%.6f,E=%d\n",
-                             dac, ch, cal.gain, cal.offset, cal.enabled ? 1 : 0);
-                    result += buf;
+                    out.appendf("  DAC%d:CH%d:G=%.6f,O=%.6f,E=%d\n",
+                                dac, ch, cal.gain, cal.offset, cal.enabled ? 1 : 0);
+                }
+                const CalibrationTable* table = get_cal_table(board, dac, ch);
+                if (table) {
+                    out.appendf("  DAC%d:CH%d:T=", dac, ch);
+                    append_table(*table, out);
+                    out.append("\n");
                 }
             }
         }
     }
-
-    return result;
 }
 
-std::string BoardManager::execute_set_serial(const ScpiCommand& cmd) {
+ScpiError BoardManager::execute_set_serial(const ScpiCommand& cmd, ResponseBuffer& out) {
     if (cmd.board_id < 0 || cmd.board_id >= NUM_BOARDS) {
-        return "ERROR:Invalid board";
+        return out.fail(ScpiError::INVALID_BOARD);
     }
     set_serial_number(cmd.board_id, cmd.string_value);
-    return "OK";
+    return out.ok();
 }
 
-std::string BoardManager::execute_get_serial(const ScpiCommand& cmd) {
+ScpiError BoardManager::execute_get_serial(const ScpiCommand& cmd, ResponseBuffer& out) {
     if (cmd.board_id < 0 || cmd.board_id >= NUM_BOARDS) {
-        return "ERROR:Invalid board";
-    }
-    std::string sn = get_serial_number(cmd.board_id);
-    if (sn.empty()) {
-        return "(not set)";
+        return out.fail(ScpiError::INVALID_BOARD);
     }
-    return sn;
+    const char* sn = get_serial_number(cmd.board_id);
+    out.set(sn[0] ? sn : "(not set)");
+    return ScpiError::NONE;
 }
 
-std::string BoardManager::execute_set_cal_gain(const ScpiCommand& cmd) {
+ScpiError BoardManager::execute_set_cal_gain(const ScpiCommand& cmd, ResponseBuffer& out) {
     if (cmd.board_id < 0 || cmd.dac_id < 0 || cmd.channel_id < 0) {
-        return "ERROR:Missing address";
+        return out.fail(ScpiError::MISSING_ADDRESS);
     }
     DacDevice* dac = get_dac(cmd.board_id, cmd.dac_id);
     if (!dac || cmd.channel_id >= dac->get_num_channels()) {
-        return "ERROR:Invalid channel";
+        return out.fail(ScpiError::INVALID_CHANNEL);
     }
     set_cal_gain(cmd.board_id, cmd.dac_id, cmd.channel_id, cmd.float_value);
-    return "OK";
+    return out.ok();
 }
 
-std::string BoardManager::execute_get_cal_gain(const ScpiCommand& cmd) {
+ScpiError BoardManager::execute_get_cal_gain(const ScpiCommand& cmd, ResponseBuffer& out) {
     if (cmd.board_id < 0 || cmd.dac_id < 0 || cmd.channel_id < 0) {
-        return "ERROR:Missing address";
+        return out.fail(ScpiError::MISSING_ADDRESS);
     }
     DacDevice* dac = get_dac(cmd.board_id, cmd.dac_id);
     if (!dac || cmd.channel_id >= dac->get_num_channels()) {
-        return "ERROR:Invalid channel";
+        return out.fail(ScpiError::INVALID_CHANNEL);
     }
-    char buf[32];
-    snprintf(buf, sizeof(buf), "%.6f", get_cal_gain(cmd.board_id, cmd.dac_id, cmd.channel_id));
-    return buf;
+    out.appendf("%.6f", get_cal_gain(cmd.board_id, cmd.dac_id, cmd.channel_id));
+    return ScpiError::NONE;
 }
 
-std::string BoardManager::execute_set_cal_offset(const ScpiCommand& cmd) {
+ScpiError BoardManager::execute_set_cal_offset(const ScpiCommand& cmd, ResponseBuffer& out) {
     if (cmd.board_id < 0 || cmd.dac_id < 0 || cmd.channel_id < 0) {
-        return "ERROR:Missing address";
+        return out.fail(ScpiError::MISSING_ADDRESS);
     }
     DacDevice* dac = get_dac(cmd.board_id, cmd.dac_id);
     if (!dac || cmd.channel_id >= dac->get_num_channels()) {
-        return "ERROR:Invalid channel";
+        return out.fail(ScpiError::INVALID_CHANNEL);
     }
     set_cal_offset(cmd.board_id, cmd.dac_id, cmd.channel_id, cmd.float_value);
-    return "OK";
+    return out.ok();
 }
 
-std::string BoardManager::execute_get_cal_offset(const ScpiCommand& cmd) {
+ScpiError BoardManager::execute_get_cal_offset(const ScpiCommand& cmd, ResponseBuffer& out) {
     if (cmd.board_id < 0 || cmd.dac_id < 0 || cmd.channel_id < 0) {
-        return "ERROR:Missing address";
+        return out.fail(ScpiError::MISSING_ADDRESS);
     }
     DacDevice* dac = get_dac(cmd.board_id, cmd.dac_id);
     if (!dac || cmd.channel_id >= dac->get_num_channels()) {
-        return "ERROR:Invalid channel";
+        return out.fail(ScpiError::INVALID_CHANNEL);
     }
-    char buf[32];
-    snprintf(buf, sizeof(buf), "%.6f", get_cal_offset(cmd.board_id, cmd.dac_id, cmd.channel_id));
-    return buf;
+    out.appendf("%.6f", get_cal_offset(cmd.board_id, cmd.dac_id, cmd.channel_id));
+    return ScpiError::NONE;
 }
 
-std::string BoardManager::execute_set_cal_enable(const ScpiCommand& cmd) {
+ScpiError BoardManager::execute_set_cal_enable(const ScpiCommand& cmd, ResponseBuffer& out) {
     if (cmd.board_id < 0 || cmd.dac_id < 0 || cmd.channel_id < 0) {
-        return "ERROR:Missing address";
+        return out.fail(ScpiError::MISSING_ADDRESS);
     }
     DacDevice* dac = get_dac(cmd.board_id, cmd.dac_id);
     if (!dac || cmd.channel_id >= dac->get_num_channels()) {
-        return "ERROR:Invalid channel";
+        return out.fail(ScpiError::INVALID_CHANNEL);
     }
     set_cal_enable(cmd.board_id, cmd.dac_id, cmd.channel_id, cmd.int_value != 0);
-    return "OK";
+    return out.ok();
 }
 
-std::string BoardManager::execute_get_cal_enable(const ScpiCommand& cmd) {
+ScpiError BoardManager::execute_get_cal_enable(const ScpiCommand& cmd, ResponseBuffer& out) {
     if (cmd.board_id < 0 || cmd.dac_id < 0 || cmd.channel_id < 0) {
-        return "ERROR:Missing address";
+        return out.fail(ScpiError::MISSING_ADDRESS);
     }
     DacDevice* dac = get_dac(cmd.board_id, cmd.dac_id);
     if (!dac || cmd.channel_id >= dac->get_num_channels()) {
-        return "ERROR:Invalid channel";
+        return out.fail(ScpiError::INVALID_CHANNEL);
     }
-    return get_cal_enable(cmd.board_id, cmd.dac_id, cmd.channel_id) ? "1" : "0";
+    out.set(get_cal_enable(cmd.board_id, cmd.dac_id, cmd.channel_id) ? "1" : "0");
+    return ScpiError::NONE;
 }
 
-std::string BoardManager::execute_cal_data_query() {
-    return export_calibration_data();
+// Skip whitespace and at most one comma between fields of a value list
+static const char* skip_separator(const char* p) {
+    while (*p == ' ' || *p == '\t') p++;
+    if (*p == ',') p++;
+    while (*p == ' ' || *p == '\t') p++;
+    return p;
+}
+
+ScpiError BoardManager::execute_set_cal_table(const ScpiCommand& cmd, ResponseBuffer& out) {
+    if (cmd.board_id < 0 || cmd.dac_id < 0 || cmd.channel_id < 0) {
+        return out.fail(ScpiError::MISSING_ADDRESS);
+    }
+    DacDevice* dac = get_dac(cmd.board_id, cmd.dac_id);
+    if (!dac || cmd.channel_id >= dac->get_num_channels()) {
+        return out.fail(ScpiError::INVALID_CHANNEL);
+    }
+
+    float input[CAL_MAX_POINTS];
+    float output[CAL_MAX_POINTS];
+    uint8_t count = 0;
+    const char* p = cmd.string_value;
+
+    if (std::strncmp(p, "NONE", 4) == 0 || std::strncmp(p, "none", 4) == 0) {
+        p += 4;
+    } else {
+        // The whole table in one line: <in0>,<out0>,<in1>,<out1>,...
+        while (*p) {
+            if (count == CAL_MAX_POINTS) return out.fail(ScpiError::INVALID_CAL_TABLE);
+            char* end;
+            input[count] = std::strtof(p, &end);
+            if (end == p) return out.fail(ScpiError::INVALID_CAL_TABLE);
+            p = skip_separator(end);
+            output[count] = std::strtof(p, &end);
+            if (end == p) return out.fail(ScpiError::INVALID_CAL_TABLE);
+            p = skip_separator(end);
+            count++;
+        }
+        if (count < 2) return out.fail(ScpiError::INVALID_CAL_TABLE);
+    }
+    while (*p == ' ' || *p == '\t') p++;
+    if (*p) return out.fail(ScpiError::INVALID_CAL_TABLE);
+
+    ScpiError err = set_cal_table(cmd.board_id, cmd.dac_id, cmd.channel_id, input, output, count);
+    if (err != ScpiError::NONE) return out.fail(err);
+    return out.ok();
 }
 
-std::string BoardManager::execute_cal_clear() {
+ScpiError BoardManager::execute_get_cal_table(const ScpiCommand& cmd, ResponseBuffer& out) {
+    if (cmd.board_id < 0 || cmd.dac_id < 0 || cmd.channel_id < 0) {
+        return out.fail(ScpiError::MISSING_ADDRESS);
+    }
+    DacDevice* dac = get_dac(cmd.board_id, cmd.dac_id);
+    if (!dac || cmd.channel_id >= dac->get_num_channels()) {
+        return out.fail(ScpiError::INVALID_CHANNEL);
+    }
+    const CalibrationTable* table = get_cal_table(cmd.board_id, cmd.dac_id, cmd.channel_id);
+    if (!table) {
+        out.set("NONE");
+    } else {
+        append_table(*table, out);
+    }
+    return ScpiError::NONE;
+}
+
+ScpiError BoardManager::execute_cal_data_query(ResponseBuffer& out) {
+    export_calibration_data(out);
+    if (out.truncated()) {
+        // A cut-off export would read as a complete one
+        return out.fail(ScpiError::REPLY_TOO_LONG);
+    }
+    return ScpiError::NONE;
+}
+
+// Calibration image transfer: the query side builds a fresh image for every
+// chunk; uploads collect here until the last byte arrives
+static CalStorage::FlashCalibrationData image_tx;
+static CalStorage::FlashCalibrationData image_rx;
+static uint16_t image_rx_length = 0;
+static char image_text[utils::base64_length(CalStorage::CAL_IMAGE_CHUNK) + 1];
+
+ScpiError BoardManager::execute_cal_image_query(const ScpiCommand& cmd, ResponseBuffer& out) {
+    // Reply: <image size>,<base64 of up to CAL_IMAGE_CHUNK bytes from offset>
+    uint16_t offset = cmd.int_value;
+    if (offset >= CalStorage::CAL_IMAGE_SIZE) {
+        return out.fail(ScpiError::INVALID_CAL_IMAGE_CHUNK);
+    }
+    CalStorage::build_image(*this, image_tx);
+    uint16_t length = CalStorage::CAL_IMAGE_SIZE - offset;
+    if (length > CalStorage::CAL_IMAGE_CHUNK) length = CalStorage::CAL_IMAGE_CHUNK;
+    utils::base64_encode(reinterpret_cast<const uint8_t*>(&image_tx) + offset, length, image_text);
+    out.appendf("%u,", static_cast<unsigned>(CalStorage::CAL_IMAGE_SIZE));
+    out.append(image_text);
+    return ScpiError::NONE;
+}
+
+ScpiError BoardManager::execute_cal_image(const ScpiCommand& cmd, ResponseBuffer& out) {
+    // <offset>,<base64>; offset 0 starts a new upload, later chunks continue it
+    char* end;
+    long offset = std::strtol(cmd.string_value, &end, 10);
+    if (end == cmd.string_value || offset < 0 ||
+        (offset != 0 && offset != image_rx_length)) {
+        return out.fail(ScpiError::INVALID_CAL_IMAGE_CHUNK);
+    }
+    const char* text = skip_separator(end);
+    size_t text_length = std::strlen(text);
+    while (text_length > 0 && (text[text_length - 1] == ' ' || text[text_length - 1] == '\t')) {
+        text_length--;
+    }
+
+    uint8_t* image = reinterpret_cast<uint8_t*>(&image_rx);
+    int32_t length = utils::base64_decode(text, text_length, image + offset,
+                                          CalStorage::CAL_IMAGE_SIZE - offset);
+    if (length <= 0) {
+        image_rx_length = 0;
+        return out.fail(ScpiError::INVALID_CAL_IMAGE_CHUNK);
+    }
+    image_rx_length = static_cast<uint16_t>(offset + length);
+
+    if (image_rx_length == CalStorage::CAL_IMAGE_SIZE) {
+        image_rx_length = 0;
+        if (!CalStorage::apply_image(*this, image_rx)) {
+            return out.fail(ScpiError::CAL_IMAGE_REJECTED);
+        }
+    }
+    return out.ok();
+}
+
+ScpiError BoardManager::execute_cal_clear(ResponseBuffer& out) {
     clear_all_calibration();
     // Also erase from flash
     CalStorage::erase_flash();
-    return "OK";
+    return out.ok();
 }
 
-std::string BoardManager::execute_cal_save() {
+ScpiError BoardManager::execute_cal_save(ResponseBuffer& out) {
     if (CalStorage::save_to_flash(*this)) {
-        return "OK";
+        return out.ok();
     }
-    return "ERROR:Flash write failed";
+    return out.fail(ScpiError::FLASH_WRITE_FAILED);
 }
 
-std::string BoardManager::execute_cal_load() {
+ScpiError BoardManager::execute_cal_load(ResponseBuffer& out) {
     if (CalStorage::load_from_flash(*this)) {
-        return "OK";
+        return out.ok();
     }
-    return "ERROR:No valid calibration data";
+    return out.fail(ScpiError::NO_CAL_DATA);
 }
 
-std::string BoardManager::execute_dac_fault_query(const ScpiCommand& cmd) {
+ScpiError BoardManager::execute_snapshot(const ScpiCommand& cmd, ResponseBuffer& out) {
+    ScpiError err = ScpiError::NONE;
+    switch (cmd.type) {
+        case ScpiCommandType::SNAP_SAVE:
+            err = StateStorage::save(*this, cmd.string_value);
+            break;
+
+        case ScpiCommandType::SNAP_RESTORE:
+            // The sequencer owns the outputs while it runs
+            if (sequencer_.state() != SeqState::IDLE) {
+                return out.fail(ScpiError::SEQ_ACTIVE);
+            }
+            err = StateStorage::restore(*this, cmd.string_value);
+            break;
+
+        case ScpiCommandType::SNAP_DELETE:
+            err = StateStorage::erase(cmd.string_value);
+            break;
+
+        case ScpiCommandType::SNAP_LIST_QUERY:
+            StateStorage::list(out);
+            return ScpiError::NONE;
+
+        case ScpiCommandType::SNAP_SET_BOOT: {
+            bool none = std::strcmp(cmd.string_value, "NONE") == 0 ||
+                        std::strcmp(cmd.string_value, "none") == 0;
+            err = StateStorage::set_boot(none ? nullptr : cmd.string_value);
+            break;
+        }
+
+        case ScpiCommandType::SNAP_GET_BOOT: {
+            const char* name = StateStorage::boot_name();
+            out.set(name ? name : "NONE");
+            return ScpiError::NONE;
+        }
+
+        default:
+            return out.fail(ScpiError::UNKNOWN_COMMAND);
+    }
+    return (err == ScpiError::NONE) ? out.ok() : out.fail(err);
+}
+
+ScpiError BoardManager::execute_dac_fault_query(const ScpiCommand& cmd, ResponseBuffer& out) {
     if (cmd.board_id < 0 || cmd.dac_id < 0) {
-        return "ERROR:Missing address";
+        return out.fail(ScpiError::MISSING_ADDRESS);
     }
 
     // Only valid for LTC2662 (DAC 0 or 1)
     if (cmd.dac_id == 2) {
-        return "ERROR:FAULT? only for current DACs (DAC 0,1)";
+        return out.fail(ScpiError::FAULT_CURRENT_ONLY);
     }
 
     LTC2662* dac = current_dacs_[cmd.board_id][cmd.dac_id];
-    if (!dac) return "ERROR:DAC not initialized";
+    if (!dac) return out.fail(ScpiError::DAC_NOT_INITIALIZED);
 
     uint8_t fr = dac->read_fault_register();
-    if (fr == 0) return "OK";
+    if (fr == 0) return out.ok();
 
     // Build human-readable fault string
-    std::string result = "FAULT:";
+    out.set("FAULT:");
     bool first = true;
     auto append = [&](const char* name) {
-        if (!first) result += ",";
-        result += name;
+        if (!first) out.append(",");
+        out.append(name);
         first = false;
     };
 
@@ -561,134 +1296,533 @@ std::string BoardManager::execute_dac_fault_query(const ScpiCommand& cmd) {
     if (fr & 0x40) append("POWER_LIMIT");
     if (fr & 0x80) append("INVALID_SPI");
 
-    return result;
+    return ScpiError::NONE;
 }
 
-std::string BoardManager::execute_dac_echo_query(const ScpiCommand& cmd) {
+ScpiError BoardManager::execute_dac_echo_query(const ScpiCommand& cmd, ResponseBuffer& out) {
     if (cmd.board_id < 0 || cmd.dac_id < 0) {
-        return "ERROR:Missing address";
+        return out.fail(ScpiError::MISSING_ADDRESS);
     }
 
-    char buf[64];
     if (cmd.dac_id < 2) {
         // LTC2662: returns fault reg + 24-bit echo
         LTC2662* dac = current_dacs_[cmd.board_id][cmd.dac_id];
-        if (!dac) return "ERROR:DAC not initialized";
+        if (!dac) return out.fail(ScpiError::DAC_NOT_INITIALIZED);
 
         uint8_t fault_reg;
         uint32_t echo;
         dac->echo_readback(fault_reg, echo);
-        snprintf(buf, sizeof(buf), "FR=0x%02X ECHO=0x%06lX",
-                 fault_reg, (unsigned long)echo);
+        out.appendf("FR=0x%02X ECHO=0x%06lX", fault_reg, (unsigned long)echo);
     } else {
         // LTC2664: returns 32-bit echo
         LTC2664* dac = voltage_dacs_[cmd.board_id];
-        if (!dac) return "ERROR:DAC not initialized";
+        if (!dac) return out.fail(ScpiError::DAC_NOT_INITIALIZED);
 
         uint32_t echo = dac->echo_readback();
-        snprintf(buf, sizeof(buf), "ECHO=0x%08lX", (unsigned long)echo);
+        out.appendf("ECHO=0x%08lX", (unsigned long)echo);
+    }
+    return ScpiError::NONE;
+}
+
+ScpiError BoardManager::execute_apply(const ScpiCommand& cmd, ResponseBuffer& out) {
+    // Entry list: <board>,<dac>,<ch>,<value>[,<board>,<dac>,<ch>,<value>...]
+    // APPLY takes physical units (V for DAC 2, mA for DAC 0/1, calibrated);
+    // APPLY:CODE takes raw codes. Every entry is validated before any SPI
+    // traffic so a malformed batch leaves the outputs untouched.
+    const bool raw_code = (cmd.type == ScpiCommandType::APPLY_CODE);
+    const char* p = cmd.string_value;
+    size_t count = 0;
+
+    while (*p != '\0') {
+        if (count >= MAX_BATCH_ENTRIES) {
+            return out.fail(ScpiError::TOO_MANY_ENTRIES, " (max %u)", MAX_BATCH_ENTRIES);
+        }
+
+        // Address fields
+        long addr[3];
+        for (int i = 0; i < 3; i++) {
+            char* end;
+            addr[i] = std::strtol(p, &end, 10);
+            if (end == p) {
+                return out.fail(ScpiError::ENTRY_INVALID_ADDRESS, " %u", (unsigned)count);
+            }
+            p = skip_separator(end);
+        }
+
+        if (addr[0] < 0 || addr[0] >= NUM_BOARDS || addr[1] < 0 || addr[1] >= DACS_PER_BOARD) {
+            return out.fail(ScpiError::ENTRY_INVALID_BOARD_DAC, " %u", (unsigned)count);
+        }
+        uint8_t board = static_cast<uint8_t>(addr[0]);
+        uint8_t dac_id = static_cast<uint8_t>(addr[1]);
+
+        DacDevice* dac = get_dac(board, dac_id);
+        if (!dac) {
+            return out.fail(ScpiError::DAC_NOT_INITIALIZED);
+        }
+        if (addr[2] < 0 || addr[2] >= dac->get_num_channels()) {
+            return out.fail(ScpiError::ENTRY_INVALID_CHANNEL, " %u", (unsigned)count);
+        }
+        uint8_t channel = static_cast<uint8_t>(addr[2]);
+
+        // Value field
+        char* end;
+        uint16_t code;
+        if (raw_code) {
+            long v = std::strtol(p, &end, 0);
+            if (end == p || v < 0 || v > dac->get_max_code()) {
+                return out.fail(ScpiError::ENTRY_INVALID_CODE, " %u", (unsigned)count);
+            }
+            code = static_cast<uint16_t>(v);
+        } else {
+            float v = std::strtof(p, &end);
+            if (end == p) {
+                return out.fail(ScpiError::ENTRY_INVALID_VALUE, " %u", (unsigned)count);
+            }
+            code = (dac_id == 2) ? calibrated_voltage_code(board, channel, v)
+                                 : calibrated_current_code(board, dac_id, channel, v);
+        }
+        p = skip_separator(end);
+
+        batch_[count++] = {board, dac_id, channel, code};
+    }
+
+    // A playback tick would commit the batch halfway through loading it
+    if (sequencer_.state() != SeqState::IDLE) {
+        return out.fail(ScpiError::SEQ_ACTIVE);
+    }
+    write_batch(batch_, count);
+    return out.ok();
+}
+
+void BoardManager::write_batch(const BatchEntry* entries, size_t count) {
+    uint32_t touched = 0;  // Bit N = DAC index N (board * 3 + dac) was written
+
+    // Load input registers chip by chip so consecutive frames share the same
+    // decoder address; entries for the same channel keep their order (last wins)
+    for (uint8_t board = 0; board < NUM_BOARDS; board++) {
+        for (uint8_t dac_id = 0; dac_id < DACS_PER_BOARD; dac_id++) {
+            DacDevice* dac = get_dac(board, dac_id);
+            if (!dac) continue;
+            for (size_t i = 0; i < count; i++) {
+                if (entries[i].board == board && entries[i].dac == dac_id) {
+                    dac->write_code(entries[i].channel, entries[i].code);
+                    touched |= 1u << (board * DACS_PER_BOARD + dac_id);
+                }
+            }
+        }
+    }
+
+    if (!touched || trigger_.armed()) return;  // Armed: the trigger edge commits
+
+#ifdef SINGLE_BOARD_MODE
+    // No LDAC line in single-board mode: software update each touched chip
+    for (uint8_t dac_id = 0; dac_id < DACS_PER_BOARD; dac_id++) {
+        if (touched & (1u << dac_id)) {
+            get_dac(0, dac_id)->update_all();
+        }
+    }
+#else
+    // Single LDAC pulse commits every staged input register at once
+    pulse_ldac();
+#endif
+}
+
+ScpiError BoardManager::execute_range(const ScpiCommand& cmd, ResponseBuffer& out) {
+    // BOARD0:7:DAC0:1:CH0:4:CURR <value> and friends. Writes expand into one
+    // batch (grouped by chip, single commit, like APPLY); readbacks return a
+    // comma-separated list in board, DAC, channel order. Every addressed
+    // channel is validated before any SPI traffic.
+    const ScpiCommandType type = cmd.type;
+    const bool voltage = (type == ScpiCommandType::SET_VOLTAGE || type == ScpiCommandType::GET_VOLTAGE);
+    const bool current = (type == ScpiCommandType::SET_CURRENT || type == ScpiCommandType::GET_CURRENT);
+    const bool code = (type == ScpiCommandType::SET_CODE || type == ScpiCommandType::GET_CODE);
+    if (!voltage && !current && !code) {
+        return out.fail(ScpiError::RANGE_NOT_SUPPORTED);
+    }
+    if (!cmd.board_mask || !cmd.dac_mask || !cmd.channel_mask) {
+        return out.fail(ScpiError::MISSING_ADDRESS);
+    }
+    if (cmd.board_mask >> NUM_BOARDS) {
+        return out.fail(ScpiError::INVALID_BOARD);
+    }
+
+    size_t count = 0;
+    for (uint8_t board = 0; board < NUM_BOARDS; board++) {
+        if (!(cmd.board_mask & (1u << board))) continue;
+        for (uint8_t dac_id = 0; dac_id < DACS_PER_BOARD; dac_id++) {
+            if (!(cmd.dac_mask & (1u << dac_id))) continue;
+
+            if (voltage && dac_id != 2) {
+                return out.fail(ScpiError::USE_CURR);
+            }
+            if (current && dac_id == 2) {
+                return out.fail(ScpiError::USE_VOLT);
+            }
+            DacDevice* dac = get_dac(board, dac_id);
+            if (!dac) {
+                return out.fail(ScpiError::DAC_NOT_INITIALIZED);
+            }
+            if (cmd.channel_mask >> dac->get_num_channels()) {
+                return out.fail(ScpiError::INVALID_CHANNEL);
+            }
+            if (type == ScpiCommandType::SET_CODE && cmd.int_value > dac->get_max_code()) {
+                return out.fail(ScpiError::CODE_EXCEEDS_MAX, " (%u for %u-bit)",
+                                dac->get_max_code(), dac->get_resolution());
+            }
+
+            for (uint8_t ch = 0; ch < dac->get_num_channels(); ch++) {
+                if (!(cmd.channel_mask & (1u << ch))) continue;
+
+                if (cmd.is_query) {
+                    if (!out.empty()) out.append(",");
+                    append_readback(type, board, dac_id, ch, out);
+                    continue;
+                }
+
+                uint16_t value = cmd.int_value;
+                if (voltage) {
+                    value = calibrated_voltage_code(board, ch, cmd.float_value);
+                } else if (current) {
+                    value = calibrated_current_code(board, dac_id, ch, cmd.float_value);
+                }
+                batch_[count++] = {board, dac_id, ch, value};
+            }
+        }
+    }
+
+    if (cmd.is_query) {
+        return ScpiError::NONE;
     }
-    return buf;
+    if (sequencer_.state() != SeqState::IDLE) {
+        return out.fail(ScpiError::SEQ_ACTIVE);
+    }
+    write_batch(batch_, count);
+    return out.ok();
 }
 
-std::string BoardManager::execute(const ScpiCommand& cmd) {
+ScpiError BoardManager::execute_seq_data(const ScpiCommand& cmd, ResponseBuffer& out) {
+    if (cmd.board_id < 0 || cmd.dac_id < 0 || cmd.channel_id < 0) {
+        return out.fail(ScpiError::MISSING_ADDRESS);
+    }
+
+    DacDevice* dac = get_dac(cmd.board_id, cmd.dac_id);
+    if (!dac) {
+        return out.fail(ScpiError::DAC_NOT_INITIALIZED);
+    }
+    if (cmd.channel_id >= dac->get_num_channels()) {
+        return out.fail(ScpiError::INVALID_CHANNEL);
+    }
+    if (sequencer_.state() != SeqState::IDLE) {
+        return out.fail(ScpiError::SEQ_ACTIVE);
+    }
+
+    // Pass 1: validate the whole list so a bad code appends nothing
+    size_t count = 0;
+    const char* p = cmd.string_value;
+    while (*p != '\0') {
+        char* end;
+        long v = std::strtol(p, &end, 0);
+        if (end == p || v < 0 || v > dac->get_max_code()) {
+            return out.fail(ScpiError::SEQ_INVALID_CODE, " %u", (unsigned)count);
+        }
+        count++;
+        p = skip_separator(end);
+    }
+    if (count > sequencer_.samples_free()) {
+        return out.fail(ScpiError::SEQ_MEMORY_FULL);
+    }
+
+    // Pass 2: append in chunks
+    uint16_t chunk[64];
+    size_t n = 0;
+    p = cmd.string_value;
+    while (*p != '\0') {
+        char* end;
+        chunk[n++] = static_cast<uint16_t>(std::strtol(p, &end, 0));
+        p = skip_separator(end);
+        if (n == sizeof(chunk) / sizeof(chunk[0]) || *p == '\0') {
+            if (!sequencer_.append(dac, cmd.board_id, cmd.dac_id, cmd.channel_id, chunk, n)) {
+                return out.fail(ScpiError::SEQ_TOO_MANY_TRACKS);
+            }
+            n = 0;
+        }
+    }
+    return out.ok();
+}
+
+ScpiError BoardManager::execute_seq(const ScpiCommand& cmd, ResponseBuffer& out) {
+
+    switch (cmd.type) {
+        case ScpiCommandType::SEQ_CLEAR:
+            sequencer_.clear();
+            return out.ok();
+
+        case ScpiCommandType::SEQ_SET_RATE:
+            if (!sequencer_.set_rate(cmd.int_value)) {
+                return out.fail(ScpiError::SEQ_RATE_RANGE, " %lu-%lu Hz while stopped",
+                         (unsigned long)SEQ::MIN_RATE_HZ, (unsigned long)SEQ::MAX_RATE_HZ);
+            }
+            return out.ok();
+
+        case ScpiCommandType::SEQ_GET_RATE:
+            out.appendf("%lu", (unsigned long)sequencer_.get_rate());
+            return ScpiError::NONE;
+
+        case ScpiCommandType::SEQ_SET_LOOP:
+            sequencer_.set_loops(cmd.int_value);
+            return out.ok();
+
+        case ScpiCommandType::SEQ_GET_LOOP:
+            out.appendf("%lu", (unsigned long)sequencer_.get_loops());
+            return ScpiError::NONE;
+
+        case ScpiCommandType::SEQ_SET_TRIG_SOURCE:
+            sequencer_.set_trigger_source(static_cast<SeqTrigger>(cmd.int_value));
+            return out.ok();
+
+        case ScpiCommandType::SEQ_GET_TRIG_SOURCE: {
+            static const char* const SOURCES[] = {"IMM", "BUS", "EXT"};
+            out.set(SOURCES[static_cast<uint8_t>(sequencer_.get_trigger_source())]);
+            return ScpiError::NONE;
+        }
+
+        case ScpiCommandType::SEQ_START:
+            // BUS and EXTERNAL only arm; the trigger edge disarms before it starts playback
+            if (sequencer_.get_trigger_source() == SeqTrigger::IMMEDIATE && trigger_.armed()) {
+                return out.fail(ScpiError::TRIGGER_ARMED);
+            }
+            if (!sequencer_.start()) {
+                return out.fail(ScpiError::SEQ_NOT_LOADED);
+            }
+            return out.ok();
+
+        case ScpiCommandType::SEQ_TRIGGER:
+            if (trigger_.armed()) {
+                return out.fail(ScpiError::TRIGGER_ARMED);
+            }
+            if (!sequencer_.trigger()) {
+                return out.fail(ScpiError::SEQ_NOT_ARMED);
+            }
+            return out.ok();
+
+        case ScpiCommandType::SEQ_STOP:
+            sequencer_.stop();
+            return out.ok();
+
+        case ScpiCommandType::SEQ_STATUS_QUERY: {
+            // <state>,<tracks>,<length>,<position>,<loops done>
+            const char* state = "IDLE";
+            if (sequencer_.state() == SeqState::ARMED) state = "ARMED";
+            if (sequencer_.state() == SeqState::RUNNING) state = "RUNNING";
+            out.appendf("%s,%u,%u,%u,%lu", state,
+                     sequencer_.num_tracks(), sequencer_.length(), sequencer_.position(),
+                     (unsigned long)sequencer_.loops_done());
+            return ScpiError::NONE;
+        }
+
+        default:
+            return out.fail(ScpiError::UNKNOWN_COMMAND);
+    }
+}
+
+ScpiError BoardManager::execute(const ScpiCommand& cmd, ResponseBuffer& out) {
+    PerfScope perf(PerfProbe::EXECUTE);
+    out.clear();
     if (!cmd.valid) {
-        return "ERROR:" + cmd.error_msg;
+        return out.fail(cmd.error);
+    }
+
+    if (cmd.has_range) {
+        return execute_range(cmd, out);
     }
 
     switch (cmd.type) {
         case ScpiCommandType::IDN_QUERY:
-            return execute_idn();
+            return execute_idn(out);
 
         case ScpiCommandType::RST:
             reset_all();
-            return "OK";
+            return out.ok();
 
         case ScpiCommandType::FAULT_QUERY:
-            return execute_fault_query();
+        case ScpiCommandType::FAULT_STATUS_QUERY:
+        case ScpiCommandType::FAULT_SET_NOTIFY:
+        case ScpiCommandType::FAULT_GET_NOTIFY:
+            return execute_fault_query(cmd, out);
 
         case ScpiCommandType::DAC_FAULT_QUERY:
-            return execute_dac_fault_query(cmd);
+            return execute_dac_fault_query(cmd, out);
 
         case ScpiCommandType::DAC_ECHO_QUERY:
-            return execute_dac_echo_query(cmd);
+            return execute_dac_echo_query(cmd, out);
 
         case ScpiCommandType::SET_VOLTAGE:
-            return execute_set_voltage(cmd);
+            return execute_set_voltage(cmd, out);
 
         case ScpiCommandType::SET_CURRENT:
-            return execute_set_current(cmd);
+            return execute_set_current(cmd, out);
 
         case ScpiCommandType::SET_CODE:
-            return execute_set_code(cmd);
+            return execute_set_code(cmd, out);
+
+        case ScpiCommandType::SET_ALL_CODE:
+            return execute_set_all_code(cmd, out);
 
         case ScpiCommandType::SET_SPAN:
         case ScpiCommandType::SET_ALL_SPAN:
-            return execute_set_span(cmd);
+            return execute_set_span(cmd, out);
+
+        case ScpiCommandType::BCAST_CODE:
+        case ScpiCommandType::BCAST_SPAN:
+            return execute_broadcast(cmd, out);
 
         case ScpiCommandType::UPDATE:
         case ScpiCommandType::UPDATE_ALL:
-            return execute_update(cmd);
+            return execute_update(cmd, out);
 
         case ScpiCommandType::POWER_DOWN:
         case ScpiCommandType::POWER_DOWN_CHIP:
-            return execute_power_down(cmd);
+            return execute_power_down(cmd, out);
 
         case ScpiCommandType::GET_RESOLUTION:
-            return execute_get_resolution(cmd);
+            return execute_get_resolution(cmd, out);
 
         case ScpiCommandType::SET_RESOLUTION:
-            return execute_set_resolution(cmd);
+            return execute_set_resolution(cmd, out);
 
         case ScpiCommandType::PULSE_LDAC:
-            spi_.pulse_ldac();
-            return "OK";
+            pulse_ldac();
+            return out.ok();
+
+        case ScpiCommandType::SYST_BOOT_QUERY:
+            // <us from reset to ready>,<us spent in init_all()>
+            out.appendf("%llu,%lu", (unsigned long long)ready_us_, (unsigned long)init_us_);
+            return ScpiError::NONE;
+
+        case ScpiCommandType::SYST_FITTED_QUERY:
+            out.appendf("0x%02X", fitted_boards_);
+            return ScpiError::NONE;
+
+        case ScpiCommandType::SYST_STAT_QUERY:
+            PerfStats::report(out);
+            return ScpiError::NONE;
+
+        case ScpiCommandType::SYST_CONFIG_QUERY:
+            // Build options, so host-side results can be told apart per build
+            out.appendf("SPI=%lu,SINGLE=%d,PERF=%d", (unsigned long)SPI_CONFIG::BAUDRATE,
+                        NUM_BOARDS == 1 ? 1 : 0, PERF_STATS::ENABLED ? 1 : 0);
+            return ScpiError::NONE;
 
         case ScpiCommandType::SYST_ERR_QUERY:
-            return "0,\"No error\"";  // TODO: Implement error queue
+            out.set("0,\"No error\"");  // TODO: Implement error queue
+            return ScpiError::NONE;
+
+        case ScpiCommandType::SYST_BINARY:
+            return out.ok();  // main loop switches to BinaryProtocol after the reply
+
+        case ScpiCommandType::SYST_SET_QUIET:
+            return out.ok();  // core 0 already applied it to its echo and prompt
+
+        case ScpiCommandType::SYST_SET_ELIDE:
+        case ScpiCommandType::SYST_GET_ELIDE:
+        case ScpiCommandType::SYST_ELIDE_COUNT_QUERY:
+            return execute_write_elision(cmd, out);
 
         case ScpiCommandType::GET_VOLTAGE:
+            return execute_get_voltage(cmd, out);
+
         case ScpiCommandType::GET_CURRENT:
-            return "ERROR:Query not implemented";
+            return execute_get_current(cmd, out);
+
+        case ScpiCommandType::GET_CODE:
+            return execute_get_code(cmd, out);
 
         // Calibration commands
         case ScpiCommandType::SET_SERIAL:
-            return execute_set_serial(cmd);
+            return execute_set_serial(cmd, out);
 
         case ScpiCommandType::GET_SERIAL:
-            return execute_get_serial(cmd);
+            return execute_get_serial(cmd, out);
 
         case ScpiCommandType::SET_CAL_GAIN:
-            return execute_set_cal_gain(cmd);
+            return execute_set_cal_gain(cmd, out);
 
         case ScpiCommandType::GET_CAL_GAIN:
-            return execute_get_cal_gain(cmd);
+            return execute_get_cal_gain(cmd, out);
 
         case ScpiCommandType::SET_CAL_OFFSET:
-            return execute_set_cal_offset(cmd);
+            return execute_set_cal_offset(cmd, out);
 
         case ScpiCommandType::GET_CAL_OFFSET:
-            return execute_get_cal_offset(cmd);
+            return execute_get_cal_offset(cmd, out);
 
         case ScpiCommandType::SET_CAL_ENABLE:
-            return execute_set_cal_enable(cmd);
+            return execute_set_cal_enable(cmd, out);
 
         case ScpiCommandType::GET_CAL_ENABLE:
-            return execute_get_cal_enable(cmd);
+            return execute_get_cal_enable(cmd, out);
+
+        case ScpiCommandType::SET_CAL_TABLE:
+            return execute_set_cal_table(cmd, out);
+
+        case ScpiCommandType::GET_CAL_TABLE:
+            return execute_get_cal_table(cmd, out);
 
         case ScpiCommandType::CAL_DATA_QUERY:
-            return execute_cal_data_query();
+            return execute_cal_data_query(out);
+
+        case ScpiCommandType::CAL_IMAGE_QUERY:
+            return execute_cal_image_query(cmd, out);
+
+        case ScpiCommandType::CAL_IMAGE:
+            return execute_cal_image(cmd, out);
 
         case ScpiCommandType::CAL_CLEAR:
-            return execute_cal_clear();
+            return execute_cal_clear(out);
 
         case ScpiCommandType::CAL_SAVE:
-            return execute_cal_save();
+            return execute_cal_save(out);
 
         case ScpiCommandType::CAL_LOAD:
-            return execute_cal_load();
+            return execute_cal_load(out);
+
+        // Output snapshots
+        case ScpiCommandType::SNAP_SAVE:
+        case ScpiCommandType::SNAP_RESTORE:
+        case ScpiCommandType::SNAP_DELETE:
+        case ScpiCommandType::SNAP_LIST_QUERY:
+        case ScpiCommandType::SNAP_SET_BOOT:
+        case ScpiCommandType::SNAP_GET_BOOT:
+            return execute_snapshot(cmd, out);
+
+        // Batched commands
+        case ScpiCommandType::APPLY:
+        case ScpiCommandType::APPLY_CODE:
+            return execute_apply(cmd, out);
+
+        // Sequencer commands
+        case ScpiCommandType::SEQ_DATA:
+            return execute_seq_data(cmd, out);
+
+        case ScpiCommandType::SEQ_CLEAR:
+        case ScpiCommandType::SEQ_SET_RATE:
+        case ScpiCommandType::SEQ_GET_RATE:
+        case ScpiCommandType::SEQ_SET_LOOP:
+        case ScpiCommandType::SEQ_GET_LOOP:
+        case ScpiCommandType::SEQ_SET_TRIG_SOURCE:
+        case ScpiCommandType::SEQ_GET_TRIG_SOURCE:
+        case ScpiCommandType::SEQ_START:
+        case ScpiCommandType::SEQ_TRIGGER:
+        case ScpiCommandType::SEQ_STOP:
+        case ScpiCommandType::SEQ_STATUS_QUERY:
+            return execute_seq(cmd, out);
+
+        case ScpiCommandType::TRIG_SET_ARM:
+        case ScpiCommandType::TRIG_GET_ARM:
+        case ScpiCommandType::TRIG_COUNT_QUERY:
+            return execute_trigger(cmd, out);
 
         default:
-            return "ERROR:Unknown command";
+            return out.fail(ScpiError::UNKNOWN_COMMAND);
     }
 }
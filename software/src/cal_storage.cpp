@@ -1,164 +1,548 @@
 #include "cal_storage.hpp"
+#include "utils.hpp"
 #include <cstring>
 #include <cstdio>
+#include <cstddef>
 
 // Pico SDK includes for flash operations
 #include "hardware/flash.h"
 #include "hardware/sync.h"
 #include "pico/stdlib.h"
+#include "pico/multicore.h"
 
 namespace CalStorage {
 
+// Flash is unreadable while it is being erased/programmed, and the other
+// core keeps executing from XIP. Park it for the duration (it must have
+// called multicore_lockout_victim_init(), as core 0 does in CoreLink::launch).
+class FlashAccessGuard {
+public:
+    FlashAccessGuard()
+        : park_(multicore_lockout_victim_is_initialized(get_core_num() ^ 1)) {
+        if (park_) multicore_lockout_start_blocking();
+        interrupts_ = save_and_disable_interrupts();
+    }
+    ~FlashAccessGuard() {
+        restore_interrupts(interrupts_);
+        if (park_) multicore_lockout_end_blocking();
+    }
+
+private:
+    bool park_;
+    uint32_t interrupts_;
+};
+
 // Flash is memory-mapped at XIP_BASE
 // To read flash, access (XIP_BASE + offset)
-#define FLASH_TARGET_OFFSET CAL_FLASH_OFFSET
-
-// Calculate CRC-16 (CCITT polynomial 0x1021)
-uint16_t calculate_crc16(const uint8_t* data, size_t length) {
-    uint16_t crc = 0xFFFF;
+const uint8_t* flash_ptr(uint32_t offset) {
+    return reinterpret_cast<const uint8_t*>(XIP_BASE + offset);
+}
 
+bool is_blank(uint32_t offset, size_t length) {
+    const uint8_t* p = flash_ptr(offset);
     for (size_t i = 0; i < length; i++) {
-        crc ^= (static_cast<uint16_t>(data[i]) << 8);
-        for (int j = 0; j < 8; j++) {
-            if (crc & 0x8000) {
-                crc = (crc << 1) ^ 0x1021;
-            } else {
-                crc <<= 1;
-            }
+        if (p[i] != 0xFF) return false;
+    }
+    return true;
+}
+
+// Program bytes at any offset. The rest of each page is programmed as 0xFF,
+// which leaves the flash unchanged, and interrupts are only held off for one
+// page at a time.
+bool program(uint32_t offset, const uint8_t* data, size_t length) {
+    uint8_t page[FLASH_PAGE_SIZE];
+    size_t done = 0;
+
+    while (done < length) {
+        uint32_t at = offset + done;
+        uint32_t page_start = at & ~(FLASH_PAGE_SIZE - 1);
+        size_t in_page = at - page_start;
+        size_t chunk = FLASH_PAGE_SIZE - in_page;
+        if (chunk > length - done) chunk = length - done;
+
+        memset(page, 0xFF, sizeof(page));
+        memcpy(page + in_page, data + done, chunk);
+        {
+            // Other core parked and interrupts disabled during flash operations
+            FlashAccessGuard guard;
+            flash_range_program(page_start, page, FLASH_PAGE_SIZE);
         }
+        done += chunk;
     }
 
-    return crc;
+    // Verify write
+    return memcmp(flash_ptr(offset), data, length) == 0;
 }
 
-bool has_valid_data() {
-    // Read the header from flash
-    const FlashCalibrationData* flash_data =
-        reinterpret_cast<const FlashCalibrationData*>(XIP_BASE + FLASH_TARGET_OFFSET);
+// Erase sectors that are not blank, one at a time
+void erase_range(uint32_t offset, uint32_t sectors) {
+    for (uint32_t i = 0; i < sectors; i++) {
+        uint32_t sector = offset + i * FLASH_SECTOR_SIZE;
+        if (is_blank(sector, FLASH_SECTOR_SIZE)) continue;
+        FlashAccessGuard guard;
+        flash_range_erase(sector, FLASH_SECTOR_SIZE);
+    }
+}
 
-    // Check magic number
-    if (flash_data->magic != CAL_MAGIC) {
-        return false;
+// Calculate CRC-16 (CCITT polynomial 0x1021)
+uint16_t calculate_crc16(const uint8_t* data, size_t length) {
+    return utils::crc16_ccitt(data, length);
+}
+
+// Calculate CRC-32 (IEEE 802.3 polynomial)
+uint32_t calculate_crc32(const uint8_t* data, size_t length) {
+    return utils::crc32(data, length);
+}
+
+namespace {
+
+// Calibration as the log replays it; save_to_flash() writes the difference
+struct StoredCalibration {
+    char serial_numbers[NUM_BOARDS][SERIAL_NUMBER_MAX_LEN];
+    ChannelCalibration channels[NUM_BOARDS][DACS_PER_BOARD][MAX_CHANNELS_PER_DAC];
+    // Flash offset of each channel's latest table payload, 0 if it has none
+    uint32_t tables[NUM_BOARDS][DACS_PER_BOARD][MAX_CHANNELS_PER_DAC];
+};
+
+const ChannelCalibration DEFAULT_CAL{};
+
+StoredCalibration stored_;
+bool scanned_ = false;
+bool has_data_ = false;          // A log block or a legacy image was found
+uint32_t active_offset_ = 0;     // Flash offset of the block saves append to, 0 if none
+uint32_t sequence_ = 0;          // Sequence number of the active block
+uint32_t write_offset_ = 0;      // First free byte in the active block
+bool needs_compaction_ = false;  // Tail unusable (interrupted save), or only a legacy image
+
+// Records for one save, assembled before any flash access
+uint8_t staging_[CAL_BLOCK_SIZE];
+
+uint32_t block_offset(uint32_t block) {
+    return CAL_FLASH_OFFSET + block * CAL_BLOCK_SIZE;
+}
+
+// Bitwise, so a NaN gain does not count as a change on every save
+bool same_channel(const ChannelCalibration& a, const ChannelCalibration& b) {
+    return a.enabled == b.enabled &&
+           memcmp(&a.gain, &b.gain, sizeof(a.gain)) == 0 &&
+           memcmp(&a.offset, &b.offset, sizeof(a.offset)) == 0;
+}
+
+uint32_t record_checksum(const CalRecordHeader& header, const uint8_t* payload) {
+    uint16_t length = header.length;
+    uint32_t crc = utils::crc32(&header.type, 1);
+    crc = utils::crc32(reinterpret_cast<const uint8_t*>(&length), sizeof(length), crc);
+    return utils::crc32(payload, length, crc);
+}
+
+uint32_t sequence_checksum(uint32_t sequence) {
+    return calculate_crc32(reinterpret_cast<const uint8_t*>(&sequence), sizeof(sequence));
+}
+
+void reset_stored() {
+    for (uint8_t board = 0; board < NUM_BOARDS; board++) {
+        stored_.serial_numbers[board][0] = '\0';
+        for (uint8_t dac = 0; dac < DACS_PER_BOARD; dac++) {
+            for (uint8_t ch = 0; ch < MAX_CHANNELS_PER_DAC; ch++) {
+                stored_.channels[board][dac][ch] = DEFAULT_CAL;
+                stored_.tables[board][dac][ch] = 0;
+            }
+        }
     }
+}
 
-    // Check version (must match current version)
-    if (flash_data->version != CAL_VERSION) {
-        return false;
+// Table payload: CalTableRecord, then (input, output) pairs
+size_t encode_table(uint8_t* payload, uint8_t board, uint8_t dac, uint8_t channel,
+                    const CalibrationTable* table) {
+    CalTableRecord record{board, dac, channel, static_cast<uint8_t>(table ? table->count : 0)};
+    memcpy(payload, &record, sizeof(record));
+    size_t pos = sizeof(record);
+    for (uint8_t i = 0; i < record.count; i++) {
+        memcpy(payload + pos, &table->input[i], sizeof(float));
+        memcpy(payload + pos + sizeof(float), &table->output[i], sizeof(float));
+        pos += 2 * sizeof(float);
     }
+    return pos;
+}
 
-    // Calculate CRC over data portion (after header)
-    const uint8_t* data_start = reinterpret_cast<const uint8_t*>(&flash_data->serial_numbers);
-    size_t data_size = sizeof(FlashCalibrationData) - offsetof(FlashCalibrationData, serial_numbers);
-    uint16_t calculated_crc = calculate_crc16(data_start, data_size);
+// Append one record to staging_; returns the new end
+size_t stage_record(size_t pos, CalRecordType type, const void* payload, uint16_t length) {
+    CalRecordHeader header;
+    header.type = static_cast<uint8_t>(type);
+    header.reserved = 0xFF;
+    header.length = length;
+    header.checksum = record_checksum(header, static_cast<const uint8_t*>(payload));
 
-    return (calculated_crc == flash_data->checksum);
+    size_t size = record_size(length);
+    memset(staging_ + pos, 0xFF, size);
+    memcpy(staging_ + pos, &header, sizeof(header));
+    memcpy(staging_ + pos + sizeof(header), payload, length);
+    return pos + size;
 }
 
-bool save_to_flash(const BoardManager& manager) {
-    // Prepare calibration data structure
-    FlashCalibrationData cal_data;
-    memset(&cal_data, 0xFF, sizeof(cal_data));  // Fill with 0xFF (erased flash state)
-
-    // Set header
-    cal_data.magic = CAL_MAGIC;
-    cal_data.version = CAL_VERSION;
+// Stage a record for everything in the manager that differs from stored_
+// (full: from the defaults, for a snapshot); returns the staged length
+size_t stage_changes(const BoardManager& manager, bool full) {
+    size_t pos = 0;
 
-    // Copy serial numbers
     for (uint8_t board = 0; board < NUM_BOARDS; board++) {
-        std::string sn = manager.get_serial_number(board);
-        strncpy(cal_data.serial_numbers[board], sn.c_str(), SERIAL_NUMBER_MAX_LEN - 1);
-        cal_data.serial_numbers[board][SERIAL_NUMBER_MAX_LEN - 1] = '\0';
+        const char* serial = manager.get_serial_number(board);
+        bool differs = full ? serial[0] != '\0'
+                            : strncmp(serial, stored_.serial_numbers[board], SERIAL_NUMBER_MAX_LEN) != 0;
+        if (!differs) continue;
+
+        CalSerialRecord record;
+        record.board = board;
+        memset(record.serial_number, 0, sizeof(record.serial_number));
+        strncpy(record.serial_number, serial, SERIAL_NUMBER_MAX_LEN - 1);
+        pos = stage_record(pos, CalRecordType::SERIAL, &record, sizeof(record));
     }
 
-    // Copy calibration data
     for (uint8_t board = 0; board < NUM_BOARDS; board++) {
         for (uint8_t dac = 0; dac < DACS_PER_BOARD; dac++) {
             for (uint8_t ch = 0; ch < MAX_CHANNELS_PER_DAC; ch++) {
-                const ChannelCalibration* cal = manager.get_calibration(board, dac, ch);
-                if (cal) {
-                    cal_data.channels[board][dac][ch].gain = cal->gain;
-                    cal_data.channels[board][dac][ch].offset = cal->offset;
-                    cal_data.channels[board][dac][ch].enabled = cal->enabled ? 1 : 0;
-                } else {
-                    cal_data.channels[board][dac][ch].gain = 1.0f;
-                    cal_data.channels[board][dac][ch].offset = 0.0f;
-                    cal_data.channels[board][dac][ch].enabled = 0;
+                const ChannelCalibration& cal = *manager.get_calibration(board, dac, ch);
+                const ChannelCalibration& base = full ? DEFAULT_CAL : stored_.channels[board][dac][ch];
+                if (!same_channel(cal, base)) {
+                    CalChannelRecord record;
+                    record.board = board;
+                    record.dac = dac;
+                    record.channel = ch;
+                    record.enabled = cal.enabled ? 1 : 0;
+                    record.gain = cal.gain;
+                    record.offset = cal.offset;
+                    pos = stage_record(pos, CalRecordType::CHANNEL, &record, sizeof(record));
                 }
+
+                // Compared in the encoded form against the stored record
+                const CalibrationTable* table = manager.get_cal_table(board, dac, ch);
+                uint32_t stored = full ? 0 : stored_.tables[board][dac][ch];
+                if (!table && !stored) continue;
+
+                uint8_t payload[CAL_TABLE_PAYLOAD_MAX];
+                size_t length = encode_table(payload, board, dac, ch, table);
+                if (stored && memcmp(flash_ptr(stored), payload, length) == 0) continue;
+                pos = stage_record(pos, CalRecordType::TABLE, payload, static_cast<uint16_t>(length));
+            }
+        }
+    }
+
+    return pos;
+}
+
+// payload_offset: where the payload is in flash
+void apply_record(uint8_t type, uint16_t length, uint32_t payload_offset) {
+    const uint8_t* payload = flash_ptr(payload_offset);
+
+    switch (static_cast<CalRecordType>(type)) {
+        case CalRecordType::CHANNEL: {
+            CalChannelRecord record;
+            if (length < sizeof(record)) return;
+            memcpy(&record, payload, sizeof(record));
+            // Boards past NUM_BOARDS come from a multi-board build
+            if (record.board >= NUM_BOARDS || record.dac >= DACS_PER_BOARD ||
+                record.channel >= MAX_CHANNELS_PER_DAC) {
+                return;
             }
+            ChannelCalibration& cal = stored_.channels[record.board][record.dac][record.channel];
+            cal.gain = record.gain;
+            cal.offset = record.offset;
+            cal.enabled = record.enabled != 0;
+            break;
+        }
+        case CalRecordType::SERIAL: {
+            CalSerialRecord record;
+            if (length < sizeof(record)) return;
+            memcpy(&record, payload, sizeof(record));
+            if (record.board >= NUM_BOARDS) return;
+            memcpy(stored_.serial_numbers[record.board], record.serial_number, SERIAL_NUMBER_MAX_LEN);
+            stored_.serial_numbers[record.board][SERIAL_NUMBER_MAX_LEN - 1] = '\0';
+            break;
+        }
+        case CalRecordType::TABLE: {
+            CalTableRecord record;
+            if (length < sizeof(record)) return;
+            memcpy(&record, payload, sizeof(record));
+            if (record.board >= NUM_BOARDS || record.dac >= DACS_PER_BOARD ||
+                record.channel >= MAX_CHANNELS_PER_DAC || record.count > CAL_MAX_POINTS ||
+                length < sizeof(record) + record.count * 2 * sizeof(float)) {
+                return;
+            }
+            stored_.tables[record.board][record.dac][record.channel] =
+                record.count ? payload_offset : 0;
+            break;
+        }
+        default:
+            break;  // Written by a newer version
+    }
+}
+
+// True if offset holds a valid log block header; reads its sequence number
+bool block_valid(uint32_t offset, uint32_t& sequence) {
+    const uint8_t* base = flash_ptr(offset);
+    CalLogHeader header;
+    memcpy(&header, base, sizeof(header));
+    if (header.magic != CAL_MAGIC || header.version != CAL_VERSION) return false;
+    if (header.checksum != sequence_checksum(header.sequence)) return false;
+    sequence = header.sequence;
+    return true;
+}
+
+// Check the record at pos (whose header is in the block) and read its type
+// and payload length
+bool read_record(const uint8_t* base, uint32_t pos, uint32_t size_limit,
+                 uint8_t& type, uint16_t& length, uint32_t& size) {
+    CalRecordHeader header;
+    memcpy(&header, base + pos, sizeof(header));
+    type = header.type;
+    length = header.length;
+    size = record_size(length);
+    if (type == static_cast<uint8_t>(CalRecordType::FREE)) return true;
+    return pos + size <= size_limit &&
+           header.checksum == record_checksum(header, base + pos + sizeof(header));
+}
+
+// Replay a block's records into stored_; returns the offset of the first
+// record that is free or does not check out (torn is set for the latter)
+uint32_t replay_block(uint32_t offset, uint32_t size_limit, bool& torn) {
+    const uint8_t* base = flash_ptr(offset);
+    uint32_t pos = sizeof(CalLogHeader);
+
+    while (pos + sizeof(CalRecordHeader) <= size_limit) {
+        uint8_t type;
+        uint16_t length;
+        uint32_t size;
+        if (!read_record(base, pos, size_limit, type, length, size)) {
+            // Save interrupted by a reset: nothing past it can be trusted
+            torn = true;
+            break;
         }
+        if (type == static_cast<uint8_t>(CalRecordType::FREE)) break;
+
+        apply_record(type, length, offset + pos + sizeof(CalRecordHeader));
+        pos += size;
     }
+    return pos;
+}
 
-    // Calculate CRC over data portion
-    const uint8_t* data_start = reinterpret_cast<const uint8_t*>(&cal_data.serial_numbers);
+// CRC over the data portion of a version 1 image (after the header)
+uint16_t image_checksum(const FlashCalibrationData& image) {
+    const uint8_t* data_start = reinterpret_cast<const uint8_t*>(&image.serial_numbers);
     size_t data_size = sizeof(FlashCalibrationData) - offsetof(FlashCalibrationData, serial_numbers);
-    cal_data.checksum = calculate_crc16(data_start, data_size);
+    return calculate_crc16(data_start, data_size);
+}
 
-    // Disable interrupts during flash operations
-    uint32_t interrupts = save_and_disable_interrupts();
+bool image_valid(const FlashCalibrationData& image) {
+    return image.magic == CAL_LEGACY_MAGIC && image.version == CAL_LEGACY_VERSION &&
+           image_checksum(image) == image.checksum;
+}
 
-    // Erase the sector first (required before writing)
-    flash_range_erase(FLASH_TARGET_OFFSET, FLASH_SECTOR_SIZE);
+// Version 1 image in the last sector
+bool load_legacy() {
+    const FlashCalibrationData* legacy =
+        reinterpret_cast<const FlashCalibrationData*>(flash_ptr(CAL_LEGACY_OFFSET));
+    if (!image_valid(*legacy)) {
+        return false;
+    }
+
+    for (uint8_t board = 0; board < NUM_BOARDS; board++) {
+        memcpy(stored_.serial_numbers[board], legacy->serial_numbers[board], SERIAL_NUMBER_MAX_LEN);
+        stored_.serial_numbers[board][SERIAL_NUMBER_MAX_LEN - 1] = '\0';
+        for (uint8_t dac = 0; dac < DACS_PER_BOARD; dac++) {
+            for (uint8_t ch = 0; ch < MAX_CHANNELS_PER_DAC; ch++) {
+                const auto& cal = legacy->channels[board][dac][ch];
+                stored_.channels[board][dac][ch].gain = cal.gain;
+                stored_.channels[board][dac][ch].offset = cal.offset;
+                stored_.channels[board][dac][ch].enabled = cal.enabled != 0;
+            }
+        }
+    }
+    return true;
+}
 
-    // Write the data (must be aligned to page size)
-    // Write in chunks of FLASH_PAGE_SIZE
-    const uint8_t* src = reinterpret_cast<const uint8_t*>(&cal_data);
-    size_t bytes_to_write = sizeof(FlashCalibrationData);
+// Find the newest log block and replay it into stored_
+void scan() {
+    reset_stored();
+    has_data_ = false;
+    active_offset_ = 0;
+    sequence_ = 0;
+    write_offset_ = 0;
+    needs_compaction_ = false;
 
-    // Round up to page size
-    size_t pages = (bytes_to_write + FLASH_PAGE_SIZE - 1) / FLASH_PAGE_SIZE;
-    size_t write_size = pages * FLASH_PAGE_SIZE;
+    for (uint32_t block = 0; block < CAL_LOG_BLOCKS; block++) {
+        uint32_t sequence;
+        if (!block_valid(block_offset(block), sequence)) continue;
+        // Wrap-safe comparison
+        if (!active_offset_ || static_cast<int32_t>(sequence - sequence_) > 0) {
+            active_offset_ = block_offset(block);
+            sequence_ = sequence;
+        }
+    }
 
-    // Create page-aligned buffer
-    uint8_t write_buffer[write_size];
-    memset(write_buffer, 0xFF, write_size);
-    memcpy(write_buffer, src, bytes_to_write);
+    if (active_offset_) {
+        bool torn = false;
+        write_offset_ = replay_block(active_offset_, CAL_BLOCK_SIZE, torn);
+        // Bits left programmed by an interrupted save would corrupt the next
+        // record appended over them
+        needs_compaction_ = torn ||
+                            !is_blank(active_offset_ + write_offset_, CAL_BLOCK_SIZE - write_offset_);
+        has_data_ = true;
+    } else if (load_legacy()) {
+        needs_compaction_ = true;
+        has_data_ = true;
+    }
+    scanned_ = true;
+}
 
-    flash_range_program(FLASH_TARGET_OFFSET, write_buffer, write_size);
+// Start the next block with a snapshot of the manager's calibration
+// The active block is left alone, so a failure keeps the previous data
+bool compact(const BoardManager& manager) {
+    uint32_t block = active_offset_
+        ? ((active_offset_ - CAL_FLASH_OFFSET) / CAL_BLOCK_SIZE + 1) % CAL_LOG_BLOCKS
+        : 0;
+    uint32_t base = block_offset(block);
+    size_t length = stage_changes(manager, true);
 
-    // Re-enable interrupts
-    restore_interrupts(interrupts);
+    erase_range(base, CAL_BLOCK_SECTORS);
+    if (length > 0 && !program(base + sizeof(CalLogHeader), staging_, length)) {
+        return false;
+    }
 
-    // Verify write by checking CRC
-    return has_valid_data();
+    // Header last: it is what makes the block count
+    CalLogHeader header;
+    header.magic = CAL_MAGIC;
+    header.version = CAL_VERSION;
+    header.reserved = 0xFFFF;
+    header.sequence = sequence_ + 1;
+    header.checksum = sequence_checksum(header.sequence);
+    return program(base, reinterpret_cast<const uint8_t*>(&header), sizeof(header));
 }
 
-bool load_from_flash(BoardManager& manager) {
-    // Check if valid data exists
-    if (!has_valid_data()) {
-        printf("[CAL] No valid calibration data in flash\r\n");
+}  // namespace
+
+void build_image(const BoardManager& manager, FlashCalibrationData& image) {
+    memset(&image, 0xFF, sizeof(image));
+    image.magic = CAL_LEGACY_MAGIC;
+    image.version = CAL_LEGACY_VERSION;
+    for (uint8_t board = 0; board < NUM_BOARDS; board++) {
+        memset(image.serial_numbers[board], 0, SERIAL_NUMBER_MAX_LEN);
+        strncpy(image.serial_numbers[board], manager.get_serial_number(board), SERIAL_NUMBER_MAX_LEN - 1);
+        for (uint8_t dac = 0; dac < DACS_PER_BOARD; dac++) {
+            for (uint8_t ch = 0; ch < MAX_CHANNELS_PER_DAC; ch++) {
+                const ChannelCalibration* cal = manager.get_calibration(board, dac, ch);
+                auto& entry = image.channels[board][dac][ch];
+                entry.gain = cal->gain;
+                entry.offset = cal->offset;
+                entry.enabled = cal->enabled ? 1 : 0;
+            }
+        }
+    }
+    image.checksum = image_checksum(image);
+}
+
+bool apply_image(BoardManager& manager, const FlashCalibrationData& image) {
+    if (!image_valid(image)) {
         return false;
     }
+    for (uint8_t board = 0; board < NUM_BOARDS; board++) {
+        char serial[SERIAL_NUMBER_MAX_LEN];
+        memcpy(serial, image.serial_numbers[board], SERIAL_NUMBER_MAX_LEN);
+        serial[SERIAL_NUMBER_MAX_LEN - 1] = '\0';
+        manager.set_serial_number(board, serial);
+        for (uint8_t dac = 0; dac < DACS_PER_BOARD; dac++) {
+            for (uint8_t ch = 0; ch < MAX_CHANNELS_PER_DAC; ch++) {
+                const auto& entry = image.channels[board][dac][ch];
+                manager.set_cal_gain(board, dac, ch, entry.gain);
+                manager.set_cal_offset(board, dac, ch, entry.offset);
+                manager.set_cal_enable(board, dac, ch, entry.enabled != 0);
+            }
+        }
+    }
+    return true;
+}
+
+bool has_valid_data() {
+    scan();
+    return has_data_;
+}
+
+bool save_to_flash(const BoardManager& manager) {
+    if (!scanned_) scan();
+
+    bool ok;
+    size_t length = 0;
+    if (active_offset_ && !needs_compaction_) {
+        length = stage_changes(manager, false);
+        if (length == 0) {
+            return true;  // Nothing changed since the last save
+        }
+    }
 
-    // Read from flash
-    const FlashCalibrationData* flash_data =
-        reinterpret_cast<const FlashCalibrationData*>(XIP_BASE + FLASH_TARGET_OFFSET);
+    if (active_offset_ && !needs_compaction_ && write_offset_ + length <= CAL_BLOCK_SIZE) {
+        ok = program(active_offset_ + write_offset_, staging_, length);
+    } else {
+        // Block full, unusable, or no log yet
+        ok = compact(manager);
+    }
+
+    // Replaying what was written also records where each table now lives,
+    // and sends the next save to a new block if this one went wrong
+    scan();
+    return ok;
+}
+
+bool load_from_flash(BoardManager& manager) {
+    scan();
+    if (!has_data_) return false;
 
     // Load serial numbers
     for (uint8_t board = 0; board < NUM_BOARDS; board++) {
-        manager.set_serial_number(board, flash_data->serial_numbers[board]);
+        manager.set_serial_number(board, stored_.serial_numbers[board]);
     }
 
     // Load calibration data
     for (uint8_t board = 0; board < NUM_BOARDS; board++) {
         for (uint8_t dac = 0; dac < DACS_PER_BOARD; dac++) {
             for (uint8_t ch = 0; ch < MAX_CHANNELS_PER_DAC; ch++) {
-                const auto& cal = flash_data->channels[board][dac][ch];
+                const ChannelCalibration& cal = stored_.channels[board][dac][ch];
                 manager.set_cal_gain(board, dac, ch, cal.gain);
                 manager.set_cal_offset(board, dac, ch, cal.offset);
-                manager.set_cal_enable(board, dac, ch, cal.enabled != 0);
+                manager.set_cal_enable(board, dac, ch, cal.enabled);
+                // Free the pool entries of tables that are not stored first
+                if (!stored_.tables[board][dac][ch]) {
+                    manager.set_cal_table(board, dac, ch, nullptr, nullptr, 0);
+                }
+            }
+        }
+    }
+
+    // Load calibration tables
+    for (uint8_t board = 0; board < NUM_BOARDS; board++) {
+        for (uint8_t dac = 0; dac < DACS_PER_BOARD; dac++) {
+            for (uint8_t ch = 0; ch < MAX_CHANNELS_PER_DAC; ch++) {
+                uint32_t offset = stored_.tables[board][dac][ch];
+                if (!offset) continue;
+
+                const uint8_t* payload = flash_ptr(offset);
+                uint8_t count = payload[offsetof(CalTableRecord, count)];
+                const uint8_t* points = payload + sizeof(CalTableRecord);
+                float input[CAL_MAX_POINTS];
+                float output[CAL_MAX_POINTS];
+                for (uint8_t i = 0; i < count; i++) {
+                    memcpy(&input[i], points + i * 2 * sizeof(float), sizeof(float));
+                    memcpy(&output[i], points + (i * 2 + 1) * sizeof(float), sizeof(float));
+                }
+                manager.set_cal_table(board, dac, ch, input, output, count);
             }
         }
     }
 
-    printf("[CAL] Loaded calibration data from flash\r\n");
     return true;
 }
 
 void erase_flash() {
-    uint32_t interrupts = save_and_disable_interrupts();
-    flash_range_erase(FLASH_TARGET_OFFSET, FLASH_SECTOR_SIZE);
-    restore_interrupts(interrupts);
-    printf("[CAL] Calibration data erased from flash\r\n");
+    erase_range(CAL_FLASH_OFFSET, CAL_LOG_SECTORS);
+    scanned_ = false;
 }
 
 }  // namespace CalStorage
@@ -0,0 +1,183 @@
+#include "core_link.hpp"
+#include "board_manager.hpp"
+#include "spi_manager.hpp"
+#include "binary_protocol.hpp"
+#include "state_storage.hpp"
+#include "perf_stats.hpp"
+#include "pico/stdlib.h"
+#include "pico/multicore.h"
+#include "hardware/sync.h"
+
+CoreLink* CoreLink::instance_ = nullptr;
+
+static uint32_t core1_stack[CORE_LINK::CORE1_STACK_BYTES / sizeof(uint32_t)];
+
+// Core 1 only: execute() writes each reply here before it is streamed out
+static char response_storage[CORE_LINK::RESPONSE_SIZE];
+static_assert(CORE_LINK::RESPONSE_SIZE >= CAL_DATA_MAX_LENGTH, "CAL:DATA? does not fit the response buffer");
+
+// Core 1 only: unsolicited fault notices ("!FAULT:0xNNNNNN")
+static char notice_storage[32];
+
+CoreLink::CoreLink(BoardManager& boards, SpiManager& spi, BinaryProtocol& binary)
+    : boards_(boards), spi_(spi), binary_(binary) {}
+
+void CoreLink::launch() {
+    instance_ = this;
+
+    // Core 1 parks core 0 with a lockout while it programs flash (CAL:SAVE)
+    multicore_lockout_victim_init();
+
+    // Reply bytes go through the ring; core 0 does all USB writes
+    binary_.set_output(binary_output);
+
+    multicore_launch_core1_with_stack(core1_entry, core1_stack, sizeof(core1_stack));
+}
+
+// ============================================================================
+// Core 0 side
+// ============================================================================
+
+ScpiCommand* CoreLink::claim() {
+    return can_submit() ? requests_.claim() : nullptr;
+}
+
+void CoreLink::submit() {
+    requests_.publish();
+    outstanding_++;
+    __sev();  // Wake core 1 if it is waiting for work
+}
+
+void CoreLink::forwarded() {
+    __sev();  // Core 1 may be waiting for the bytes in __wfe()
+}
+
+const BootReport* CoreLink::boot_report() const {
+    if (!ready_) return nullptr;
+    __dmb();  // Pairs with the barrier before ready_ is set
+    return &boot_report_;
+}
+
+bool CoreLink::poll(LinkEvent& event, void (*out)(char)) {
+    char c;
+    while (!text_done_) {
+        if (!text_.pop(c)) return false;
+        if (c == '\0') {
+            text_done_ = true;
+        } else {
+            out(c);
+        }
+    }
+
+    // The event is queued right after the NUL; it may still be on its way
+    if (!replies_.pop(event)) return false;
+    text_done_ = false;
+    if (event != LinkEvent::EXIT_BINARY && event != LinkEvent::NOTICE) outstanding_--;
+    return true;
+}
+
+// ============================================================================
+// Core 1 side
+// ============================================================================
+
+void CoreLink::core1_entry() {
+    PerfStats::enable_cycle_counter();
+
+    // Alarms on this pool fire on core 1, so sequencer ticks never touch
+    // the bus from core 0
+    alarm_pool_t* pool = alarm_pool_create_with_unused_hardware_alarm(CORE_LINK::CORE1_MAX_TIMERS);
+    instance_->boards_.sequencer().set_alarm_pool(pool);
+    instance_->boards_.fault_monitor().set_alarm_pool(pool);
+
+    // DMA completion IRQ on this core too: write-only frames are queued from here on
+    instance_->spi_.start_dma();
+
+    // Bring the DACs up from here, with frames queued back to back, while
+    // core 0 waits for USB
+    BoardManager& boards = instance_->boards_;
+    boards.init_all();
+
+    // Outputs left by SNAP:BOOT, so a brown-out is back to them within
+    // milliseconds of reset rather than when the host notices
+    ScpiError snapshot_error;
+    const char* snapshot = StateStorage::restore_boot(boards, snapshot_error);
+
+    // The FAULT and trigger IRQs drive the bus, so they belong to the bus owner as well
+    boards.fault_monitor().start();
+    boards.external_trigger().start();
+
+    boards.mark_ready();
+    FaultState faults = boards.fault_monitor().state();
+    instance_->boot_report_ = {boards.ready_us(), boards.init_us(), boards.fitted_boards(),
+                              boards.probe_answered(), boards.calibration_loaded(),
+                              faults.active, faults.mask, snapshot, snapshot_error};
+    __dmb();
+    instance_->ready_ = true;
+
+    instance_->run();
+}
+
+void CoreLink::run() {
+    while (true) {
+        if (binary_mode_) {
+            uint8_t byte;
+            if (rx_bytes_.pop(byte)) {
+                binary_.feed(byte);
+                if (binary_.exit_requested()) {
+                    binary_mode_ = false;
+                    post(LinkEvent::EXIT_BINARY, "");
+                }
+                continue;
+            }
+        } else if (const ScpiCommand* cmd = requests_.front()) {
+            static ResponseBuffer response(response_storage, sizeof(response_storage));
+            boards_.execute(*cmd, response);
+            bool enter_binary = cmd->valid && cmd->type == ScpiCommandType::SYST_BINARY;
+            bool chained = cmd->chained;
+            requests_.release();  // Slot is free for core 0 to parse into again
+
+            if (enter_binary) {
+                // Switch before posting: core 0 forwards frames once it sees this
+                binary_.reset();
+                binary_mode_ = true;
+                post(LinkEvent::ENTER_BINARY, response.c_str());
+            } else {
+                post(chained ? LinkEvent::REPLY_PART : LinkEvent::REPLY, response.c_str());
+            }
+            mid_line_ = chained;
+            continue;
+        }
+
+        // Fault notices go out between lines, never inside a ';' compound reply
+        if (!binary_mode_ && !mid_line_) {
+            static ResponseBuffer notice(notice_storage, sizeof(notice_storage));
+            if (boards_.take_fault_notice(notice)) {
+                post(LinkEvent::NOTICE, notice.c_str());
+                continue;
+            }
+        }
+
+        // Nothing queued: sleep until core 0 signals or an IRQ (sequencer, FAULT) fires
+        __wfe();
+    }
+}
+
+void CoreLink::post(LinkEvent event, const char* text) {
+    // Core 0 prints text as it arrives, so long replies just stream through
+    for (const char* p = text; ; p++) {
+        while (!text_.push(*p)) {
+            tight_loop_contents();
+        }
+        if (*p == '\0') break;
+    }
+    // Core 0 bounds commands in flight to QUEUE_DEPTH, so this rarely spins
+    while (!replies_.push(event)) {
+        tight_loop_contents();
+    }
+}
+
+void CoreLink::binary_output(uint8_t byte) {
+    while (!instance_->tx_bytes_.push(byte)) {
+        tight_loop_contents();
+    }
+}
@@ -21,6 +21,21 @@ void DacDevice::send_command_read24(uint8_t command, uint8_t address, uint16_t d
     spi_->transaction(board_id_, device_id_, tx_buf, rx, 3);
 }
 
+bool DacDevice::probe() {
+    // Marker differs per chip, so a stale echo from another slot never matches
+    const uint16_t marker = 0xA500 | static_cast<uint16_t>(board_id_ * 3 + device_id_);
+    uint8_t rx[4];
+    send_command_read32(DAC_CMD::NOP, 0, marker, rx);
+    send_command_read32(DAC_CMD::NOP, 0, 0, rx);
+
+    // Low 24 bits echo [CMD|ADDR][DATA_H][DATA_L] (LTC2662 puts its fault
+    // register in the first byte)
+    uint32_t echo = (static_cast<uint32_t>(rx[1]) << 16) |
+                    (static_cast<uint32_t>(rx[2]) << 8) |
+                    static_cast<uint32_t>(rx[3]);
+    return echo == ((static_cast<uint32_t>(DAC_CMD::NOP) << 20) | marker);
+}
+
 void DacDevice::send_command_read32(uint8_t command, uint8_t address, uint16_t data, uint8_t rx[4]) {
     uint8_t tx_buf[4] = {
         0x00,  // Leading 8 zero bits for 32-bit mode
@@ -0,0 +1,34 @@
+#include "external_trigger.hpp"
+#include "board_manager.hpp"
+#include "hardware/gpio.h"
+#include "hardware/irq.h"
+
+ExternalTrigger* ExternalTrigger::instance_ = nullptr;
+
+void ExternalTrigger::start() {
+    instance_ = this;
+
+    gpio_init(EXT_TRIGGER::PIN);
+    gpio_set_dir(EXT_TRIGGER::PIN, GPIO_IN);
+    gpio_pull_down(EXT_TRIGGER::PIN);  // An open input never fires
+
+    // Raw handler: shares IO_IRQ_BANK0 with the FAULT IRQ on this core
+    gpio_add_raw_irq_handler(EXT_TRIGGER::PIN, irq_handler);
+    gpio_acknowledge_irq(EXT_TRIGGER::PIN, GPIO_IRQ_EDGE_RISE);
+    gpio_set_irq_enabled(EXT_TRIGGER::PIN, GPIO_IRQ_EDGE_RISE, true);
+    irq_set_enabled(IO_IRQ_BANK0, true);
+}
+
+void ExternalTrigger::irq_handler() {
+    ExternalTrigger* self = instance_;
+    if (!self || !(gpio_get_irq_event_mask(EXT_TRIGGER::PIN) & GPIO_IRQ_EDGE_RISE)) {
+        return;  // Shared IRQ: not ours
+    }
+    gpio_acknowledge_irq(EXT_TRIGGER::PIN, GPIO_IRQ_EDGE_RISE);
+    self->edges_ = self->edges_ + 1;
+
+    // One commit per arm: disarm first, so the commit itself is not skipped
+    bool commit = self->armed_;
+    self->armed_ = false;
+    self->boards_.on_external_trigger(commit);
+}
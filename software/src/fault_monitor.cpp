@@ -0,0 +1,135 @@
+#include "fault_monitor.hpp"
+#include "spi_manager.hpp"
+#include "bus_guard.hpp"
+#include "pico/stdlib.h"
+#include "hardware/gpio.h"
+#include "hardware/irq.h"
+#include "hardware/sync.h"
+
+FaultMonitor* FaultMonitor::instance_ = nullptr;
+
+#ifdef SINGLE_BOARD_MODE
+static constexpr uint FAULT_PIN = HW_PINS_SINGLE::FAULT;
+#else
+static constexpr uint FAULT_PIN = HW_PINS::FAULT;
+#endif
+
+static constexpr uint32_t FAULT_EDGES = GPIO_IRQ_EDGE_FALL | GPIO_IRQ_EDGE_RISE;
+
+void FaultMonitor::start() {
+    instance_ = this;
+
+    // Raw handler: other GPIO IRQs can share IO_IRQ_BANK0 on this core
+    gpio_add_raw_irq_handler(FAULT_PIN, irq_handler);
+    gpio_acknowledge_irq(FAULT_PIN, FAULT_EDGES);
+    gpio_set_irq_enabled(FAULT_PIN, FAULT_EDGES, true);
+    irq_set_enabled(IO_IRQ_BANK0, true);
+
+    // An edge during the first capture is taken again once the guard drops
+    BusGuard guard;
+    capture(time_us_64());
+    changed_us_ = captured_us_;
+    started_ = true;
+}
+
+void FaultMonitor::irq_handler() {
+    FaultMonitor* self = instance_;
+    uint32_t events = gpio_get_irq_event_mask(FAULT_PIN) & FAULT_EDGES;
+    if (!self || !events) return;  // Shared IRQ: not ours
+    gpio_acknowledge_irq(FAULT_PIN, events);
+    self->edges_ = self->edges_ + 1;
+
+    uint64_t now = time_us_64();
+    uint64_t age = now - self->captured_us_;
+    if (age < FAULT_MONITOR::MIN_CAPTURE_INTERVAL_US) {
+        // Without a later capture, the state after a short pulse would sit
+        // in the cache until the next edge
+        if (!self->pending_) {
+            self->pending_ = true;
+            uint64_t delay_us = FAULT_MONITOR::MIN_CAPTURE_INTERVAL_US - age;
+            // On failure (no free alarm slot) refresh() takes it instead
+            if (self->alarm_pool_) {
+                alarm_pool_add_alarm_in_us(self->alarm_pool_, delay_us, deferred_capture, self, true);
+            } else {
+                add_alarm_in_us(delay_us, deferred_capture, self, true);
+            }
+        }
+        return;
+    }
+    self->capture(now);
+}
+
+int64_t FaultMonitor::deferred_capture(alarm_id_t, void* user_data) {
+    // Timer IRQ on the same core as the FAULT IRQ: neither preempts the
+    // other, and bus users hold a BusGuard
+    FaultMonitor* self = static_cast<FaultMonitor*>(user_data);
+    if (self->pending_) self->capture(time_us_64());
+    return 0;  // One-shot
+}
+
+void FaultMonitor::refresh() {
+    if (!started_) return;
+
+    uint64_t now = time_us_64();
+    uint64_t age = now - captured_us_;
+    bool stale = spi_.is_fault_active() && age >= FAULT_MONITOR::REFRESH_INTERVAL_US;
+    if (!stale && !(pending_ && age >= FAULT_MONITOR::MIN_CAPTURE_INTERVAL_US)) return;
+
+    BusGuard guard;
+    capture(time_us_64());
+}
+
+void FaultMonitor::capture(uint64_t now) {
+    bool active = spi_.is_fault_active();
+    uint32_t mask = 0;
+#ifndef SINGLE_BOARD_MODE
+    if (active) {
+        // INTCAP holds the inputs as they were when the interrupt fired, so
+        // a fault that has already cleared is still reported until the next
+        // capture
+        IoExpander& io = spi_.io_expander();
+        mask = (io.read_fault_capture() | io.read_faults()) & fitted_;
+    }
+#endif
+    captured_us_ = now;
+    pending_ = false;
+    if (active != active_ || mask != mask_) {
+        active_ = active;
+        mask_ = mask;
+        changed_us_ = now;
+    }
+}
+
+void FaultMonitor::set_fitted(uint32_t dac_mask) {
+    fitted_ = dac_mask;
+#ifndef SINGLE_BOARD_MODE
+    spi_.io_expander().enable_fault_inputs(dac_mask);
+#endif
+}
+
+FaultState FaultMonitor::state() const {
+    // The IRQ updates several fields; read them as one
+    uint32_t saved = save_and_disable_interrupts();
+    FaultState state{active_, mask_, changed_us_, edges_};
+    restore_interrupts(saved);
+    return state;
+}
+
+void FaultMonitor::set_notify(bool enable) {
+    notify_ = enable;
+    if (enable) {
+        // Only changes made from now on are reported
+        FaultState now = state();
+        noticed_active_ = now.active;
+        noticed_mask_ = now.mask;
+    }
+}
+
+bool FaultMonitor::take_notice(FaultState& state) {
+    if (!notify_) return false;
+    state = this->state();
+    if (state.active == noticed_active_ && state.mask == noticed_mask_) return false;
+    noticed_active_ = state.active;
+    noticed_mask_ = state.mask;
+    return true;
+}
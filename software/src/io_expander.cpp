@@ -1,5 +1,7 @@
 #include "io_expander.hpp"
 #include "hardware/gpio.h"
+#include "bus_guard.hpp"
+#include "perf_stats.hpp"
 
 void IoExpander::cs_assert() {
     gpio_put(HW_PINS::SPI_CS, 0);
@@ -10,17 +12,43 @@ void IoExpander::cs_release() {
 }
 
 void IoExpander::write_register(uint8_t hw_addr, uint8_t reg, uint8_t value) {
+    PerfScope perf(PerfProbe::EXPANDER_WRITE);
     uint8_t tx_buf[3] = {
         MCP23S17::write_opcode(hw_addr),
         reg,
         value
     };
 
+    BusGuard guard;
     cs_assert();
     spi_write_blocking(spi_, tx_buf, 3);
     cs_release();
 }
 
+void IoExpander::write_frame(const uint8_t* frame, size_t len) {
+    PerfScope perf(PerfProbe::EXPANDER_WRITE);
+    BusGuard guard;
+    cs_assert();
+    spi_write_blocking(spi_, frame, len);
+    cs_release();
+}
+
+void IoExpander::write_register_pair(uint8_t hw_addr, uint8_t reg_a, uint8_t value_a, uint8_t value_b) {
+    // Sequential operation (IOCON.SEQOP = 0) auto-increments the address
+    // pointer, so the second data byte lands in the Port B register
+    uint8_t tx_buf[4] = {
+        MCP23S17::write_opcode(hw_addr),
+        reg_a,
+        value_a,
+        value_b
+    };
+
+    BusGuard guard;
+    cs_assert();
+    spi_write_blocking(spi_, tx_buf, 4);
+    cs_release();
+}
+
 uint8_t IoExpander::read_register(uint8_t hw_addr, uint8_t reg) {
     uint8_t tx_buf[3] = {
         MCP23S17::read_opcode(hw_addr),
@@ -29,6 +57,7 @@ uint8_t IoExpander::read_register(uint8_t hw_addr, uint8_t reg) {
     };
     uint8_t rx_buf[3] = {0};
 
+    BusGuard guard;
     cs_assert();
     spi_write_read_blocking(spi_, tx_buf, rx_buf, 3);
     cs_release();
@@ -44,6 +73,7 @@ void IoExpander::write_gpio16(uint8_t hw_addr, uint16_t value) {
         static_cast<uint8_t>((value >> 8) & 0xFF)   // GPIOB (high byte, auto-increment)
     };
 
+    BusGuard guard;
     cs_assert();
     spi_write_blocking(spi_, tx_buf, 4);
     cs_release();
@@ -55,14 +85,19 @@ void IoExpander::write_gpio16(uint8_t hw_addr, uint16_t value) {
 }
 
 uint16_t IoExpander::read_gpio16(uint8_t hw_addr) {
+    return read_register_pair(hw_addr, MCP23S17::REG_GPIOA);
+}
+
+uint16_t IoExpander::read_register_pair(uint8_t hw_addr, uint8_t reg_a) {
     uint8_t tx_buf[4] = {
         MCP23S17::read_opcode(hw_addr),
-        MCP23S17::REG_GPIOA,
-        0x00,  // Dummy for GPIOA
-        0x00   // Dummy for GPIOB
+        reg_a,
+        0x00,  // Dummy for Port A
+        0x00   // Dummy for Port B (auto-increment)
     };
     uint8_t rx_buf[4] = {0};
 
+    BusGuard guard;
     cs_assert();
     spi_write_read_blocking(spi_, tx_buf, rx_buf, 4);
     cs_release();
@@ -73,32 +108,29 @@ uint16_t IoExpander::read_gpio16(uint8_t hw_addr) {
 void IoExpander::init_expander(uint8_t hw_addr, uint8_t iodira, uint8_t iodirb,
                                 uint8_t gpintena, uint8_t gpintenb,
                                 uint8_t defvala, uint8_t defvalb) {
+    // A/B registers are adjacent in BANK=0 mode, so each pair is written
+    // in a single sequential transaction
+
     // Configure I/O direction
-    write_register(hw_addr, MCP23S17::REG_IODIRA, iodira);
-    write_register(hw_addr, MCP23S17::REG_IODIRB, iodirb);
+    write_register_pair(hw_addr, MCP23S17::REG_IODIRA, iodira, iodirb);
 
     // Enable pull-ups on inputs (for fault lines)
-    write_register(hw_addr, MCP23S17::REG_GPPUA, iodira);  // Pull-up where input
-    write_register(hw_addr, MCP23S17::REG_GPPUB, iodirb);  // Pull-up where input
+    write_register_pair(hw_addr, MCP23S17::REG_GPPUA, iodira, iodirb);  // Pull-up where input
 
     // Configure interrupts if any enabled
     if (gpintena || gpintenb) {
         // Set default values for comparison (faults are active-low, expect high)
-        write_register(hw_addr, MCP23S17::REG_DEFVALA, defvala);
-        write_register(hw_addr, MCP23S17::REG_DEFVALB, defvalb);
+        write_register_pair(hw_addr, MCP23S17::REG_DEFVALA, defvala, defvalb);
 
         // Compare against DEFVAL (not previous value)
-        write_register(hw_addr, MCP23S17::REG_INTCONA, gpintena);
-        write_register(hw_addr, MCP23S17::REG_INTCONB, gpintenb);
+        write_register_pair(hw_addr, MCP23S17::REG_INTCONA, gpintena, gpintenb);
 
         // Enable interrupts
-        write_register(hw_addr, MCP23S17::REG_GPINTENA, gpintena);
-        write_register(hw_addr, MCP23S17::REG_GPINTENB, gpintenb);
+        write_register_pair(hw_addr, MCP23S17::REG_GPINTENA, gpintena, gpintenb);
     }
 
     // Initialize outputs to safe defaults (all zeros - D_EN disabled, LDAC/CLR idle)
-    write_register(hw_addr, MCP23S17::REG_GPIOA, 0x00);
-    write_register(hw_addr, MCP23S17::REG_GPIOB, 0x00);
+    write_register_pair(hw_addr, MCP23S17::REG_GPIOA, 0x00, 0x00);
 
     // Clear cache
     if (hw_addr < EXPANDER_ADDR::NUM_EXPANDERS) {
@@ -133,9 +165,8 @@ void IoExpander::init(spi_inst_t* spi) {
                   0x00); // DEFVALB (not used for outputs)
 
     // Set initial state: D_EN=0 (disabled), LDAC=1 (idle), CLR=1 (idle)
-    write_register(EXPANDER_ADDR::EXPANDER_0, MCP23S17::REG_GPIOA, 0x00);
-    write_register(EXPANDER_ADDR::EXPANDER_0, MCP23S17::REG_GPIOB,
-                   (1 << SIGNAL_MAP::LDAC_BIT) | (1 << SIGNAL_MAP::CLR_BIT));
+    write_register_pair(EXPANDER_ADDR::EXPANDER_0, MCP23S17::REG_GPIOA, 0x00,
+                        (1 << SIGNAL_MAP::LDAC_BIT) | (1 << SIGNAL_MAP::CLR_BIT));
     expander_cache_[EXPANDER_ADDR::EXPANDER_0] =
         ((1 << SIGNAL_MAP::LDAC_BIT) | (1 << SIGNAL_MAP::CLR_BIT)) << 8;
 
@@ -165,37 +196,41 @@ void IoExpander::init(spi_inst_t* spi) {
     clear_interrupts();
 }
 
+void IoExpander::prepare_select(uint8_t board_id, uint8_t device_id, uint8_t frame[3]) {
+    prepare_ctrl_port_a(select_value(board_id, device_id), frame);
+}
+
+void IoExpander::prepare_deselect(uint8_t frame[3]) {
+    // D_EN = 0 (disabled), CS bits = 0 (don't care when disabled)
+    prepare_ctrl_port_a(0, frame);
+}
+
+void IoExpander::prepare_ldac(uint8_t low_frame[3], uint8_t high_frame[3]) const {
+    // LDAC is on Port B, bit 0 (active-low); Port B is otherwise unchanged
+    uint8_t current_b = (expander_cache_[SIGNAL_MAP::CTRL_EXPANDER] >> 8) & 0xFF;
+    low_frame[0] = high_frame[0] = MCP23S17::write_opcode(SIGNAL_MAP::CTRL_EXPANDER);
+    low_frame[1] = high_frame[1] = MCP23S17::REG_GPIOB;
+    low_frame[2] = current_b & ~(1 << SIGNAL_MAP::LDAC_BIT);
+    high_frame[2] = current_b;
+}
+
 void IoExpander::set_dac_select(uint8_t board_id, uint8_t device_id) {
-    // Calculate 5-bit CS address
-    // Mapping: board_id (0-7) * 3 + device_id (0-2) = DAC index 0-23
-    // CS[4:0] encodes this 5-bit address for the decoder tree
-    uint8_t dac_index = (board_id * 3) + device_id;
-
-    // Build Port A value with CS bits (bit-reversed) and D_EN
-    // Hardware wiring: CS4→pin0, CS3→pin1, CS2→pin2, CS1→pin3, CS0→pin4
-    // So we need to reverse the bit order of the 5-bit address
-    uint8_t port_a_value = 0;
-    port_a_value |= ((dac_index >> 0) & 1) << SIGNAL_MAP::CS0_BIT;  // CS0 (bit 0 of index) → pin 4
-    port_a_value |= ((dac_index >> 1) & 1) << SIGNAL_MAP::CS1_BIT;  // CS1 (bit 1 of index) → pin 3
-    port_a_value |= ((dac_index >> 2) & 1) << SIGNAL_MAP::CS2_BIT;  // CS2 (bit 2 of index) → pin 2
-    port_a_value |= ((dac_index >> 3) & 1) << SIGNAL_MAP::CS3_BIT;  // CS3 (bit 3 of index) → pin 1
-    port_a_value |= ((dac_index >> 4) & 1) << SIGNAL_MAP::CS4_BIT;  // CS4 (bit 4 of index) → pin 0
-    port_a_value |= (1 << SIGNAL_MAP::D_EN_BIT);                    // Enable decoder tree
-
-    // Write to the control expander Port A
-    write_register(SIGNAL_MAP::CTRL_EXPANDER, MCP23S17::REG_GPIOA, port_a_value);
-
-    // Update cache (Port A in low byte)
-    expander_cache_[SIGNAL_MAP::CTRL_EXPANDER] =
-        (expander_cache_[SIGNAL_MAP::CTRL_EXPANDER] & 0xFF00) | port_a_value;
+    uint8_t frame[3];
+    prepare_select(board_id, device_id, frame);
+    write_frame(frame, sizeof(frame));
 }
 
 void IoExpander::deselect_dac() {
-    // Clear D_EN to disable decoder tree (Port A)
-    // D_EN = 0 (disabled), CS bits = 0 (don't care when disabled)
-    uint8_t port_a_value = 0;
+    uint8_t frame[3];
+    prepare_deselect(frame);
+    write_frame(frame, sizeof(frame));
+}
 
-    write_register(SIGNAL_MAP::CTRL_EXPANDER, MCP23S17::REG_GPIOA, port_a_value);
+void IoExpander::prepare_ctrl_port_a(uint8_t port_a_value, uint8_t frame[3]) {
+    // Register write to the control expander Port A
+    frame[0] = MCP23S17::write_opcode(SIGNAL_MAP::CTRL_EXPANDER);
+    frame[1] = MCP23S17::REG_GPIOA;
+    frame[2] = port_a_value;
 
     // Update cache (Port A in low byte, Port B unchanged)
     expander_cache_[SIGNAL_MAP::CTRL_EXPANDER] =
@@ -203,19 +238,18 @@ void IoExpander::deselect_dac() {
 }
 
 void IoExpander::pulse_ldac() {
-    // LDAC is on Port B, bit 0 (active-low)
-    // Read current Port B value from cache (high byte)
-    uint8_t current_b = (expander_cache_[SIGNAL_MAP::CTRL_EXPANDER] >> 8) & 0xFF;
+    uint8_t ldac_low[3];
+    uint8_t ldac_high[3];
+    prepare_ldac(ldac_low, ldac_high);
 
-    // Clear LDAC bit (active-low pulse)
-    uint8_t ldac_low = current_b & ~(1 << SIGNAL_MAP::LDAC_BIT);
-    write_register(SIGNAL_MAP::CTRL_EXPANDER, MCP23S17::REG_GPIOB, ldac_low);
+    BusGuard guard;
+    write_frame(ldac_low, sizeof(ldac_low));
 
     // Brief delay for LDAC pulse (min ~20ns per datasheet, but add margin)
     sleep_us(1);
 
     // Restore LDAC high
-    write_register(SIGNAL_MAP::CTRL_EXPANDER, MCP23S17::REG_GPIOB, current_b);
+    write_frame(ldac_high, sizeof(ldac_high));
 }
 
 void IoExpander::assert_clear() {
@@ -241,6 +275,14 @@ void IoExpander::release_clear() {
 }
 
 uint32_t IoExpander::read_faults() {
+    return read_fault_inputs(MCP23S17::REG_GPIOA);
+}
+
+uint32_t IoExpander::read_fault_capture() {
+    return read_fault_inputs(MCP23S17::REG_INTCAPA);
+}
+
+uint32_t IoExpander::read_fault_inputs(uint8_t reg_a) {
     // Read fault inputs from expanders 1 and 2
     // Faults are active-low, so invert to get "1 = fault present"
     //
@@ -255,36 +297,30 @@ uint32_t IoExpander::read_faults() {
     //   DAC index = board_id * 3 + device_id
     //   So bit 0 = B0D0, bit 1 = B0D1, bit 2 = B0D2, bit 3 = B1D0, etc.
 
-    uint16_t exp1 = read_gpio16(SIGNAL_MAP::FAULT_EXPANDER);
-    uint8_t exp2_a = read_register(SIGNAL_MAP::TEMP_EXPANDER, MCP23S17::REG_GPIOA);
-
-    // Invert (active-low to active-high)
-    uint16_t ltc2662_faults = ~exp1;      // 16 current DAC faults
-    uint8_t ltc2664_faults = ~exp2_a;     // 8 voltage DAC temperature faults
+    uint16_t exp1 = read_register_pair(SIGNAL_MAP::FAULT_EXPANDER, reg_a);
+    uint8_t exp2_a = read_register(SIGNAL_MAP::TEMP_EXPANDER, reg_a);
 
-    // Reorganize bits to match DAC index scheme
-    // For each board, we need: DAC0 fault, DAC1 fault, DAC2 temp fault
-    uint32_t faults = 0;
-
-    for (int board = 0; board < 8; board++) {
-        int dac_base_index = board * 3;
-
-        // LTC2662 faults are at pins (board*2) and (board*2+1) within exp1
-        // Boards 0-3 are in Port A (low byte), Boards 4-7 are in Port B (high byte)
-        int fault_pin_base = board * 2;
-        uint8_t dac0_fault = (ltc2662_faults >> fault_pin_base) & 1;
-        uint8_t dac1_fault = (ltc2662_faults >> (fault_pin_base + 1)) & 1;
-
-        // LTC2664 temperature fault is at pin (board) within exp2_a
-        uint8_t dac2_fault = (ltc2664_faults >> board) & 1;
+    // Invert (active-low to active-high) and reorganize, one table lookup per nibble
+    return EXPANDER_LUT::remap_faults(static_cast<uint16_t>(~exp1), static_cast<uint8_t>(~exp2_a));
+}
 
-        // Set output bits
-        faults |= (static_cast<uint32_t>(dac0_fault) << dac_base_index);
-        faults |= (static_cast<uint32_t>(dac1_fault) << (dac_base_index + 1));
-        faults |= (static_cast<uint32_t>(dac2_fault) << (dac_base_index + 2));
+void IoExpander::enable_fault_inputs(uint32_t dac_mask) {
+    // Inverse of EXPANDER_LUT::remap_faults: FAULT_EXPANDER pin board * 2 +
+    // device for the LTC2662s, TEMP_EXPANDER pin board for the LTC2664
+    uint16_t current = 0;
+    uint8_t temp = 0;
+    for (uint8_t board = 0; board < 8; board++) {
+        uint32_t bits = dac_mask >> (board * 3);
+        if (bits & 0x1) current |= 1u << (board * 2);
+        if (bits & 0x2) current |= 1u << (board * 2 + 1);
+        if (bits & 0x4) temp |= 1u << board;
     }
+    write_register_pair(SIGNAL_MAP::FAULT_EXPANDER, MCP23S17::REG_GPINTENA,
+                        static_cast<uint8_t>(current & 0xFF), static_cast<uint8_t>(current >> 8));
+    write_register_pair(SIGNAL_MAP::TEMP_EXPANDER, MCP23S17::REG_GPINTENA, temp, 0x00);
 
-    return faults;
+    // Drop anything a disabled input latched
+    clear_interrupts();
 }
 
 void IoExpander::clear_interrupts() {
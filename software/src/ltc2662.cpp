@@ -11,6 +11,7 @@ void LTC2662::setup(SpiManager* spi, uint8_t board_id, uint8_t device_id, uint8_
     device_id_ = device_id;
     resolution_bits_ = (resolution_bits == 12) ? 12 : 16;  // Only 12 or 16 valid
     max_code_ = (resolution_bits_ == 12) ? 4095 : 65535;
+    clear_shadow();
 }
 
 void LTC2662::init() {
@@ -24,23 +25,87 @@ void LTC2662::init() {
 
 void LTC2662::write_code(uint8_t channel, uint16_t code) {
     if (channel >= NUM_CHANNELS) return;
+    if (elide_writes_ && (input_valid_ & (1u << channel)) && input_reg_[channel] == code) {
+        elided_writes_++;
+        return;
+    }
+    input_reg_[channel] = code;
+    input_valid_ |= 1u << channel;
     code = (resolution_bits_ == 12) ? code << 4 : code;
     send_command(DAC_CMD::WRITE_CODE_N, channel, code);
 }
 
 void LTC2662::write_and_update(uint8_t channel, uint16_t code) {
     if (channel >= NUM_CHANNELS) return;
+    if (elide_writes_ && (input_valid_ & ~stale_ & (1u << channel)) &&
+        input_reg_[channel] == code && dac_reg_[channel] == code) {
+        elided_writes_++;
+        return;
+    }
+    input_reg_[channel] = code;
+    dac_reg_[channel] = code;
+    input_valid_ |= 1u << channel;
+    stale_ &= ~(1u << channel);
     code = (resolution_bits_ == 12) ? code << 4 : code;
     send_command(DAC_CMD::WRITE_UPDATE_N, channel, code);
 }
 
+void LTC2662::write_code_all(uint16_t code) {
+    for (uint8_t i = 0; i < NUM_CHANNELS; i++) {
+        input_reg_[i] = code;
+    }
+    input_valid_ = (1u << NUM_CHANNELS) - 1;
+    code = (resolution_bits_ == 12) ? code << 4 : code;
+    send_command(DAC_CMD::WRITE_CODE_ALL, 0, code);
+}
+
+void LTC2662::write_and_update_all(uint16_t code) {
+    for (uint8_t i = 0; i < NUM_CHANNELS; i++) {
+        input_reg_[i] = code;
+        dac_reg_[i] = code;
+    }
+    input_valid_ = (1u << NUM_CHANNELS) - 1;
+    stale_ = 0;
+    code = (resolution_bits_ == 12) ? code << 4 : code;
+    send_command(DAC_CMD::WRITE_UPDATE_ALL2, 0, code);
+}
+
 void LTC2662::update_channel(uint8_t channel) {
     if (channel >= NUM_CHANNELS) return;
     send_command(DAC_CMD::UPDATE_N, channel, 0);
+    dac_reg_[channel] = input_reg_[channel];
+    stale_ &= ~(1u << channel);
 }
 
 void LTC2662::update_all() {
     send_command(DAC_CMD::UPDATE_ALL, 0, 0);
+    latch_inputs();
+}
+
+uint16_t LTC2662::get_input_code(uint8_t channel) const {
+    if (channel >= NUM_CHANNELS) return 0;
+    return input_reg_[channel];
+}
+
+uint16_t LTC2662::get_dac_code(uint8_t channel) const {
+    if (channel >= NUM_CHANNELS) return 0;
+    return dac_reg_[channel];
+}
+
+void LTC2662::latch_inputs() {
+    for (uint8_t i = 0; i < NUM_CHANNELS; i++) {
+        dac_reg_[i] = input_reg_[i];
+    }
+    stale_ = 0;
+}
+
+void LTC2662::clear_shadow() {
+    for (uint8_t i = 0; i < NUM_CHANNELS; i++) {
+        input_reg_[i] = 0;
+        dac_reg_[i] = 0;
+    }
+    input_valid_ = 0;
+    stale_ = (1u << NUM_CHANNELS) - 1;
 }
 
 void LTC2662::set_span(uint8_t channel, uint8_t span_code) {
@@ -49,6 +114,7 @@ void LTC2662::set_span(uint8_t channel, uint8_t span_code) {
     // Span code goes in lower 4 bits of data
     send_command(DAC_CMD::WRITE_SPAN_N, channel, span_code & 0x0F);
     span_[channel] = span_code;
+    stale_ |= 1u << channel;
 }
 
 void LTC2662::set_span_all(uint8_t span_code) {
@@ -57,15 +123,18 @@ void LTC2662::set_span_all(uint8_t span_code) {
     for (uint8_t i = 0; i < NUM_CHANNELS; i++) {
         span_[i] = span_code;
     }
+    stale_ = (1u << NUM_CHANNELS) - 1;
 }
 
 void LTC2662::power_down(uint8_t channel) {
     if (channel >= NUM_CHANNELS) return;
     send_command(DAC_CMD::POWER_DOWN_N, channel, 0);
+    stale_ |= 1u << channel;
 }
 
 void LTC2662::power_down_chip() {
     send_command(DAC_CMD::POWER_DOWN_CHIP, 0, 0);
+    stale_ = (1u << NUM_CHANNELS) - 1;
 }
 
 float LTC2662::get_full_scale_ma(uint8_t channel) const {
@@ -89,6 +158,15 @@ uint16_t LTC2662::current_ma_to_code(uint8_t channel, float current_ma) const {
     return static_cast<uint16_t>((current_ma / fs) * static_cast<float>(max_code_) + 0.5f);
 }
 
+float LTC2662::code_to_current_ma(uint8_t channel, uint16_t code) const {
+    if (channel >= NUM_CHANNELS) return 0.0f;
+
+    float fs = get_full_scale_ma(channel);
+    if (fs <= 0.0f) return 0.0f;  // Hi-Z or invalid span
+
+    return (static_cast<float>(code) / static_cast<float>(max_code_)) * fs;
+}
+
 void LTC2662::set_current_ma(uint8_t channel, float current_ma) {
     if (channel >= NUM_CHANNELS) return;
 
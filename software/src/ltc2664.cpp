@@ -11,6 +11,7 @@ void LTC2664::setup(SpiManager* spi, uint8_t board_id, uint8_t device_id, uint8_
     device_id_ = device_id;
     resolution_bits_ = (resolution_bits == 12) ? 12 : 16;  // Only 12 or 16 valid
     max_code_ = (resolution_bits_ == 12) ? 4095 : 65535;
+    clear_shadow();
 }
 
 void LTC2664::init() {
@@ -25,23 +26,87 @@ void LTC2664::init() {
 
 void LTC2664::write_code(uint8_t channel, uint16_t code) {
     if (channel >= NUM_CHANNELS) return;
+    if (elide_writes_ && (input_valid_ & (1u << channel)) && input_reg_[channel] == code) {
+        elided_writes_++;
+        return;
+    }
+    input_reg_[channel] = code;
+    input_valid_ |= 1u << channel;
     code = (resolution_bits_ == 12) ? code << 4 : code;
     send_command(DAC_CMD::WRITE_CODE_N, channel, code);
 }
 
 void LTC2664::write_and_update(uint8_t channel, uint16_t code) {
     if (channel >= NUM_CHANNELS) return;
+    if (elide_writes_ && (input_valid_ & ~stale_ & (1u << channel)) &&
+        input_reg_[channel] == code && dac_reg_[channel] == code) {
+        elided_writes_++;
+        return;
+    }
+    input_reg_[channel] = code;
+    dac_reg_[channel] = code;
+    input_valid_ |= 1u << channel;
+    stale_ &= ~(1u << channel);
     code = (resolution_bits_ == 12) ? code << 4 : code;
     send_command(DAC_CMD::WRITE_UPDATE_N, channel, code);
 }
 
+void LTC2664::write_code_all(uint16_t code) {
+    for (uint8_t i = 0; i < NUM_CHANNELS; i++) {
+        input_reg_[i] = code;
+    }
+    input_valid_ = (1u << NUM_CHANNELS) - 1;
+    code = (resolution_bits_ == 12) ? code << 4 : code;
+    send_command(DAC_CMD::WRITE_CODE_ALL, 0, code);
+}
+
+void LTC2664::write_and_update_all(uint16_t code) {
+    for (uint8_t i = 0; i < NUM_CHANNELS; i++) {
+        input_reg_[i] = code;
+        dac_reg_[i] = code;
+    }
+    input_valid_ = (1u << NUM_CHANNELS) - 1;
+    stale_ = 0;
+    code = (resolution_bits_ == 12) ? code << 4 : code;
+    send_command(DAC_CMD::WRITE_UPDATE_ALL2, 0, code);
+}
+
 void LTC2664::update_channel(uint8_t channel) {
     if (channel >= NUM_CHANNELS) return;
     send_command(DAC_CMD::UPDATE_N, channel, 0);
+    dac_reg_[channel] = input_reg_[channel];
+    stale_ &= ~(1u << channel);
 }
 
 void LTC2664::update_all() {
     send_command(DAC_CMD::UPDATE_ALL, 0, 0);
+    latch_inputs();
+}
+
+uint16_t LTC2664::get_input_code(uint8_t channel) const {
+    if (channel >= NUM_CHANNELS) return 0;
+    return input_reg_[channel];
+}
+
+uint16_t LTC2664::get_dac_code(uint8_t channel) const {
+    if (channel >= NUM_CHANNELS) return 0;
+    return dac_reg_[channel];
+}
+
+void LTC2664::latch_inputs() {
+    for (uint8_t i = 0; i < NUM_CHANNELS; i++) {
+        dac_reg_[i] = input_reg_[i];
+    }
+    stale_ = 0;
+}
+
+void LTC2664::clear_shadow() {
+    for (uint8_t i = 0; i < NUM_CHANNELS; i++) {
+        input_reg_[i] = 0;
+        dac_reg_[i] = 0;
+    }
+    input_valid_ = 0;
+    stale_ = (1u << NUM_CHANNELS) - 1;
 }
 
 void LTC2664::set_span(uint8_t channel, uint8_t span_code) {
@@ -51,6 +116,7 @@ void LTC2664::set_span(uint8_t channel, uint8_t span_code) {
     // Span code goes in lower 3 bits of data
     send_command(DAC_CMD::WRITE_SPAN_N, channel, span_code & 0x07);
     span_[channel] = span_code;
+    stale_ |= 1u << channel;
 }
 
 void LTC2664::set_span_all(uint8_t span_code) {
@@ -61,15 +127,18 @@ void LTC2664::set_span_all(uint8_t span_code) {
     for (uint8_t i = 0; i < NUM_CHANNELS; i++) {
         span_[i] = span_code;
     }
+    stale_ = (1u << NUM_CHANNELS) - 1;
 }
 
 void LTC2664::power_down(uint8_t channel) {
     if (channel >= NUM_CHANNELS) return;
     send_command(DAC_CMD::POWER_DOWN_N, channel, 0);
+    stale_ |= 1u << channel;
 }
 
 void LTC2664::power_down_chip() {
     send_command(DAC_CMD::POWER_DOWN_CHIP, 0, 0);
+    stale_ = (1u << NUM_CHANNELS) - 1;
 }
 
 float LTC2664::get_min_voltage(uint8_t channel) const {
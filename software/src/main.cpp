@@ -1,7 +1,6 @@
-// main loop: initialize all peripherals, enter command parsing loop
+// main loop: initialize all peripherals, hand SPI to core 1, enter command parsing loop
 #include <stdio.h>
 #include <cstring>
-#include <string>
 #include "pico/stdlib.h"
 #include "hardware/spi.h"
 #include "tusb.h" // tinyusb, for usb serial
@@ -9,19 +8,50 @@
 #include "scpi_parser.hpp"
 #include "board_manager.hpp"
 #include "spi_manager.hpp"
+#include "binary_protocol.hpp"
+#include "core_link.hpp"
+#include "perf_stats.hpp"
 
 // Line buffer for serial input
-static constexpr size_t LINE_BUFFER_SIZE = 256;
+// Sized for a full APPLY batch (one entry per channel on all boards)
+static constexpr size_t LINE_BUFFER_SIZE = SCPI::MAX_LINE_LENGTH;
 static char line_buffer[LINE_BUFFER_SIZE];
 static size_t line_pos = 0;
+static size_t echo_pos = 0;  // Characters of line_buffer already echoed
+static bool line_overflow = false;  // Characters were dropped from the current line
+
+// Lines read while earlier commands were still executing on core 1
+// Their echo is held back until the preceding reply and prompt are out,
+// so the serial stream reads exactly as if the commands ran one at a time.
+static char held_echo[CORE_LINK::QUEUE_DEPTH][LINE_BUFFER_SIZE];
+static size_t held_head = 0;
+static size_t held_count = 0;
+
+// Quiet mode (SYST:QUIET 1): no echo and no prompt, each reply is just a
+// line, so a host can stream commands without waiting for the prompt.
+// It follows parse order, so each line records the mode its reply is printed in.
+static bool quiet = false;
+static bool line_quiet[CORE_LINK::QUEUE_DEPTH];
+static size_t line_head = 0;
+static size_t line_count = 0;
+
+// Rest of a ';' compound line still to be parsed and submitted
+static char* next_command = nullptr;
 
 // Global instances
 static SpiManager spi_manager;
 static ScpiParser parser;
 
+// Reply text from core 1 goes straight to USB
+static void print_char(char c) {
+    putchar(c);
+}
+
 // Read a line from USB serial (non-blocking)
-// Returns true if a complete line was read
-static bool read_line() {
+// Characters are echoed as typed only when `echo` is set
+// Returns true if a complete line was read; `overflow` is set if it did not
+// fit the buffer, in which case the line must not be run
+static bool read_line(bool echo, bool& overflow) {
     while (true) {
         int c = getchar_timeout_us(0);
         if (c == PICO_ERROR_TIMEOUT) {
@@ -32,6 +62,9 @@ static bool read_line() {
             if (line_pos > 0) {
                 line_buffer[line_pos] = '\0';
                 line_pos = 0;
+                echo_pos = 0;
+                overflow = line_overflow;
+                line_overflow = false;
                 return true;
             }
             // Skip empty lines
@@ -42,55 +75,112 @@ static bool read_line() {
             // Handle backspace
             if (line_pos > 0) {
                 line_pos--;
-                printf("\b \b");  // Erase character on terminal
+                if (echo_pos > line_pos) {
+                    echo_pos = line_pos;
+                    printf("\b \b");  // Erase character on terminal
+                }
             }
             continue;
         }
 
         // Only accept printable ASCII characters
-        if (c >= 0x20 && c <= 0x7E && line_pos < LINE_BUFFER_SIZE - 1) {
-            line_buffer[line_pos++] = static_cast<char>(c);
+        if (c < 0x20 || c > 0x7E) continue;
+        if (line_pos >= LINE_BUFFER_SIZE - 1) {
+            line_overflow = true;  // Rejected as a whole at the end of the line
+            continue;
+        }
+        line_buffer[line_pos++] = static_cast<char>(c);
+        if (echo) {
             putchar(c);  // Echo character
+            echo_pos = line_pos;
         }
     }
 }
 
+// Mode for the reply that completes the oldest line in flight
+static bool pop_line_quiet() {
+    bool q = line_quiet[line_head];
+    line_head = (line_head + 1) % CORE_LINK::QUEUE_DEPTH;
+    line_count--;
+    return q;
+}
+
+// Echo whatever part of the current line has not been shown yet
+static void catch_up_echo() {
+    for (; echo_pos < line_pos; echo_pos++) {
+        putchar(line_buffer[echo_pos]);
+    }
+}
+
 int main() {
     // Initialize USB stdio
     stdio_init_all();
 
-    // Wait for USB connection (optional, helps with debugging)
+    // Cycle counter for the SYST:STAT? probes (core 1 starts its own)
+    PerfStats::enable_cycle_counter();
+
+    // Initialize SPI manager (includes GPIO, SPI peripheral, IO expanders)
+    spi_manager.init();
+
+    // Static: DAC objects, calibration and sequencer tables are too large for the stack
+    static BoardManager board_manager(spi_manager);
+
+    // Binary protocol handler (entered with SYST:BIN)
+    static BinaryProtocol binary(board_manager, spi_manager);
+    bool binary_mode = false;
+    bool awaiting_binary = false;  // SYST:BIN queued; stop reading text input
+
+    // Hand the SPI bus to core 1, which initializes the DACs and restores
+    // the calibration right away; outputs no longer wait for a host.
+    // From here on core 0 only parses and talks USB.
+    static CoreLink link(board_manager, spi_manager, binary);
+    link.launch();
+
+    // Wait for USB connection (the banner helps with debugging)
     while (!tud_cdc_connected()) {
-        sleep_ms(100);
+        sleep_ms(10);
     }
     sleep_ms(100);  // Extra settle time
 
     // Print startup banner
     printf("\r\n");
     printf("greymatter DAC Controller v0.1\r\n");
+
+    // Normally long done by the time a host has enumerated the port
+    const BootReport* boot;
+    while (!(boot = link.boot_report())) {
+        tight_loop_contents();
+    }
 #ifdef SINGLE_BOARD_MODE
     printf("Mode: Single-board (1 board, 3 DACs, direct GPIO CS)\r\n");
 #else
-    printf("Mode: Multi-board (8 boards, 24 DACs, IO expander CS)\r\n");
+    unsigned fitted = __builtin_popcount(boot->boards);
+    printf("Mode: Multi-board (%u boards, %u DACs, IO expander CS), fitted: 0x%02X\r\n",
+           fitted, fitted * DACS_PER_BOARD, boot->boards);
+    if (!boot->probed) {
+        printf("WARNING: No board answered the probe; using all %u slots\r\n", NUM_BOARDS);
+    }
 #endif
     printf("SPI clock: %lu Hz\r\n", (unsigned long)SPI_CONFIG::BAUDRATE);
-    printf("Initializing...\r\n");
-
-    // Initialize SPI manager (includes GPIO, SPI peripheral, IO expanders)
-    spi_manager.init();
-    printf("SPI and IO expanders initialized.\r\n");
-
-    // Initialize board manager with all DACs
-    BoardManager board_manager(spi_manager);
-    board_manager.init_all();
-    printf("All DACs initialized.\r\n");
+#ifdef SINGLE_BOARD_MODE
+    printf("PIO frame clock: %lu Hz\r\n", (unsigned long)spi_manager.pio_baudrate());
+#endif
+    printf("All DACs initialized in %lu us, ready %lu us after reset.\r\n",
+           (unsigned long)boot->init_us, (unsigned long)boot->ready_us);
+    printf(boot->calibration ? "Calibration loaded from flash.\r\n"
+                             : "No valid calibration data in flash.\r\n");
+    if (boot->snapshot && boot->snapshot_error == ScpiError::NONE) {
+        printf("Restored output snapshot %s.\r\n", boot->snapshot);
+    } else if (boot->snapshot) {
+        printf("WARNING: Power-up snapshot %s not restored (%s)\r\n",
+               boot->snapshot, scpi_error_message(boot->snapshot_error));
+    }
 
-    // Check for any initial faults
-    if (spi_manager.is_fault_active()) {
+    // Faults at boot, from core 1's first capture
+    if (boot->fault_active) {
         printf("WARNING: FAULT line is active!\r\n");
 #ifndef SINGLE_BOARD_MODE
-        uint32_t faults = spi_manager.io_expander().read_faults();
-        printf("Fault mask: 0x%06lX\r\n", faults);
+        printf("Fault mask: 0x%06lX\r\n", (unsigned long)boot->fault_mask);
 #else
         printf("(Cannot identify which DAC in single-board mode)\r\n");
 #endif
@@ -105,17 +195,124 @@ int main() {
     printf("> ");
 
     // Main command loop
+    LinkEvent event;
+    uint8_t out_byte;
     while (true) {
-        if (read_line()) {
-            printf("\r\n");
+        // Binary reply bytes from core 1 (putchar_raw bypasses CR/LF translation)
+        while (link.output_byte(out_byte)) {
+            putchar_raw(out_byte);
+        }
+
+        // Replies from core 1, in command order
+        while (link.poll(event, print_char)) {
+            // Anything core 1 emitted before this event goes out first
+            while (link.output_byte(out_byte)) {
+                putchar_raw(out_byte);
+            }
+
+            switch (event) {
+                case LinkEvent::REPLY_PART:
+                    // Responses to one compound line are joined with ';'
+                    putchar(';');
+                    break;
+
+                case LinkEvent::REPLY:
+                    if (pop_line_quiet()) {
+                        printf("\r\n");
+                        break;
+                    }
+                    printf("\r\n> ");
+                    if (held_count > 0) {
+                        // Next command was read early: now show its echo
+                        printf("%s\r\n", held_echo[held_head]);
+                        held_head = (held_head + 1) % CORE_LINK::QUEUE_DEPTH;
+                        held_count--;
+                    } else {
+                        catch_up_echo();
+                    }
+                    break;
+
+                case LinkEvent::ENTER_BINARY:
+                    // No prompt: the next byte from the host starts a frame
+                    printf("\r\n");
+                    pop_line_quiet();
+                    binary_mode = true;
+                    break;
 
-            // Parse and execute SCPI command
-            ScpiCommand cmd = parser.parse(line_buffer);
-            std::string response = board_manager.execute(cmd);
+                case LinkEvent::EXIT_BINARY:
+                    binary_mode = false;
+                    if (!quiet) printf("> ");
+                    break;
 
-            // Print response
-            printf("%s\r\n", response.c_str());
-            printf("> ");
+                case LinkEvent::NOTICE:
+                    // A line of its own; re-prompt if it landed on an idle prompt
+                    printf("\r\n");
+                    if (!quiet && link.outstanding() == 0) printf("> ");
+                    break;
+            }
+            if (link.outstanding() == 0) awaiting_binary = false;
+        }
+
+        if (binary_mode) {
+            // Binary mode: forward raw bytes to core 1's frame decoder (no echo)
+            int c;
+            bool forwarded = false;
+            while (link.rx_space() && (c = getchar_timeout_us(0)) != PICO_ERROR_TIMEOUT) {
+                link.forward_byte(static_cast<uint8_t>(c));
+                forwarded = true;
+            }
+            if (forwarded) link.forwarded();
+        } else if (!awaiting_binary && link.can_submit()) {
+            bool overflow = false;
+            if (!next_command && read_line(!quiet && link.outstanding() == 0, overflow)) {
+                if (quiet) {
+                    // No echo to finish or hold back
+                } else if (link.outstanding() == 0) {
+                    printf("\r\n");
+                } else {
+                    size_t slot = (held_head + held_count) % CORE_LINK::QUEUE_DEPTH;
+                    memcpy(held_echo[slot], line_buffer, strlen(line_buffer) + 1);
+                    held_count++;
+                }
+                next_command = line_buffer;
+
+                if (overflow) {
+                    // A cut-off line (e.g. half an APPLY batch) is answered
+                    // with one error instead of running what arrived
+                    next_command = nullptr;
+                    ScpiCommand* cmd = link.claim();
+                    cmd->reset();
+                    cmd->error = ScpiError::LINE_TOO_LONG;
+                    cmd->chained = false;
+                    line_quiet[(line_head + line_count) % CORE_LINK::QUEUE_DEPTH] = quiet;
+                    line_count++;
+                    link.submit();
+                }
+            }
+
+            // Parse each command of the line straight into its queue slot,
+            // while core 1 is still busy with earlier commands
+            while (next_command && link.can_submit()) {
+                char* text = next_command;
+                next_command = scpi_split_compound(text);
+
+                ScpiCommand* cmd = link.claim();
+                parser.parse(text, *cmd);
+                if (cmd->valid && cmd->type == ScpiCommandType::SYST_BINARY) {
+                    // SYST:BIN ends the line; anything after it is dropped
+                    awaiting_binary = true;
+                    next_command = nullptr;
+                } else if (cmd->valid && cmd->type == ScpiCommandType::SYST_SET_QUIET) {
+                    quiet = (cmd->int_value != 0);
+                }
+
+                cmd->chained = (next_command != nullptr);
+                if (!cmd->chained) {
+                    line_quiet[(line_head + line_count) % CORE_LINK::QUEUE_DEPTH] = quiet;
+                    line_count++;
+                }
+                link.submit();
+            }
         }
 
         // Brief yield to allow USB processing
@@ -123,4 +320,4 @@ int main() {
     }
 
     return 0;
-}
\ No newline at end of file
+}
@@ -0,0 +1,105 @@
+#include "perf_stats.hpp"
+#include "response_buffer.hpp"
+#include "hardware/clocks.h"
+#include "hardware/sync.h"
+#include <cstring>
+
+namespace {
+
+struct ProbeSlot {
+    PerfCounter counter;
+    // Odd while the owning core updates the counter (the reader on the
+    // other core retries)
+    volatile uint32_t sequence;
+    // Set by report(); the owning core clears the counter at its next sample
+    volatile bool reset_requested;
+};
+
+constexpr size_t PROBE_COUNT = static_cast<size_t>(PerfProbe::COUNT_);
+
+const char* const PROBE_NAMES[PROBE_COUNT] = {"SPI", "EXPW", "PARSE", "EXEC"};
+
+ProbeSlot slots[PROBE_COUNT];
+
+void clear(PerfCounter& counter) {
+    std::memset(&counter, 0, sizeof(counter));
+    counter.min = UINT32_MAX;
+}
+
+size_t bucket_of(uint32_t cycles) {
+    uint32_t bits = 32 - static_cast<uint32_t>(__builtin_clz(cycles | 1));
+    if (bits < PERF_STATS::FIRST_BUCKET_BITS) return 0;
+    size_t bucket = bits - PERF_STATS::FIRST_BUCKET_BITS;
+    return bucket < PERF_STATS::BUCKETS ? bucket : PERF_STATS::BUCKETS - 1;
+}
+
+// Consistent copy of a counter that may be mid-update on the other core
+void snapshot(const ProbeSlot& slot, PerfCounter& copy) {
+    uint32_t before;
+    do {
+        before = slot.sequence;
+        __dmb();
+        std::memcpy(&copy, const_cast<const PerfCounter*>(&slot.counter), sizeof(copy));
+        __dmb();
+    } while ((before & 1) || slot.sequence != before);
+}
+
+}  // namespace
+
+namespace PerfStats {
+
+void enable_cycle_counter() {
+#ifdef PERF_STATS_ENABLED
+    m33_hw->demcr |= M33_DEMCR_TRCENA_BITS;
+    m33_hw->dwt_cyccnt = 0;
+    m33_hw->dwt_ctrl |= M33_DWT_CTRL_CYCCNTENA_BITS;
+#endif
+}
+
+void record(PerfProbe probe, uint32_t cycles) {
+    ProbeSlot& slot = slots[static_cast<size_t>(probe)];
+    PerfCounter& counter = slot.counter;
+
+    uint32_t saved = save_and_disable_interrupts();
+    slot.sequence = slot.sequence + 1;
+    __dmb();
+    if (slot.reset_requested || counter.count == 0) {
+        clear(counter);
+        slot.reset_requested = false;
+    }
+    counter.count++;
+    counter.total += cycles;
+    if (cycles < counter.min) counter.min = cycles;
+    if (cycles > counter.max) counter.max = cycles;
+    counter.histogram[bucket_of(cycles)]++;
+    __dmb();
+    slot.sequence = slot.sequence + 1;
+    restore_interrupts(saved);
+}
+
+void report(ResponseBuffer& out) {
+    // Cycles are only comparable with the clock they were counted at
+    out.appendf("CLK=%lu", (unsigned long)clock_get_hz(clk_sys));
+
+    for (size_t i = 0; i < PROBE_COUNT; i++) {
+        ProbeSlot& slot = slots[i];
+        PerfCounter copy;
+        snapshot(slot, copy);
+        // Not yet sampled since the last report
+        if (slot.reset_requested) copy.count = 0;
+
+        if (copy.count == 0) {
+            out.appendf(";%s:N=0,MIN=0,AVG=0,MAX=0,HIST=", PROBE_NAMES[i]);
+        } else {
+            out.appendf(";%s:N=%lu,MIN=%lu,AVG=%lu,MAX=%lu,HIST=", PROBE_NAMES[i],
+                        (unsigned long)copy.count, (unsigned long)copy.min,
+                        (unsigned long)(copy.total / copy.count), (unsigned long)copy.max);
+        }
+        for (size_t b = 0; b < PERF_STATS::BUCKETS; b++) {
+            out.appendf(b ? "/%lu" : "%lu", copy.count ? (unsigned long)copy.histogram[b] : 0UL);
+        }
+        slot.reset_requested = true;
+    }
+}
+
+}  // namespace PerfStats
@@ -0,0 +1,92 @@
+#include "pio_dac_bus.hpp"
+
+#ifdef SINGLE_BOARD_MODE
+
+#include "io_expander.hpp"  // HW_PINS_SINGLE
+#include "hardware/clocks.h"
+#include "hardware/gpio.h"
+#include "dac_frame.pio.h"
+
+// DAC index -> CS pin
+static constexpr uint CS_PINS[PioDacBus::NUM_DACS] = {
+    HW_PINS_SINGLE::CS_DAC0,
+    HW_PINS_SINGLE::CS_DAC1,
+    HW_PINS_SINGLE::CS_DAC2
+};
+
+void PioDacBus::init(uint32_t baudrate) {
+    pio_ = pio0;
+    uint offset = pio_add_program(pio_, &dac_frame_program);
+
+    // Two PIO cycles per SCK period; round the divider up so SCK <= baudrate
+    uint32_t sys_hz = clock_get_hz(clk_sys);
+    uint32_t div = (sys_hz + 2 * baudrate - 1) / (2 * baudrate);
+    if (div < 1) div = 1;
+    if (div > 0xFFFF) div = 0xFFFF;
+    actual_baudrate_ = sys_hz / (2 * div);
+
+    for (uint8_t i = 0; i < NUM_DACS; i++) {
+        sm_[i] = pio_claim_unused_sm(pio_, true);
+        dac_frame_program_init(pio_, sm_[i], offset, CS_PINS[i],
+                               HW_PINS_SINGLE::SPI_CLK, HW_PINS_SINGLE::SPI_MOSI,
+                               static_cast<uint16_t>(div));
+    }
+
+    resume();
+    ready_ = true;
+}
+
+bool PioDacBus::write_frame(uint8_t device_id, const uint8_t tx[3]) {
+    if (device_id >= NUM_DACS) return false;
+
+    // Only one machine may clock at a time on the shared SCK/MOSI
+    if (last_dac_ != device_id && last_dac_ < NUM_DACS) {
+        wait_sm_idle(sm_[last_dac_]);
+    }
+    last_dac_ = device_id;
+
+    uint32_t word = (static_cast<uint32_t>(tx[0]) << 24) |
+                    (static_cast<uint32_t>(tx[1]) << 16) |
+                    (static_cast<uint32_t>(tx[2]) << 8);
+    pio_sm_put_blocking(pio_, sm_[device_id], word);
+    return true;
+}
+
+void PioDacBus::wait_sm_idle(uint sm) {
+    // Empty FIFO is not enough: the last frame may still be shifting.
+    // TXSTALL is re-asserted every cycle the machine sits on its PULL.
+    while (!pio_sm_is_tx_fifo_empty(pio_, sm)) {
+        tight_loop_contents();
+    }
+    uint32_t stall = 1u << (PIO_FDEBUG_TXSTALL_LSB + sm);
+    pio_->fdebug = stall;
+    while (!(pio_->fdebug & stall)) {
+        tight_loop_contents();
+    }
+}
+
+void PioDacBus::wait_idle() {
+    if (last_dac_ < NUM_DACS) {
+        wait_sm_idle(sm_[last_dac_]);
+    }
+}
+
+void PioDacBus::suspend() {
+    wait_idle();
+    for (uint cs : CS_PINS) {
+        gpio_put(cs, 1);
+        gpio_set_function(cs, GPIO_FUNC_SIO);  // Keeps the SIO direction (output)
+    }
+    gpio_set_function(HW_PINS_SINGLE::SPI_CLK, GPIO_FUNC_SPI);
+    gpio_set_function(HW_PINS_SINGLE::SPI_MOSI, GPIO_FUNC_SPI);
+}
+
+void PioDacBus::resume() {
+    for (uint cs : CS_PINS) {
+        pio_gpio_init(pio_, cs);
+    }
+    pio_gpio_init(pio_, HW_PINS_SINGLE::SPI_CLK);
+    pio_gpio_init(pio_, HW_PINS_SINGLE::SPI_MOSI);
+}
+
+#endif // SINGLE_BOARD_MODE
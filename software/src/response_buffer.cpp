@@ -0,0 +1,71 @@
+#include "response_buffer.hpp"
+#include <cstdarg>
+#include <cstdio>
+#include <cstring>
+
+ResponseBuffer::ResponseBuffer(char* data, size_t capacity)
+    : data_(data), capacity_(capacity) {
+    clear();
+}
+
+void ResponseBuffer::clear() {
+    length_ = 0;
+    truncated_ = false;
+    if (capacity_ > 0) data_[0] = '\0';
+}
+
+void ResponseBuffer::set(const char* text) {
+    clear();
+    append(text);
+}
+
+void ResponseBuffer::append(const char* text) {
+    size_t n = std::strlen(text);
+    size_t room = (capacity_ > length_) ? capacity_ - length_ - 1 : 0;
+    if (n > room) {
+        n = room;
+        truncated_ = true;
+    }
+    std::memcpy(data_ + length_, text, n);
+    length_ += n;
+    data_[length_] = '\0';
+}
+
+void ResponseBuffer::appendv(const char* fmt, va_list args) {
+    size_t room = capacity_ - length_;
+    int n = std::vsnprintf(data_ + length_, room, fmt, args);
+    if (n < 0) return;
+    if (static_cast<size_t>(n) >= room) {
+        length_ = capacity_ - 1;
+        truncated_ = true;
+    } else {
+        length_ += static_cast<size_t>(n);
+    }
+}
+
+void ResponseBuffer::appendf(const char* fmt, ...) {
+    va_list args;
+    va_start(args, fmt);
+    appendv(fmt, args);
+    va_end(args);
+}
+
+ScpiError ResponseBuffer::ok() {
+    set("OK");
+    return ScpiError::NONE;
+}
+
+ScpiError ResponseBuffer::fail(ScpiError error) {
+    set("ERROR:");
+    append(scpi_error_message(error));
+    return error;
+}
+
+ScpiError ResponseBuffer::fail(ScpiError error, const char* detail_fmt, ...) {
+    fail(error);
+    va_list args;
+    va_start(args, detail_fmt);
+    appendv(detail_fmt, args);
+    va_end(args);
+    return error;
+}
@@ -0,0 +1,89 @@
+#include "scpi_error.hpp"
+
+const char* scpi_error_message(ScpiError error) {
+    switch (error) {
+        case ScpiError::NONE:                     return "No error";
+
+        // Parser
+        case ScpiError::EMPTY_COMMAND:            return "Empty command";
+        case ScpiError::UNKNOWN_COMMAND:          return "Unknown command";
+        case ScpiError::EXPECTED_DAC_OR_SN:       return "Expected :DAC or :SN after BOARD";
+        case ScpiError::EXPECTED_DAC:             return "Expected DAC<n>";
+        case ScpiError::EXPECTED_DAC_COMMAND:     return "Expected command after DAC";
+        case ScpiError::EXPECTED_CH_COMMAND:      return "Expected command after CH";
+        case ScpiError::INVALID_BOARD_NUMBER:     return "Invalid board number (0-7)";
+        case ScpiError::INVALID_DAC_NUMBER:       return "Invalid DAC number (0-2)";
+        case ScpiError::INVALID_CHANNEL_NUMBER:   return "Invalid channel number (0-4)";
+        case ScpiError::INVALID_VOLTAGE_VALUE:    return "Invalid voltage value";
+        case ScpiError::INVALID_CURRENT_VALUE:    return "Invalid current value";
+        case ScpiError::INVALID_CODE_VALUE:       return "Invalid code value";
+        case ScpiError::INVALID_SPAN_VALUE:       return "Invalid span value";
+        case ScpiError::INVALID_VALUE:            return "Invalid value";
+        case ScpiError::INVALID_GAIN_VALUE:       return "Invalid gain value";
+        case ScpiError::INVALID_OFFSET_VALUE:     return "Invalid offset value";
+        case ScpiError::INVALID_ENABLE_VALUE:     return "Invalid enable value (0 or 1)";
+        case ScpiError::INVALID_CAL_TABLE:        return "Table needs 2-16 <in>,<out> pairs with increasing inputs, or NONE";
+        case ScpiError::INVALID_CAL_IMAGE_CHUNK:  return "Expected <offset>,<base64> within the image, in order";
+        case ScpiError::INVALID_SNAP_NAME:        return "Snapshot name must be 1-15 letters, digits or _";
+        case ScpiError::INVALID_RESOLUTION_VALUE: return "Invalid resolution value (12 or 16)";
+        case ScpiError::RESOLUTION_12_OR_16:      return "Resolution must be 12 or 16";
+        case ScpiError::INVALID_SAMPLE_RATE:      return "Invalid sample rate";
+        case ScpiError::INVALID_LOOP_COUNT:       return "Invalid loop count";
+        case ScpiError::INVALID_TRIGGER_SOURCE:   return "Trigger source must be IMM, BUS or EXT";
+        case ScpiError::INVALID_ELISION_SETTING:  return "Invalid elision setting";
+        case ScpiError::INVALID_QUIET_SETTING:    return "Quiet must be 0 or 1";
+        case ScpiError::INVALID_NOTIFY_SETTING:   return "Notify must be 0 or 1";
+        case ScpiError::INVALID_ARM_SETTING:      return "Arm must be 0 or 1";
+        case ScpiError::SERIAL_REQUIRED:          return "Serial number required";
+        case ScpiError::ARGUMENT_TOO_LONG:        return "Argument too long";
+        case ScpiError::LINE_TOO_LONG:            return "Line too long; nothing was executed";
+        case ScpiError::INVALID_CHANNEL_LIST:     return "Invalid channel list";
+        case ScpiError::APPLY_REQUIRES_ENTRIES:   return "APPLY requires <board>,<dac>,<ch>,<value> entries";
+        case ScpiError::SEQ_DATA_REQUIRES_CODES:  return "SEQ:DATA requires a code list";
+        case ScpiError::BCAST_EXPECTED_TARGET:    return "Expected DAC<m>, CURR, VOLT or ALL after BCAST";
+        case ScpiError::BCAST_EXPECTED_OPERATION: return "Expected :CODE or :SPAN";
+        case ScpiError::BCAST_MIXED_SPAN:         return "Broadcast SPAN mixes DAC types; use CURR and VOLT";
+        case ScpiError::UNKNOWN_DAC_COMMAND:      return "Unknown DAC command";
+        case ScpiError::UNKNOWN_CHANNEL_COMMAND:  return "Unknown channel command";
+        case ScpiError::UNKNOWN_CAL_COMMAND:      return "Unknown calibration command (use GAIN, OFFS, EN or TABL)";
+        case ScpiError::UNKNOWN_SEQ_COMMAND:      return "Unknown sequencer command";
+
+        // Execution
+        case ScpiError::MISSING_ADDRESS:          return "Missing address";
+        case ScpiError::MISSING_CHANNEL:          return "Missing channel";
+        case ScpiError::INVALID_BOARD:            return "Invalid board";
+        case ScpiError::INVALID_BOARD_DAC:        return "Invalid board/DAC";
+        case ScpiError::INVALID_CHANNEL:          return "Invalid channel";
+        case ScpiError::DAC_NOT_INITIALIZED:      return "DAC not initialized";
+        case ScpiError::USE_CURR:                 return "Use CURR for current DACs";
+        case ScpiError::USE_VOLT:                 return "Use VOLT for voltage DACs";
+        case ScpiError::FAULT_CURRENT_ONLY:       return "FAULT? only for current DACs (DAC 0,1)";
+        case ScpiError::RANGE_NOT_SUPPORTED:      return "Ranges only apply to VOLT, CURR and CODE";
+        case ScpiError::CODE_EXCEEDS_MAX:         return "Code exceeds max";
+        case ScpiError::INVALID_SPAN_CODE:        return "Invalid span code";
+        case ScpiError::ELISION_0_OR_1:           return "Elision must be 0 or 1";
+        case ScpiError::FLASH_WRITE_FAILED:       return "Flash write failed";
+        case ScpiError::NO_CAL_DATA:              return "No valid calibration data";
+        case ScpiError::CAL_TABLES_FULL:          return "Calibration table memory full";
+        case ScpiError::CAL_IMAGE_REJECTED:       return "Calibration image rejected (bad magic, version or CRC)";
+        case ScpiError::REPLY_TOO_LONG:           return "Reply too long for the response buffer";
+        case ScpiError::SNAP_NOT_FOUND:           return "Snapshot not found";
+        case ScpiError::SNAP_FULL:                return "Snapshot slots full";
+        case ScpiError::SNAP_MISMATCH:            return "Snapshot does not match DAC resolution";
+        case ScpiError::TOO_MANY_ENTRIES:         return "Too many entries";
+        case ScpiError::ENTRY_INVALID_ADDRESS:    return "Invalid address in entry";
+        case ScpiError::ENTRY_INVALID_BOARD_DAC:  return "Invalid board/DAC in entry";
+        case ScpiError::ENTRY_INVALID_CHANNEL:    return "Invalid channel in entry";
+        case ScpiError::ENTRY_INVALID_CODE:       return "Invalid code in entry";
+        case ScpiError::ENTRY_INVALID_VALUE:      return "Invalid value in entry";
+        case ScpiError::SEQ_ACTIVE:               return "Sequencer active";
+        case ScpiError::SEQ_INVALID_CODE:         return "Invalid code at index";
+        case ScpiError::SEQ_MEMORY_FULL:          return "Sequencer memory full";
+        case ScpiError::SEQ_TOO_MANY_TRACKS:      return "Too many tracks, or upload channels one at a time";
+        case ScpiError::SEQ_RATE_RANGE:           return "Rate must be";
+        case ScpiError::SEQ_NOT_LOADED:           return "No sequence loaded or already active";
+        case ScpiError::SEQ_NOT_ARMED:            return "Sequencer not armed";
+        case ScpiError::TRIGGER_ARMED:            return "Trigger armed; playback would commit the staged writes";
+    }
+    return "Unknown error";
+}
@@ -1,482 +1,695 @@
 #include "scpi_parser.hpp"
-#include "utils.hpp"
+#include "perf_stats.hpp"
+#include <array>
 #include <cstring>
 #include <cctype>
 #include <cstdlib>
 
-// Case-insensitive string comparison (portable replacement for strncasecmp)
-static int strncasecmp_local(const char* s1, const char* s2, size_t n) {
-    for (size_t i = 0; i < n; i++) {
-        int c1 = std::toupper(static_cast<unsigned char>(s1[i]));
-        int c2 = std::toupper(static_cast<unsigned char>(s2[i]));
-        if (c1 != c2) return c1 - c2;
-        if (c1 == '\0') return 0;
-    }
-    return 0;
+// ============================================================================
+// Keyword tables
+// ============================================================================
+//
+// A header such as "BOARD0:DAC2:CH1:VOLT?" is split into mnemonic nodes
+// (BOARD, DAC, CH, VOLT), each with an optional numeric suffix, plus the
+// query flag. The node sequence is packed into a 32-bit key and looked up
+// in a table sorted at compile time, so the cost of matching a command
+// does not grow with the size of the command set. Adding a command is one
+// ROUTES row (and a Node/MNEMONICS entry if it uses a new keyword).
+
+namespace {
+
+constexpr size_t MAX_NODES = 5;    // Deepest header: BOARD:DAC:CH:CAL:GAIN
+constexpr unsigned NODE_BITS = 6;  // Bits per node in a route key
+
+// SCPI mnemonic nodes
+enum class Node : uint8_t {
+    NONE = 0,  // Empty slot / unrecognized mnemonic: never part of a route
+    IDN, RST,
+    BOARD, DAC, CH,
+    VOLT, CURR, CODE, SPAN, ALL, UPDATE, PDOWN, RES,
+    CAL, GAIN, OFFS, EN, TABLE, DATA, IMAGE, CLEAR, SAVE, LOAD,
+    SNAP, REST, DEL, LIST,
+    SN, FAULT, ECHO, NOTIFY,
+    SYST, ERR, BOOT, FITTED, CONF, BIN, ELIDE, COUNT, QUIET,
+    LDAC, BCAST, APPLY,
+    SEQ, START, STOP, STAT, RATE, LOOP, TRIG, SOUR, ARM,
+    COUNT_
+};
+static_assert(static_cast<size_t>(Node::COUNT_) <= (1u << NODE_BITS), "Node ids must fit NODE_BITS");
+static_assert(MAX_NODES * NODE_BITS < 32, "Route key needs a spare bit for the query flag");
+
+constexpr char fold(char c) {
+    return (c >= 'a' && c <= 'z') ? static_cast<char>(c - 'a' + 'A') : c;
 }
 
-const char* ScpiParser::skip_whitespace(const char* str) {
-    while (*str && std::isspace(*str)) str++;
-    return str;
+constexpr size_t short_length(const char* name) {
+    size_t n = 0;
+    while (name[n] && !(name[n] >= 'a' && name[n] <= 'z')) n++;
+    return n;
 }
 
-bool ScpiParser::parse_float(const char* str, float& value) {
-    str = skip_whitespace(str);
-    char* end;
-    value = std::strtof(str, &end);
-    return end != str;
+constexpr size_t long_length(const char* name) {
+    size_t n = 0;
+    while (name[n]) n++;
+    return n;
 }
 
-bool ScpiParser::parse_int(const char* str, uint16_t& value) {
-    str = skip_whitespace(str);
-    char* end;
-    long v = std::strtol(str, &end, 0);  // Auto-detect hex (0x) or decimal
-    if (end == str) return false;
-    if (v < 0 || v > 65535) return false;
-    value = static_cast<uint16_t>(v);
-    return true;
+// One keyword. As in the SCPI standard, the upper-case part of the name is
+// the short form and the whole name the long form ("VOLTage": VOLT or
+// VOLTAGE); either is accepted in any case. Indexed keywords (BOARD<n>)
+// require a numeric suffix up to max_index.
+struct Mnemonic {
+    const char* name;
+    Node node;
+    int8_t max_index;
+    ScpiError index_error;
+    size_t short_len;
+    size_t long_len;
+};
+
+constexpr Mnemonic keyword(const char* name, Node node, int8_t max_index = -1,
+                           ScpiError index_error = ScpiError::NONE) {
+    return {name, node, max_index, index_error, short_length(name), long_length(name)};
 }
 
-int ScpiParser::extract_index(const char* str, const char* prefix) {
-    size_t prefix_len = std::strlen(prefix);
-
-    // Case-insensitive prefix match
-    for (size_t i = 0; i < prefix_len; i++) {
-        if (std::toupper(str[i]) != std::toupper(prefix[i])) {
-            return -1;
-        }
+constexpr Mnemonic MNEMONICS[] = {
+    keyword("*IDN", Node::IDN),
+    keyword("*RST", Node::RST),
+    // TODO: hard-coded 8 boards; should be a global parameter
+    keyword("BOARD", Node::BOARD, 7, ScpiError::INVALID_BOARD_NUMBER),
+    keyword("DAC", Node::DAC, 2, ScpiError::INVALID_DAC_NUMBER),
+    keyword("CHannel", Node::CH, 4, ScpiError::INVALID_CHANNEL_NUMBER),
+    keyword("VOLTage", Node::VOLT),
+    keyword("CURRent", Node::CURR),
+    keyword("CODE", Node::CODE),
+    keyword("SPAN", Node::SPAN),
+    keyword("ALL", Node::ALL),
+    keyword("UPDATE", Node::UPDATE),
+    keyword("PDOWN", Node::PDOWN),
+    keyword("RESolution", Node::RES),
+    keyword("CALibration", Node::CAL),
+    keyword("GAIN", Node::GAIN),
+    keyword("OFFSet", Node::OFFS),
+    keyword("ENable", Node::EN),
+    keyword("TABLe", Node::TABLE),
+    keyword("DATA", Node::DATA),
+    keyword("IMAGe", Node::IMAGE),
+    keyword("CLEAR", Node::CLEAR),
+    keyword("SAVE", Node::SAVE),
+    keyword("LOAD", Node::LOAD),
+    keyword("SNAPshot", Node::SNAP),
+    keyword("RESTore", Node::REST),
+    keyword("DELete", Node::DEL),
+    keyword("LIST", Node::LIST),
+    keyword("SN", Node::SN),
+    keyword("FAULT", Node::FAULT),
+    keyword("ECHO", Node::ECHO),
+    keyword("NOTify", Node::NOTIFY),
+    keyword("SYSTem", Node::SYST),
+    keyword("ERRor", Node::ERR),
+    keyword("BOOT", Node::BOOT),
+    keyword("FITTed", Node::FITTED),
+    keyword("CONFig", Node::CONF),
+    keyword("BINary", Node::BIN),
+    keyword("ELIDE", Node::ELIDE),
+    keyword("COUNt", Node::COUNT),
+    keyword("QUIET", Node::QUIET),
+    keyword("LDAC", Node::LDAC),
+    keyword("BCAST", Node::BCAST),
+    keyword("APPLy", Node::APPLY),
+    keyword("SEQuence", Node::SEQ),
+    keyword("START", Node::START),
+    keyword("STOP", Node::STOP),
+    keyword("STATus", Node::STAT),
+    keyword("RATE", Node::RATE),
+    keyword("LOOP", Node::LOOP),
+    keyword("TRIGger", Node::TRIG),
+    keyword("SOURce", Node::SOUR),
+    keyword("ARM", Node::ARM),
+};
+
+// How the text after the header is read
+enum class Arg : uint8_t {
+    NONE,         // Nothing (queries and bare commands)
+    FLOAT,        // float_value
+    INT,          // int_value (decimal or 0x hex)
+    BOOL,         // int_value, 0 or 1
+    RESOLUTION,   // int_value, 12 or 16
+    TRIG_SOURCE,  // IMM -> 0, BUS -> 1, EXT -> 2 in int_value
+    LIST,         // Rest of the line into string_value (APPLY, SEQ:DATA)
+    TEXT,         // Rest of the line, trailing whitespace trimmed (SN, SNAP names)
+};
+
+}  // namespace
+
+// One command: node sequence + query flag -> command type and argument
+struct ScpiRoute {
+    Node nodes[MAX_NODES];
+    bool query;
+    ScpiCommandType type;
+    Arg arg;
+    ScpiError arg_error;  // Reported when the argument is missing or malformed
+};
+
+namespace {
+
+using T = ScpiCommandType;
+using E = ScpiError;
+
+constexpr ScpiRoute ROUTES[] = {
+    // IEEE 488.2 common commands
+    {{Node::IDN},                              true,  T::IDN_QUERY,       Arg::NONE, E::NONE},
+    {{Node::RST},                              false, T::RST,             Arg::NONE, E::NONE},
+
+    // System commands
+    {{Node::FAULT},                            true,  T::FAULT_QUERY,     Arg::NONE, E::NONE},
+    {{Node::FAULT, Node::STAT},                true,  T::FAULT_STATUS_QUERY, Arg::NONE, E::NONE},
+    {{Node::FAULT, Node::NOTIFY},              false, T::FAULT_SET_NOTIFY, Arg::BOOL, E::INVALID_NOTIFY_SETTING},
+    {{Node::FAULT, Node::NOTIFY},              true,  T::FAULT_GET_NOTIFY, Arg::NONE, E::NONE},
+    {{Node::LDAC},                             false, T::PULSE_LDAC,      Arg::NONE, E::NONE},
+    {{Node::UPDATE, Node::ALL},                false, T::UPDATE_ALL,      Arg::NONE, E::NONE},
+    {{Node::SYST, Node::ERR},                  true,  T::SYST_ERR_QUERY,  Arg::NONE, E::NONE},
+    {{Node::SYST, Node::BOOT},                 true,  T::SYST_BOOT_QUERY, Arg::NONE, E::NONE},
+    {{Node::SYST, Node::FITTED},               true,  T::SYST_FITTED_QUERY, Arg::NONE, E::NONE},
+    {{Node::SYST, Node::STAT},                 true,  T::SYST_STAT_QUERY, Arg::NONE, E::NONE},
+    {{Node::SYST, Node::CONF},                 true,  T::SYST_CONFIG_QUERY, Arg::NONE, E::NONE},
+    {{Node::SYST, Node::BIN},                  false, T::SYST_BINARY,     Arg::NONE, E::NONE},
+    {{Node::SYST, Node::ELIDE},                false, T::SYST_SET_ELIDE,  Arg::INT,  E::INVALID_ELISION_SETTING},
+    {{Node::SYST, Node::ELIDE},                true,  T::SYST_GET_ELIDE,  Arg::NONE, E::NONE},
+    {{Node::SYST, Node::ELIDE, Node::COUNT},   true,  T::SYST_ELIDE_COUNT_QUERY, Arg::NONE, E::NONE},
+    {{Node::SYST, Node::QUIET},                false, T::SYST_SET_QUIET,  Arg::BOOL, E::INVALID_QUIET_SETTING},
+
+    // Calibration storage
+    {{Node::CAL, Node::DATA},                  true,  T::CAL_DATA_QUERY,  Arg::NONE, E::NONE},
+    {{Node::CAL, Node::IMAGE},                 true,  T::CAL_IMAGE_QUERY, Arg::INT,  E::INVALID_CAL_IMAGE_CHUNK},
+    {{Node::CAL, Node::IMAGE},                 false, T::CAL_IMAGE,       Arg::LIST, E::INVALID_CAL_IMAGE_CHUNK},
+    {{Node::CAL, Node::CLEAR},                 false, T::CAL_CLEAR,       Arg::NONE, E::NONE},
+    {{Node::CAL, Node::SAVE},                  false, T::CAL_SAVE,        Arg::NONE, E::NONE},
+    {{Node::CAL, Node::LOAD},                  false, T::CAL_LOAD,        Arg::NONE, E::NONE},
+
+    // Output snapshots
+    {{Node::SNAP, Node::SAVE},                 false, T::SNAP_SAVE,       Arg::TEXT, E::INVALID_SNAP_NAME},
+    {{Node::SNAP, Node::REST},                 false, T::SNAP_RESTORE,    Arg::TEXT, E::INVALID_SNAP_NAME},
+    {{Node::SNAP, Node::DEL},                  false, T::SNAP_DELETE,     Arg::TEXT, E::INVALID_SNAP_NAME},
+    {{Node::SNAP, Node::LIST},                 true,  T::SNAP_LIST_QUERY, Arg::NONE, E::NONE},
+    {{Node::SNAP, Node::BOOT},                 false, T::SNAP_SET_BOOT,   Arg::TEXT, E::INVALID_SNAP_NAME},
+    {{Node::SNAP, Node::BOOT},                 true,  T::SNAP_GET_BOOT,   Arg::NONE, E::NONE},
+
+    // Broadcast: DAC<m> (that DAC on every board), CURR (DAC0+DAC1), VOLT (DAC2),
+    // ALL (every chip; CODE only, the span codes differ between the DAC types)
+    {{Node::BCAST, Node::DAC, Node::CODE},     false, T::BCAST_CODE,      Arg::INT,  E::INVALID_VALUE},
+    {{Node::BCAST, Node::CURR, Node::CODE},    false, T::BCAST_CODE,      Arg::INT,  E::INVALID_VALUE},
+    {{Node::BCAST, Node::VOLT, Node::CODE},    false, T::BCAST_CODE,      Arg::INT,  E::INVALID_VALUE},
+    {{Node::BCAST, Node::ALL, Node::CODE},     false, T::BCAST_CODE,      Arg::INT,  E::INVALID_VALUE},
+    {{Node::BCAST, Node::DAC, Node::SPAN},     false, T::BCAST_SPAN,      Arg::INT,  E::INVALID_VALUE},
+    {{Node::BCAST, Node::CURR, Node::SPAN},    false, T::BCAST_SPAN,      Arg::INT,  E::INVALID_VALUE},
+    {{Node::BCAST, Node::VOLT, Node::SPAN},    false, T::BCAST_SPAN,      Arg::INT,  E::INVALID_VALUE},
+
+    // Batched writes; the entry list is validated and expanded by BoardManager
+    {{Node::APPLY},                            false, T::APPLY,           Arg::LIST, E::APPLY_REQUIRES_ENTRIES},
+    {{Node::APPLY, Node::CODE},                false, T::APPLY_CODE,      Arg::LIST, E::APPLY_REQUIRES_ENTRIES},
+
+    // Sequencer
+    {{Node::SEQ, Node::CLEAR},                 false, T::SEQ_CLEAR,       Arg::NONE, E::NONE},
+    {{Node::SEQ, Node::START},                 false, T::SEQ_START,       Arg::NONE, E::NONE},
+    {{Node::SEQ, Node::STOP},                  false, T::SEQ_STOP,        Arg::NONE, E::NONE},
+    {{Node::SEQ, Node::STAT},                  true,  T::SEQ_STATUS_QUERY, Arg::NONE, E::NONE},
+    {{Node::SEQ, Node::RATE},                  false, T::SEQ_SET_RATE,    Arg::INT,  E::INVALID_SAMPLE_RATE},
+    {{Node::SEQ, Node::RATE},                  true,  T::SEQ_GET_RATE,    Arg::NONE, E::NONE},
+    {{Node::SEQ, Node::LOOP},                  false, T::SEQ_SET_LOOP,    Arg::INT,  E::INVALID_LOOP_COUNT},
+    {{Node::SEQ, Node::LOOP},                  true,  T::SEQ_GET_LOOP,    Arg::NONE, E::NONE},
+    {{Node::SEQ, Node::TRIG},                  false, T::SEQ_TRIGGER,     Arg::NONE, E::NONE},
+    {{Node::SEQ, Node::TRIG, Node::SOUR},      false, T::SEQ_SET_TRIG_SOURCE, Arg::TRIG_SOURCE, E::INVALID_TRIGGER_SOURCE},
+    {{Node::SEQ, Node::TRIG, Node::SOUR},      true,  T::SEQ_GET_TRIG_SOURCE, Arg::NONE, E::NONE},
+
+    // External trigger
+    {{Node::TRIG, Node::ARM},                  false, T::TRIG_SET_ARM,    Arg::BOOL, E::INVALID_ARM_SETTING},
+    {{Node::TRIG, Node::ARM},                  true,  T::TRIG_GET_ARM,    Arg::NONE, E::NONE},
+    {{Node::TRIG, Node::COUNT},                true,  T::TRIG_COUNT_QUERY, Arg::NONE, E::NONE},
+
+    // Board commands
+    {{Node::BOARD, Node::SN},                  false, T::SET_SERIAL,      Arg::TEXT, E::SERIAL_REQUIRED},
+    {{Node::BOARD, Node::SN},                  true,  T::GET_SERIAL,      Arg::NONE, E::NONE},
+
+    // DAC commands
+    {{Node::BOARD, Node::DAC, Node::FAULT},    true,  T::DAC_FAULT_QUERY, Arg::NONE, E::NONE},
+    {{Node::BOARD, Node::DAC, Node::ECHO},     true,  T::DAC_ECHO_QUERY,  Arg::NONE, E::NONE},
+    {{Node::BOARD, Node::DAC, Node::SPAN},     false, T::SET_SPAN,        Arg::INT,  E::INVALID_SPAN_VALUE},
+    {{Node::BOARD, Node::DAC, Node::SPAN, Node::ALL}, false, T::SET_ALL_SPAN, Arg::INT, E::INVALID_SPAN_VALUE},
+    {{Node::BOARD, Node::DAC, Node::CODE, Node::ALL}, false, T::SET_ALL_CODE, Arg::INT, E::INVALID_CODE_VALUE},
+    {{Node::BOARD, Node::DAC, Node::UPDATE},   false, T::UPDATE,          Arg::NONE, E::NONE},
+    {{Node::BOARD, Node::DAC, Node::PDOWN},    false, T::POWER_DOWN_CHIP, Arg::NONE, E::NONE},
+    {{Node::BOARD, Node::DAC, Node::RES},      false, T::SET_RESOLUTION,  Arg::RESOLUTION, E::INVALID_RESOLUTION_VALUE},
+    {{Node::BOARD, Node::DAC, Node::RES},      true,  T::GET_RESOLUTION,  Arg::NONE, E::NONE},
+
+    // Channel commands
+    {{Node::BOARD, Node::DAC, Node::CH, Node::VOLT}, false, T::SET_VOLTAGE, Arg::FLOAT, E::INVALID_VOLTAGE_VALUE},
+    {{Node::BOARD, Node::DAC, Node::CH, Node::VOLT}, true,  T::GET_VOLTAGE, Arg::NONE,  E::NONE},
+    {{Node::BOARD, Node::DAC, Node::CH, Node::CURR}, false, T::SET_CURRENT, Arg::FLOAT, E::INVALID_CURRENT_VALUE},
+    {{Node::BOARD, Node::DAC, Node::CH, Node::CURR}, true,  T::GET_CURRENT, Arg::NONE,  E::NONE},
+    {{Node::BOARD, Node::DAC, Node::CH, Node::CODE}, false, T::SET_CODE,    Arg::INT,   E::INVALID_CODE_VALUE},
+    {{Node::BOARD, Node::DAC, Node::CH, Node::CODE}, true,  T::GET_CODE,    Arg::NONE,  E::NONE},
+    {{Node::BOARD, Node::DAC, Node::CH, Node::SPAN}, false, T::SET_SPAN,    Arg::INT,   E::INVALID_SPAN_VALUE},
+    {{Node::BOARD, Node::DAC, Node::CH, Node::PDOWN}, false, T::POWER_DOWN, Arg::NONE,  E::NONE},
+    {{Node::BOARD, Node::DAC, Node::CH, Node::SEQ, Node::DATA}, false, T::SEQ_DATA, Arg::LIST, E::SEQ_DATA_REQUIRES_CODES},
+    {{Node::BOARD, Node::DAC, Node::CH, Node::CAL, Node::GAIN}, false, T::SET_CAL_GAIN,   Arg::FLOAT, E::INVALID_GAIN_VALUE},
+    {{Node::BOARD, Node::DAC, Node::CH, Node::CAL, Node::GAIN}, true,  T::GET_CAL_GAIN,   Arg::NONE,  E::NONE},
+    {{Node::BOARD, Node::DAC, Node::CH, Node::CAL, Node::OFFS}, false, T::SET_CAL_OFFSET, Arg::FLOAT, E::INVALID_OFFSET_VALUE},
+    {{Node::BOARD, Node::DAC, Node::CH, Node::CAL, Node::OFFS}, true,  T::GET_CAL_OFFSET, Arg::NONE,  E::NONE},
+    {{Node::BOARD, Node::DAC, Node::CH, Node::CAL, Node::EN},   false, T::SET_CAL_ENABLE, Arg::INT,   E::INVALID_ENABLE_VALUE},
+    {{Node::BOARD, Node::DAC, Node::CH, Node::CAL, Node::EN},   true,  T::GET_CAL_ENABLE, Arg::NONE,  E::NONE},
+    {{Node::BOARD, Node::DAC, Node::CH, Node::CAL, Node::TABLE}, false, T::SET_CAL_TABLE, Arg::LIST,  E::INVALID_CAL_TABLE},
+    {{Node::BOARD, Node::DAC, Node::CH, Node::CAL, Node::TABLE}, true,  T::GET_CAL_TABLE, Arg::NONE,  E::NONE},
+};
+
+// Error for a header that matches no route, chosen by the longest known
+// prefix: at_end if the header stops right after it, otherwise if it
+// continues with something unrecognized
+struct Miss {
+    Node prefix[MAX_NODES];
+    ScpiError at_end;
+    ScpiError otherwise;
+};
+
+constexpr Miss MISSES[] = {
+    {{Node::BOARD},                          E::EXPECTED_DAC_OR_SN,       E::EXPECTED_DAC},
+    {{Node::BOARD, Node::DAC},               E::EXPECTED_DAC_COMMAND,     E::UNKNOWN_DAC_COMMAND},
+    {{Node::BOARD, Node::DAC, Node::CH},     E::EXPECTED_CH_COMMAND,      E::UNKNOWN_CHANNEL_COMMAND},
+    {{Node::BOARD, Node::DAC, Node::CH, Node::CAL}, E::UNKNOWN_CAL_COMMAND, E::UNKNOWN_CAL_COMMAND},
+    {{Node::SEQ},                            E::UNKNOWN_SEQ_COMMAND,      E::UNKNOWN_SEQ_COMMAND},
+    {{Node::BCAST},                          E::BCAST_EXPECTED_TARGET,    E::BCAST_EXPECTED_TARGET},
+    {{Node::BCAST, Node::DAC},               E::BCAST_EXPECTED_OPERATION, E::BCAST_EXPECTED_OPERATION},
+    {{Node::BCAST, Node::CURR},              E::BCAST_EXPECTED_OPERATION, E::BCAST_EXPECTED_OPERATION},
+    {{Node::BCAST, Node::VOLT},              E::BCAST_EXPECTED_OPERATION, E::BCAST_EXPECTED_OPERATION},
+    {{Node::BCAST, Node::ALL},               E::BCAST_EXPECTED_OPERATION, E::BCAST_EXPECTED_OPERATION},
+    {{Node::BCAST, Node::ALL, Node::SPAN},   E::BCAST_MIXED_SPAN,         E::BCAST_MIXED_SPAN},
+};
+
+constexpr uint32_t route_key(const Node (&nodes)[MAX_NODES], bool query) {
+    uint32_t key = query ? (1u << (MAX_NODES * NODE_BITS)) : 0;
+    for (size_t i = 0; i < MAX_NODES; i++) {
+        key |= static_cast<uint32_t>(nodes[i]) << (i * NODE_BITS);
     }
+    return key;
+}
 
-    // Extract digit after prefix
-    if (!std::isdigit(str[prefix_len])) {
-        return -1;
+constexpr size_t NUM_ROUTES = sizeof(ROUTES) / sizeof(ROUTES[0]);
+static_assert(NUM_ROUTES <= 255, "Route index is a uint8_t");
+
+struct RouteIndex {
+    uint32_t key;
+    uint8_t route;
+};
+
+// ROUTES sorted by key (insertion sort, evaluated by the compiler)
+constexpr std::array<RouteIndex, NUM_ROUTES> build_route_index() {
+    std::array<RouteIndex, NUM_ROUTES> index{};
+    for (size_t i = 0; i < NUM_ROUTES; i++) {
+        RouteIndex entry{route_key(ROUTES[i].nodes, ROUTES[i].query), static_cast<uint8_t>(i)};
+        size_t j = i;
+        while (j > 0 && index[j - 1].key > entry.key) {
+            index[j] = index[j - 1];
+            j--;
+        }
+        index[j] = entry;
     }
-
-    return str[prefix_len] - '0';
+    return index;
 }
 
-bool ScpiParser::parse_common_command(const char* cmd, ScpiCommand& result) {
-    // IEEE 488.2 common commands start with *
-    if (cmd[0] != '*') return false;
+constexpr std::array<RouteIndex, NUM_ROUTES> ROUTE_INDEX = build_route_index();
 
-    cmd++;  // Skip *
-
-    if (strncasecmp_local(cmd, "IDN?", 4) == 0) {
-        result.type = ScpiCommandType::IDN_QUERY;
-        result.is_query = true;
-        result.valid = true;
-        return true;
+constexpr bool route_keys_unique() {
+    for (size_t i = 1; i < NUM_ROUTES; i++) {
+        if (ROUTE_INDEX[i - 1].key == ROUTE_INDEX[i].key) return false;
     }
-
-    if (strncasecmp_local(cmd, "RST", 3) == 0) {
-        result.type = ScpiCommandType::RST;
-        result.valid = true;
-        return true;
+    return true;
+}
+static_assert(route_keys_unique(), "Two ROUTES rows share a header");
+
+// Header split into nodes
+struct Header {
+    Node nodes[MAX_NODES] = {};
+    uint32_t mask[MAX_NODES] = {};  // Indices addressed by indexed nodes (bit n = <n>)
+    size_t count = 0;
+    bool query = false;
+    bool malformed = false;         // Unrecognized node or trailing junk
+};
+
+const Mnemonic* find_mnemonic(const char* text, size_t length) {
+    for (const Mnemonic& m : MNEMONICS) {
+        if (length != m.short_len && length != m.long_len) continue;
+        size_t i = 0;
+        while (i < length && fold(text[i]) == fold(m.name[i])) i++;
+        if (i == length) return &m;
     }
-
-    return false;
+    return nullptr;
 }
 
-bool ScpiParser::parse_system_command(const char* cmd, ScpiCommand& result) {
-    // FAULT?
-    if (strncasecmp_local(cmd, "FAULT?", 6) == 0) {
-        result.type = ScpiCommandType::FAULT_QUERY;
-        result.is_query = true;
-        result.valid = true;
-        return true;
+const ScpiRoute* find_route(const Header& header) {
+    uint32_t key = route_key(header.nodes, header.query);
+    size_t lo = 0;
+    size_t hi = NUM_ROUTES;
+    while (lo < hi) {
+        size_t mid = (lo + hi) / 2;
+        if (ROUTE_INDEX[mid].key < key) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
     }
-
-    // LDAC
-    if (strncasecmp_local(cmd, "LDAC", 4) == 0) {
-        result.type = ScpiCommandType::PULSE_LDAC;
-        result.valid = true;
-        return true;
+    if (lo < NUM_ROUTES && ROUTE_INDEX[lo].key == key) {
+        return &ROUTES[ROUTE_INDEX[lo].route];
     }
+    return nullptr;
+}
 
-    // UPDATE:ALL
-    if (strncasecmp_local(cmd, "UPDATE:ALL", 10) == 0) {
-        result.type = ScpiCommandType::UPDATE_ALL;
-        result.valid = true;
-        return true;
+int read_number(const char*& p) {
+    int value = 0;
+    while (std::isdigit(static_cast<unsigned char>(*p))) {
+        if (value < 1000) value = value * 10 + (*p - '0');
+        p++;
     }
+    return value;
+}
 
-    // SYST:ERR?
-    if (strncasecmp_local(cmd, "SYST:ERR?", 9) == 0) {
-        result.type = ScpiCommandType::SYST_ERR_QUERY;
-        result.is_query = true;
-        result.valid = true;
-        return true;
+// Read <n> or <n>:<m> into mask. A digit right after ':' cannot start a
+// keyword, so CH0:4 is a range and CH0:CURR a new node.
+bool read_index_range(const char*& p, uint32_t& mask) {
+    if (!std::isdigit(static_cast<unsigned char>(*p))) return false;
+    int first = read_number(p);
+    int last = first;
+    if (p[0] == ':' && std::isdigit(static_cast<unsigned char>(p[1]))) {
+        p++;
+        last = read_number(p);
     }
-
-    // CAL:DATA?
-    if (strncasecmp_local(cmd, "CAL:DATA?", 9) == 0) {
-        result.type = ScpiCommandType::CAL_DATA_QUERY;
-        result.is_query = true;
-        result.valid = true;
-        return true;
+    if (last < first) {
+        int t = first;
+        first = last;
+        last = t;
     }
-
-    // CAL:CLEAR
-    if (strncasecmp_local(cmd, "CAL:CLEAR", 9) == 0) {
-        result.type = ScpiCommandType::CAL_CLEAR;
-        result.valid = true;
-        return true;
+    if (last > 31) {
+        mask |= 1u << 31;  // Out of range for every keyword
+        last = 31;
     }
-
-    // CAL:SAVE
-    if (strncasecmp_local(cmd, "CAL:SAVE", 8) == 0) {
-        result.type = ScpiCommandType::CAL_SAVE;
-        result.valid = true;
-        return true;
+    for (int i = first; i <= last; i++) {
+        mask |= 1u << i;
     }
+    return true;
+}
 
-    // CAL:LOAD
-    if (strncasecmp_local(cmd, "CAL:LOAD", 8) == 0) {
-        result.type = ScpiCommandType::CAL_LOAD;
-        result.valid = true;
+// Numeric suffix: <n>, <n>:<m>, or a channel list (@<n>[:<m>][,<n>[:<m>]...])
+// Returns false on a malformed list; mask stays 0 when there is no suffix.
+bool read_index(const char*& p, uint32_t& mask) {
+    if (p[0] == '(' && p[1] == '@') {
+        p += 2;
+        while (true) {
+            if (!read_index_range(p, mask)) return false;
+            if (*p != ',') break;
+            p++;
+        }
+        if (*p != ')') return false;
+        p++;
         return true;
     }
-
-    return false;
+    if (std::isdigit(static_cast<unsigned char>(*p))) {
+        read_index_range(p, mask);
+    }
+    return true;
 }
 
-bool ScpiParser::parse_board_command(const char* cmd, ScpiCommand& result) {
-    // BOARD<n>:...
-    if (strncasecmp_local(cmd, "BOARD", 5) != 0) {
-        return false;
+ScpiError miss_error(const Header& header) {
+    const Miss* best = nullptr;
+    size_t best_length = 0;
+    for (const Miss& miss : MISSES) {
+        size_t length = 0;
+        while (length < MAX_NODES && miss.prefix[length] != Node::NONE) length++;
+        if (length <= best_length || length > header.count) continue;
+        bool match = true;
+        for (size_t i = 0; i < length; i++) {
+            if (header.nodes[i] != miss.prefix[i]) match = false;
+        }
+        if (match) {
+            best = &miss;
+            best_length = length;
+        }
     }
+    if (!best) return ScpiError::UNKNOWN_COMMAND;
+    return (header.count == best_length && !header.malformed) ? best->at_end : best->otherwise;
+}
 
-    // Extract board number
-    int board = extract_index(cmd, "BOARD");
-    if (board < 0 || board > 7) { // TODO: hard-coded 8 boards; should be a global parameter
-        result.error_msg = "Invalid board number (0-7)";
-        return false;
-    }
-    result.board_id = board;
+}  // namespace
 
-    // Find next colon
-    const char* p = std::strchr(cmd, ':');
-    if (!p) {
-        result.error_msg = "Expected :DAC or :SN after BOARD";
-        return false;
-    }
-    p++;  // Skip :
+// ============================================================================
+// Parser
+// ============================================================================
 
-    // Check for BOARD<n>:SN (serial number)
-    if (strncasecmp_local(p, "SN", 2) == 0) {
-        p += 2;
-        if (*p == '?') {
-            result.type = ScpiCommandType::GET_SERIAL;
-            result.is_query = true;
-            result.valid = true;
-        } else {
-            result.type = ScpiCommandType::SET_SERIAL;
-            p = skip_whitespace(p);
-            // Read the rest as serial number string (up to newline/null)
-            std::string sn;
-            while (*p && *p != '\n' && *p != '\r') {
-                sn += *p++;
-            }
-            // Trim trailing whitespace
-            while (!sn.empty() && std::isspace(sn.back())) {
-                sn.pop_back();
-            }
-            if (sn.empty()) {
-                result.error_msg = "Serial number required";
-                return false;
-            }
-            result.string_value = sn;
-            result.has_string = true;
-            result.valid = true;
-        }
-        return true;
-    }
+const char* ScpiParser::skip_whitespace(const char* str) {
+    while (*str && std::isspace(*str)) str++;
+    return str;
+}
 
-    // DAC<n>:...
-    if (strncasecmp_local(p, "DAC", 3) != 0) {
-        result.error_msg = "Expected DAC<n>";
-        return false;
-    }
+bool ScpiParser::parse_float(const char* str, float& value) {
+    str = skip_whitespace(str);
+    char* end;
+    value = std::strtof(str, &end);
+    return end != str;
+}
 
-    int dac = extract_index(p, "DAC");
-    if (dac < 0 || dac > 2) {
-        result.error_msg = "Invalid DAC number (0-2)";
-        return false;
-    }
-    result.dac_id = dac;
+bool ScpiParser::parse_int(const char* str, uint16_t& value) {
+    str = skip_whitespace(str);
+    char* end;
+    long v = std::strtol(str, &end, 0);  // Auto-detect hex (0x) or decimal
+    if (end == str) return false;
+    if (v < 0 || v > 65535) return false;
+    value = static_cast<uint16_t>(v);
+    return true;
+}
 
-    // Find next colon
-    p = std::strchr(p, ':');
-    if (!p) {
-        result.error_msg = "Expected command after DAC";
-        return false;
-    }
-    p++;  // Skip :
+void ScpiCommand::reset() {
+    type = ScpiCommandType::UNKNOWN;
+    is_query = false;
+    board_id = -1;
+    dac_id = -1;
+    channel_id = -1;
+    board_mask = 0;
+    dac_mask = 0;
+    channel_mask = 0;
+    has_range = false;
+    chained = false;
+    float_value = 0.0f;
+    int_value = 0;
+    has_float = false;
+    has_int = false;
+    valid = false;
+    error = ScpiError::NONE;
+    has_string = false;
+    string_value[0] = '\0';
+}
 
-    // FAULT? - read fault register (LTC2662 only)
-    if (strncasecmp_local(p, "FAULT?", 6) == 0) {
-        result.type = ScpiCommandType::DAC_FAULT_QUERY;
-        result.is_query = true;
-        result.valid = true;
-        return true;
+bool ScpiParser::copy_string(const char* begin, size_t length, ScpiCommand& result) {
+    if (length >= sizeof(result.string_value)) {
+        result.error = ScpiError::ARGUMENT_TOO_LONG;
+        return false;
     }
+    std::memcpy(result.string_value, begin, length);
+    result.string_value[length] = '\0';
+    result.has_string = true;
+    return true;
+}
 
-    // ECHO? - echo readback test
-    if (strncasecmp_local(p, "ECHO?", 5) == 0) {
-        result.type = ScpiCommandType::DAC_ECHO_QUERY;
-        result.is_query = true;
-        result.valid = true;
-        return true;
+// True if text starts with the (upper-case) word, in any case
+static bool starts_with_word(const char* text, const char* word) {
+    for (; *word; text++, word++) {
+        if (fold(*text) != *word) return false;
     }
+    return true;
+}
 
-    // Parse subcommand: CH<n>:VOLT, CH<n>:CURR, CH<n>:CODE, SPAN, UPDATE, PDOWN
-    if (strncasecmp_local(p, "CH", 2) == 0) {
-        // CH<n>:...
-        int ch = extract_index(p, "CH");
-        if (ch < 0 || ch > 4) {
-            result.error_msg = "Invalid channel number (0-4)";
-            return false;
-        }
-        result.channel_id = ch;
-
-        p = std::strchr(p, ':');
-        if (!p) {
-            result.error_msg = "Expected command after CH";
-            return false;
-        }
-        p++;  // Skip :
-
-        // VOLT, CURR, CODE, PDOWN
-        if (strncasecmp_local(p, "VOLT", 4) == 0) {
-            p += 4;
-            if (*p == '?') {
-                result.type = ScpiCommandType::GET_VOLTAGE;
-                result.is_query = true;
-                result.valid = true;
-            } else {
-                result.type = ScpiCommandType::SET_VOLTAGE;
-                p = skip_whitespace(p);
-                if (!parse_float(p, result.float_value)) {
-                    result.error_msg = "Invalid voltage value";
-                    return false;
-                }
-                result.has_float = true;
-                result.valid = true;
-            }
+bool ScpiParser::parse_argument(const ScpiRoute& route, const char* p, ScpiCommand& result) {
+    switch (route.arg) {
+        case Arg::NONE:
             return true;
-        }
 
-        if (strncasecmp_local(p, "CURR", 4) == 0) {
-            p += 4;
-            if (*p == '?') {
-                result.type = ScpiCommandType::GET_CURRENT;
-                result.is_query = true;
-                result.valid = true;
-            } else {
-                result.type = ScpiCommandType::SET_CURRENT;
-                p = skip_whitespace(p);
-                if (!parse_float(p, result.float_value)) {
-                    result.error_msg = "Invalid current value";
-                    return false;
-                }
-                result.has_float = true;
-                result.valid = true;
-            }
+        case Arg::FLOAT:
+            if (!parse_float(p, result.float_value)) break;
+            result.has_float = true;
             return true;
-        }
 
-        if (strncasecmp_local(p, "CODE", 4) == 0) {
-            result.type = ScpiCommandType::SET_CODE;
-            p += 4;
-            p = skip_whitespace(p);
-            if (!parse_int(p, result.int_value)) {
-                result.error_msg = "Invalid code value";
-                return false;
-            }
+        case Arg::INT:
+            if (!parse_int(p, result.int_value)) break;
             result.has_int = true;
-            result.valid = true;
             return true;
-        }
 
-        if (strncasecmp_local(p, "PDOWN", 5) == 0) {
-            result.type = ScpiCommandType::POWER_DOWN;
-            result.valid = true;
+        case Arg::BOOL:
+            if (!parse_int(p, result.int_value) || result.int_value > 1) break;
+            result.has_int = true;
             return true;
-        }
 
-        // CAL:GAIN, CAL:OFFS, CAL:EN - Calibration commands
-        if (strncasecmp_local(p, "CAL:", 4) == 0) {
-            p += 4;
-
-            // CAL:GAIN
-            if (strncasecmp_local(p, "GAIN", 4) == 0) {
-                p += 4;
-                if (*p == '?') {
-                    result.type = ScpiCommandType::GET_CAL_GAIN;
-                    result.is_query = true;
-                    result.valid = true;
-                } else {
-                    result.type = ScpiCommandType::SET_CAL_GAIN;
-                    p = skip_whitespace(p);
-                    if (!parse_float(p, result.float_value)) {
-                        result.error_msg = "Invalid gain value";
-                        return false;
-                    }
-                    result.has_float = true;
-                    result.valid = true;
-                }
-                return true;
-            }
-
-            // CAL:OFFS (offset)
-            if (strncasecmp_local(p, "OFFS", 4) == 0) {
-                p += 4;
-                if (*p == '?') {
-                    result.type = ScpiCommandType::GET_CAL_OFFSET;
-                    result.is_query = true;
-                    result.valid = true;
-                } else {
-                    result.type = ScpiCommandType::SET_CAL_OFFSET;
-                    p = skip_whitespace(p);
-                    if (!parse_float(p, result.float_value)) {
-                        result.error_msg = "Invalid offset value";
-                        return false;
-                    }
-                    result.has_float = true;
-                    result.valid = true;
-                }
-                return true;
-            }
-
-            // CAL:EN (enable)
-            if (strncasecmp_local(p, "EN", 2) == 0) {
-                p += 2;
-                if (*p == '?') {
-                    result.type = ScpiCommandType::GET_CAL_ENABLE;
-                    result.is_query = true;
-                    result.valid = true;
-                } else {
-                    result.type = ScpiCommandType::SET_CAL_ENABLE;
-                    p = skip_whitespace(p);
-                    if (!parse_int(p, result.int_value)) {
-                        result.error_msg = "Invalid enable value (0 or 1)";
-                        return false;
-                    }
-                    result.has_int = true;
-                    result.valid = true;
-                }
-                return true;
+        case Arg::RESOLUTION:
+            if (!parse_int(p, result.int_value)) break;
+            if (result.int_value != 12 && result.int_value != 16) {
+                result.error = ScpiError::RESOLUTION_12_OR_16;
+                return false;
             }
+            result.has_int = true;
+            return true;
 
-            result.error_msg = "Unknown calibration command (use GAIN, OFFS, or EN)";
-            return false;
-        }
-
-        if (strncasecmp_local(p, "SPAN", 4) == 0) {
-            result.type = ScpiCommandType::SET_SPAN;
-            p += 4;
+        case Arg::TRIG_SOURCE: {
             p = skip_whitespace(p);
-            if (!parse_int(p, result.int_value)) {
-                result.error_msg = "Invalid span value";
-                return false;
+            if (starts_with_word(p, "IMM")) {
+                result.int_value = 0;
+            } else if (starts_with_word(p, "BUS")) {
+                result.int_value = 1;
+            } else if (starts_with_word(p, "EXT")) {
+                result.int_value = 2;
+            } else {
+                break;
             }
             result.has_int = true;
-            result.valid = true;
             return true;
         }
 
-        result.error_msg = "Unknown channel command";
-        return false;
-    }
-
-    if (strncasecmp_local(p, "SPAN", 4) == 0) {
-        p += 4;
-
-        // Check for :ALL
-        if (*p == ':' && strncasecmp_local(p + 1, "ALL", 3) == 0) {
-            result.type = ScpiCommandType::SET_ALL_SPAN;
-            p += 4;
-        } else {
-            result.type = ScpiCommandType::SET_SPAN;
-        }
-
-        p = skip_whitespace(p);
-        if (!parse_int(p, result.int_value)) {
-            result.error_msg = "Invalid span value";
-            return false;
+        case Arg::LIST: {
+            p = skip_whitespace(p);
+            if (*p == '\0') break;
+            return copy_string(p, std::strlen(p), result);
         }
-        result.has_int = true;
-        result.valid = true;
-        return true;
-    }
-
-    if (strncasecmp_local(p, "UPDATE", 6) == 0) {
-        result.type = ScpiCommandType::UPDATE;
-        result.valid = true;
-        return true;
-    }
 
-    if (strncasecmp_local(p, "PDOWN", 5) == 0) {
-        result.type = ScpiCommandType::POWER_DOWN_CHIP;
-        result.valid = true;
-        return true;
-    }
-
-    if (strncasecmp_local(p, "RES", 3) == 0) {
-        p += 3;
-        if (*p == '?') {
-            result.type = ScpiCommandType::GET_RESOLUTION;
-            result.is_query = true;
-            result.valid = true;
-        } else {
-            result.type = ScpiCommandType::SET_RESOLUTION;
+        case Arg::TEXT: {
+            // Read the rest as one string (up to newline/null), trailing whitespace trimmed
             p = skip_whitespace(p);
-            if (!parse_int(p, result.int_value)) {
-                result.error_msg = "Invalid resolution value (12 or 16)";
-                return false;
+            size_t len = 0;
+            while (p[len] && p[len] != '\n' && p[len] != '\r') {
+                len++;
             }
-            if (result.int_value != 12 && result.int_value != 16) {
-                result.error_msg = "Resolution must be 12 or 16";
-                return false;
+            while (len > 0 && std::isspace(static_cast<unsigned char>(p[len - 1]))) {
+                len--;
             }
-            result.has_int = true;
-            result.valid = true;
+            if (len == 0) break;
+            return copy_string(p, len, result);
         }
-        return true;
     }
 
-    result.error_msg = "Unknown DAC command";
+    result.error = route.arg_error;
     return false;
 }
 
-ScpiCommand ScpiParser::parse(const std::string& line) {
-    return parse(line.c_str());
+char* scpi_split_compound(char* line) {
+    bool quoted = false;
+    for (char* p = line; *p; p++) {
+        if (*p == '"') {
+            quoted = !quoted;
+        } else if (*p == ';' && !quoted) {
+            *p = '\0';
+            // A trailing ';' ends the message rather than adding an empty command
+            char* next = p + 1;
+            while (*next && std::isspace(static_cast<unsigned char>(*next))) next++;
+            return *next ? next : nullptr;
+        }
+    }
+    return nullptr;
 }
 
-ScpiCommand ScpiParser::parse(const char* line) {
-    ScpiCommand result;
+void ScpiParser::parse(const char* line, ScpiCommand& result) {
+    PerfScope perf(PerfProbe::PARSE);
+    result.reset();
 
-    // Skip leading whitespace
+    // Skip leading whitespace, and the optional root ':' of an absolute header
     line = skip_whitespace(line);
+    if (*line == ':') line++;
 
     if (*line == '\0') {
-        result.error_msg = "Empty command";
-        return result;
+        result.error = ScpiError::EMPTY_COMMAND;
+        return;
     }
 
-    // Try different command types
-    if (parse_common_command(line, result)) {
-        return result;
+    // Split the header into nodes: <mnemonic>[<index>][:<mnemonic>[<index>]...][?]
+    Header header;
+    const char* p = line;
+    while (true) {
+        const char* start = p;
+        while (std::isalpha(static_cast<unsigned char>(*p)) || *p == '*') p++;
+        size_t length = static_cast<size_t>(p - start);
+
+        uint32_t mask = 0;
+        if (!read_index(p, mask)) {
+            result.error = ScpiError::INVALID_CHANNEL_LIST;
+            return;
+        }
+
+        const Mnemonic* m = length ? find_mnemonic(start, length) : nullptr;
+        Node node = Node::NONE;
+        if (m && m->max_index >= 0) {
+            if (mask == 0 || (mask >> (m->max_index + 1)) != 0) {
+                result.error = m->index_error;
+                return;
+            }
+            node = m->node;
+        } else if (m && mask == 0) {
+            node = m->node;
+        }
+
+        if (node == Node::NONE || header.count == MAX_NODES) {
+            header.malformed = true;
+            break;
+        }
+        header.nodes[header.count] = node;
+        header.mask[header.count] = mask;
+        header.count++;
+
+        if (*p == ':') {
+            p++;
+            continue;
+        }
+        if (*p == '?') {
+            header.query = true;
+            p++;
+        }
+        if (*p != '\0' && !std::isspace(static_cast<unsigned char>(*p))) {
+            header.malformed = true;
+        }
+        break;
     }
 
-    if (parse_system_command(line, result)) {
-        return result;
+    const ScpiRoute* route = header.malformed ? nullptr : find_route(header);
+    if (!route) {
+        result.error = miss_error(header);
+        return;
     }
 
-    if (parse_board_command(line, result)) {
-        return result;
+    result.type = route->type;
+    result.is_query = route->query;
+
+    // Addresses come from the indexed nodes; a range or list sets more than
+    // one mask bit, and the id is the lowest index addressed
+    for (size_t i = 0; i < header.count; i++) {
+        uint8_t mask = static_cast<uint8_t>(header.mask[i]);
+        if (!mask) continue;
+        int8_t first = static_cast<int8_t>(__builtin_ctz(mask));
+        switch (header.nodes[i]) {
+            case Node::BOARD: result.board_id = first;   result.board_mask = mask; break;
+            case Node::DAC:   result.dac_id = first;     result.dac_mask = mask; break;
+            case Node::CH:    result.channel_id = first; result.channel_mask = mask; break;
+            default: break;
+        }
+        if (mask & (mask - 1)) result.has_range = true;
     }
 
-    result.error_msg = "Unknown command";
-    return result;
+    // Broadcast target -> DAC mask (bit m = DAC m on every board); BCAST:DAC<m>
+    // takes its mask from the index, so BCAST:DAC0:1 is simply a DAC range
+    if (header.nodes[0] == Node::BCAST) {
+        switch (header.nodes[1]) {
+            case Node::CURR: result.dac_mask = 0x03; break;
+            case Node::VOLT: result.dac_mask = 0x04; break;
+            case Node::ALL:  result.dac_mask = 0x07; break;
+            default: break;
+        }
+        result.dac_id = -1;
+        result.has_range = false;
+    }
+
+    if (!parse_argument(*route, p, result)) {
+        return;
+    }
+    result.valid = true;
 }
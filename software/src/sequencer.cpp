@@ -0,0 +1,145 @@
+#include "sequencer.hpp"
+#include "dac_device.hpp"
+#include "board_manager.hpp"
+#include "hardware/sync.h"
+
+Sequencer::Sequencer(BoardManager& boards) : boards_(boards) {}
+
+void Sequencer::clear() {
+    stop();
+    num_tracks_ = 0;
+    pool_used_ = 0;
+    length_ = 0;
+    num_touched_ = 0;
+}
+
+bool Sequencer::append(DacDevice* dac, uint8_t board, uint8_t dac_id, uint8_t channel,
+                       const uint16_t* codes, size_t count) {
+    if (state_ != SeqState::IDLE || !dac) return false;
+    if (count > static_cast<size_t>(SEQ::MAX_SAMPLES - pool_used_)) return false;
+
+    // Find an existing track for this channel
+    Track* track = nullptr;
+    for (uint8_t i = 0; i < num_tracks_; i++) {
+        Track& t = tracks_[i];
+        if (t.board == board && t.dac_id == dac_id && t.channel == channel) {
+            track = &t;
+            // Tables are contiguous: only the newest track can grow
+            if (i != num_tracks_ - 1) return false;
+            break;
+        }
+    }
+
+    if (!track) {
+        if (num_tracks_ >= SEQ::MAX_TRACKS) return false;
+        track = &tracks_[num_tracks_++];
+        *track = {dac, board, dac_id, channel, pool_used_, 0};
+
+        // Remember each distinct chip once for the per-tick commit
+        bool seen = false;
+        for (uint8_t i = 0; i < num_touched_; i++) {
+            if (touched_[i] == dac) seen = true;
+        }
+        if (!seen) touched_[num_touched_++] = dac;
+    }
+
+    for (size_t i = 0; i < count; i++) {
+        samples_[pool_used_++] = codes[i];
+    }
+    track->length += static_cast<uint16_t>(count);
+    if (track->length > length_) length_ = track->length;
+    return true;
+}
+
+bool Sequencer::set_rate(uint32_t rate_hz) {
+    if (state_ != SeqState::IDLE) return false;
+    if (rate_hz < SEQ::MIN_RATE_HZ || rate_hz > SEQ::MAX_RATE_HZ) return false;
+    rate_hz_ = rate_hz;
+    return true;
+}
+
+bool Sequencer::start() {
+    if (state_ != SeqState::IDLE || num_tracks_ == 0 || length_ == 0) return false;
+
+    position_ = 0;
+    loops_done_ = 0;
+
+    if (trigger_source_ != SeqTrigger::IMMEDIATE) {
+        state_ = SeqState::ARMED;
+    } else {
+        begin_playback();
+    }
+    return true;
+}
+
+bool Sequencer::trigger() {
+    // SEQ:TRIG and the trigger IRQ can race: only one of them starts playback
+    uint32_t saved = save_and_disable_interrupts();
+    bool armed = state_ == SeqState::ARMED;
+    if (armed) state_ = SeqState::RUNNING;
+    restore_interrupts(saved);
+
+    if (armed) begin_playback();
+    return armed;
+}
+
+void Sequencer::begin_playback() {
+    state_ = SeqState::RUNNING;
+
+    // Output the first sample now so sample 0 is not delayed by one period
+    step();
+    if (state_ != SeqState::RUNNING) return;  // A single-sample, single-loop table is done
+
+    // Negative delay: period measured from the start of each callback
+    int64_t period_us = -static_cast<int64_t>(1000000u / rate_hz_);
+    bool added = alarm_pool_
+        ? alarm_pool_add_repeating_timer_us(alarm_pool_, period_us, timer_callback, this, &timer_)
+        : add_repeating_timer_us(period_us, timer_callback, this, &timer_);
+    if (!added) {
+        state_ = SeqState::IDLE;  // No free alarm slot
+    }
+}
+
+void Sequencer::stop() {
+    if (state_ == SeqState::RUNNING) {
+        cancel_repeating_timer(&timer_);
+    }
+    state_ = SeqState::IDLE;
+}
+
+void Sequencer::step() {
+    uint16_t pos = position_;
+
+    // Load every track's sample into its input register...
+    for (uint8_t i = 0; i < num_tracks_; i++) {
+        const Track& t = tracks_[i];
+        uint16_t idx = (pos < t.length) ? pos : static_cast<uint16_t>(t.length - 1);
+        t.dac->write_code(t.channel, samples_[t.offset + idx]);
+    }
+
+    // ...then commit them together
+#ifdef SINGLE_BOARD_MODE
+    for (uint8_t i = 0; i < num_touched_; i++) {
+        touched_[i]->update_all();
+    }
+#else
+    // Latches every chip, so every shadow is mirrored, not only the tracks'
+    boards_.pulse_ldac();
+#endif
+
+    if (++pos >= length_) {
+        pos = 0;
+        loops_done_ = loops_done_ + 1;
+        if (loops_ != 0 && loops_done_ >= loops_) {
+            state_ = SeqState::IDLE;  // Timer callback returns false to cancel
+        }
+    }
+    position_ = pos;
+}
+
+bool Sequencer::timer_callback(repeating_timer_t* rt) {
+    Sequencer* self = static_cast<Sequencer*>(rt->user_data);
+    if (self->state_ != SeqState::RUNNING) return false;
+    self->step();
+    return self->state_ == SeqState::RUNNING;
+}
@@ -0,0 +1,91 @@
+#include "spi_dma.hpp"
+#include "pico/stdlib.h"
+#include "hardware/dma.h"
+#include "hardware/gpio.h"
+#include "hardware/irq.h"
+#include "hardware/sync.h"
+
+SpiDma* SpiDma::instance_ = nullptr;
+
+void SpiDma::init(spi_inst_t* spi) {
+    spi_ = spi;
+    tx_chan_ = dma_claim_unused_channel(true);
+    rx_chan_ = dma_claim_unused_channel(true);
+
+    // TX: memory -> SPI data register, paced by the TX FIFO
+    dma_channel_config tx = dma_channel_get_default_config(tx_chan_);
+    channel_config_set_transfer_data_size(&tx, DMA_SIZE_8);
+    channel_config_set_dreq(&tx, spi_get_dreq(spi, true));
+    channel_config_set_read_increment(&tx, true);
+    channel_config_set_write_increment(&tx, false);
+    dma_channel_configure(tx_chan_, &tx, &spi_get_hw(spi)->dr, nullptr, 0, false);
+
+    // RX: drain the SPI data register so completion means "all bits clocked"
+    dma_channel_config rx = dma_channel_get_default_config(rx_chan_);
+    channel_config_set_transfer_data_size(&rx, DMA_SIZE_8);
+    channel_config_set_dreq(&rx, spi_get_dreq(spi, false));
+    channel_config_set_read_increment(&rx, false);
+    channel_config_set_write_increment(&rx, false);
+    dma_channel_configure(rx_chan_, &rx, &rx_discard_, &spi_get_hw(spi)->dr, 0, false);
+
+    instance_ = this;
+
+    // Highest priority: the sequencer timer IRQ may wait on this one for queue space
+    dma_channel_set_irq0_enabled(rx_chan_, true);
+    irq_add_shared_handler(DMA_IRQ_0, irq_handler, PICO_SHARED_IRQ_HANDLER_DEFAULT_ORDER_PRIORITY);
+    irq_set_priority(DMA_IRQ_0, PICO_HIGHEST_IRQ_PRIORITY);
+    irq_set_enabled(DMA_IRQ_0, true);
+
+    ready_ = true;
+}
+
+void SpiDma::kick() {
+    if (!running_) {
+        start_next();
+    }
+}
+
+void SpiDma::start_next() {
+    if (!queue_.pop(current_)) {
+        running_ = false;
+        return;
+    }
+    running_ = true;
+
+    if (current_.cs_pin != SPI_DMA::CS_NONE) {
+        gpio_put(current_.cs_pin, 0);
+    }
+
+    dma_channel_set_write_addr(rx_chan_, &rx_discard_, false);
+    dma_channel_set_trans_count(rx_chan_, current_.len, false);
+    dma_channel_set_read_addr(tx_chan_, current_.data, false);
+    dma_channel_set_trans_count(tx_chan_, current_.len, false);
+    dma_start_channel_mask((1u << tx_chan_) | (1u << rx_chan_));
+}
+
+void SpiDma::irq_handler() {
+    SpiDma* self = instance_;
+    if (!self || !dma_channel_get_irq0_status(self->rx_chan_)) return;  // Shared IRQ: not ours
+    dma_channel_acknowledge_irq0(self->rx_chan_);
+
+    if (self->current_.cs_pin != SPI_DMA::CS_NONE) {
+        gpio_put(self->current_.cs_pin, 1);
+    }
+    self->start_next();
+}
+
+void SpiDma::wait_idle() const {
+    while (running_) {
+        tight_loop_contents();
+    }
+}
+
+uint32_t SpiDma::acquire_idle() {
+    while (true) {
+        uint32_t saved = save_and_disable_interrupts();
+        if (!instance_ || !instance_->running_) return saved;
+        // Let the DMA IRQ run (this may itself be called from a lower-priority IRQ)
+        restore_interrupts(saved);
+        tight_loop_contents();
+    }
+}
@@ -1,6 +1,10 @@
 #include "spi_manager.hpp"
 #include "pico/stdlib.h"
 #include "hardware/gpio.h"
+#include "hardware/sync.h"
+#include "bus_guard.hpp"
+#include "perf_stats.hpp"
+#include <cstring>
 
 void SpiManager::init_gpio() {
 #ifdef SINGLE_BOARD_MODE
@@ -95,6 +99,9 @@ void SpiManager::init() {
     // automatic CS behavior on GP17 (which is a valid SPI0_CSn pin).
     init_spi();
     init_gpio();
+
+    // CS, SCK and MOSI move to the PIO for write-only frames
+    pio_bus_.init(SPI_CONFIG::BAUDRATE);
 #else
     // Multi-board mode: Full initialization sequence per documentation:
     // 1. Set GP21 HIGH (enable TXB0106 level-shifter) - MUST BE FIRST
@@ -112,19 +119,35 @@ void SpiManager::init() {
     initialized_ = true;
 }
 
+#ifdef SINGLE_BOARD_MODE
+// Hands the shared pins to the SPI peripheral for the scope of a blocking transfer
+class PioSuspend {
+public:
+    explicit PioSuspend(PioDacBus& bus) : bus_(bus) { if (bus_.ready()) bus_.suspend(); }
+    ~PioSuspend() { if (bus_.ready()) bus_.resume(); }
+
+private:
+    PioDacBus& bus_;
+};
+
+uint8_t SpiManager::dac_cs_pin(uint8_t device_id) {
+    switch (device_id) {
+        case 0: return HW_PINS_SINGLE::CS_DAC0;
+        case 1: return HW_PINS_SINGLE::CS_DAC1;
+        case 2: return HW_PINS_SINGLE::CS_DAC2;
+        default: return SPI_DMA::CS_NONE;  // Invalid device_id
+    }
+}
+#endif
+
 void SpiManager::select_downstream(uint8_t board_id, uint8_t device_id) {
 #ifdef SINGLE_BOARD_MODE
     (void)board_id;  // Always 0 in single-board mode
     deselect();  // Deselect any previous DAC first
 
     // Map device_id to GPIO pin
-    uint cs_pin;
-    switch (device_id) {
-        case 0: cs_pin = HW_PINS_SINGLE::CS_DAC0; break;
-        case 1: cs_pin = HW_PINS_SINGLE::CS_DAC1; break;
-        case 2: cs_pin = HW_PINS_SINGLE::CS_DAC2; break;
-        default: return;  // Invalid device_id
-    }
+    uint8_t cs_pin = dac_cs_pin(device_id);
+    if (cs_pin == SPI_DMA::CS_NONE) return;
     gpio_put(cs_pin, 0);  // Assert CS (active low)
     current_selected_dac_ = device_id;
 #else
@@ -137,14 +160,7 @@ void SpiManager::deselect() {
 #ifdef SINGLE_BOARD_MODE
     // Deassert all CS pins
     if (current_selected_dac_ < 3) {
-        uint cs_pin;
-        switch (current_selected_dac_) {
-            case 0: cs_pin = HW_PINS_SINGLE::CS_DAC0; break;
-            case 1: cs_pin = HW_PINS_SINGLE::CS_DAC1; break;
-            case 2: cs_pin = HW_PINS_SINGLE::CS_DAC2; break;
-            default: return;
-        }
-        gpio_put(cs_pin, 1);  // Deassert CS
+        gpio_put(dac_cs_pin(current_selected_dac_), 1);  // Deassert CS
         current_selected_dac_ = 0xFF;
     }
 #else
@@ -153,9 +169,70 @@ void SpiManager::deselect() {
 #endif
 }
 
+void SpiManager::start_dma() {
+#ifndef SINGLE_BOARD_MODE
+    dma_.init(SPI_CONFIG::get_spi_instance());
+#endif
+}
+
+void SpiManager::flush() {
+#ifdef SINGLE_BOARD_MODE
+    BusGuard guard;
+    pio_bus_.wait_idle();
+#else
+    dma_.wait_idle();
+#endif
+}
+
+uint32_t SpiManager::reserve_segments(size_t count) {
+    while (true) {
+        uint32_t saved = save_and_disable_interrupts();
+        if (dma_.has_space(count)) return saved;
+        // Queue full: let the DMA IRQ retire a few segments
+        restore_interrupts(saved);
+        tight_loop_contents();
+    }
+}
+
+void SpiManager::queue_transaction(uint8_t board_id, uint8_t device_id,
+                                   const uint8_t* tx_data, size_t len) {
+    // Segments for one frame are queued together with interrupts masked, so
+    // the expander cache and queue order stay consistent when the sequencer
+    // IRQ queues frames of its own
+    uint32_t saved = reserve_segments(3);
+
+    SpiSegment frame;
+    frame.len = static_cast<uint8_t>(len);
+    memcpy(frame.data, tx_data, len);
+
+#ifdef SINGLE_BOARD_MODE
+    (void)board_id;
+    frame.cs_pin = dac_cs_pin(device_id);
+    if (frame.cs_pin != SPI_DMA::CS_NONE) {
+        dma_.push(frame);
+    }
+#else
+    // Expander writes are framed by SPI_CS; the DAC frame itself is framed
+    // by D_EN through the decoder tree
+    SpiSegment expander;
+    expander.cs_pin = HW_PINS::SPI_CS;
+    expander.len = 3;
+
+    io_expander_.prepare_select(board_id, device_id, expander.data);
+    dma_.push(expander);
+    dma_.push(frame);
+    io_expander_.prepare_deselect(expander.data);
+    dma_.push(expander);
+#endif
+
+    dma_.kick();
+    restore_interrupts(saved);
+}
+
 void SpiManager::raw_transfer(const uint8_t* tx_data, uint8_t* rx_data, size_t len) {
     // Raw SPI transfer without CS management
     // Used for direct IO expander access (which manages its own CS)
+    BusGuard guard;
     spi_inst_t* spi = SPI_CONFIG::get_spi_instance();
     if (rx_data != nullptr) {
         spi_write_read_blocking(spi, tx_data, rx_data, len);
@@ -166,6 +243,8 @@ void SpiManager::raw_transfer(const uint8_t* tx_data, uint8_t* rx_data, size_t l
 
 void SpiManager::transaction(uint8_t board_id, uint8_t device_id,
                               const uint8_t* tx_data, uint8_t* rx_data, size_t len) {
+    PerfScope perf(PerfProbe::SPI_TRANSACTION);
+
     // DAC transaction protocol:
     //
     // Single-board mode:
@@ -178,12 +257,39 @@ void SpiManager::transaction(uint8_t board_id, uint8_t device_id,
     //      (decoder tree provides CS to selected DAC)
     //   2. Perform DAC SPI transaction (decoder tree holds CS)
     //   3. Deassert D_EN via IO expander
+    //
+    // Write-only frames take the same steps as queued DMA segments once the
+    // queue is running (start_dma()); the CS hand-off happens in its IRQ.
+#ifdef SINGLE_BOARD_MODE
+    // Single-board mode: one PIO-timed frame, no GPIO switch or sleeps
+    if (rx_data == nullptr && len == 3 && pio_bus_.ready()) {
+        BusGuard guard;
+        pio_bus_.write_frame(device_id, tx_data);
+        return;
+    }
+#endif
+    if (rx_data == nullptr && dma_.ready() && len <= SPI_DMA::MAX_SEGMENT_LEN) {
+        queue_transaction(board_id, device_id, tx_data, len);
+        return;
+    }
+
+    // The whole select/transfer/deselect sequence is atomic with respect to
+    // IRQ-driven transactions (sequencer), and waits for queued frames
+    BusGuard guard;
+#ifdef SINGLE_BOARD_MODE
+    // Readback: borrow the pins back from the PIO once its frames are out
+    PioSuspend pio_suspend(pio_bus_);
+#endif
 
     // Step 1: Select the target DAC
     select_downstream(board_id, device_id);
 
+#ifdef SINGLE_BOARD_MODE
     // Small delay to ensure CS is stable before clocking data
     sleep_us(1);
+#endif
+    // Multi-board mode: the expander GPIO changes on the last clock of the
+    // Port A write, which already exceeds the DAC CS setup time
 
     // Step 2: Perform SPI transaction to DAC
     spi_inst_t* spi = SPI_CONFIG::get_spi_instance();
@@ -193,8 +299,12 @@ void SpiManager::transaction(uint8_t board_id, uint8_t device_id,
         spi_write_blocking(spi, tx_data, len);
     }
 
+#ifdef SINGLE_BOARD_MODE
     // Small delay for DAC to latch data
     sleep_us(1);
+#endif
+    // Multi-board mode: spi_write_blocking() returns once the last bit has
+    // been clocked, and the deselect write provides the CS hold time
 
     // Step 3: Deselect DAC
     deselect();
@@ -202,13 +312,32 @@ void SpiManager::transaction(uint8_t board_id, uint8_t device_id,
 
 void SpiManager::pulse_ldac() {
 #ifndef SINGLE_BOARD_MODE
+    if (dma_.ready()) {
+        // Two Port B writes behind the queued frames; the CS hand-off between
+        // them (one IRQ) far exceeds the 20 ns minimum LDAC pulse width
+        uint32_t saved = reserve_segments(2);
+        SpiSegment low;
+        SpiSegment high;
+        low.cs_pin = high.cs_pin = HW_PINS::SPI_CS;
+        low.len = high.len = 3;
+        io_expander_.prepare_ldac(low.data, high.data);
+        dma_.push(low);
+        dma_.push(high);
+        dma_.kick();
+        restore_interrupts(saved);
+        return;
+    }
+
     io_expander_.pulse_ldac();
 #endif
     // Single-board mode: DACs configured for immediate update, no LDAC needed
 }
 
 void SpiManager::assert_clear() {
+    // Queued frames land before CLR is asserted
+    BusGuard guard;
 #ifdef SINGLE_BOARD_MODE
+    pio_bus_.wait_idle();
     gpio_put(HW_PINS_SINGLE::CLR, 0);  // Assert CLR (active low)
 #else
     io_expander_.assert_clear();
@@ -216,6 +345,7 @@ void SpiManager::assert_clear() {
 }
 
 void SpiManager::release_clear() {
+    BusGuard guard;
 #ifdef SINGLE_BOARD_MODE
     gpio_put(HW_PINS_SINGLE::CLR, 1);  // Release CLR
 #else
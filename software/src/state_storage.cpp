@@ -0,0 +1,220 @@
+#include "state_storage.hpp"
+#include "response_buffer.hpp"
+#include <cstring>
+#include <cstddef>
+
+namespace StateStorage {
+
+namespace {
+
+// Upper-case copy of the name, padded with NULs as it is stored
+// NONE is reserved for SNAP:BOOT NONE
+bool normalize(const char* name, char (&out)[STATE_NAME_MAX_LEN]) {
+    memset(out, 0, sizeof(out));
+    size_t len = 0;
+    for (; name[len]; len++) {
+        char c = name[len];
+        if (len == STATE_NAME_MAX_LEN - 1) return false;
+        if (c >= 'a' && c <= 'z') c = static_cast<char>(c - 'a' + 'A');
+        if (!((c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9') || c == '_')) return false;
+        out[len] = c;
+    }
+    return len > 0 && strcmp(out, "NONE") != 0;
+}
+
+uint32_t slot_offset(uint32_t slot) {
+    return STATE_FLASH_OFFSET + slot * CalStorage::FLASH_SECTOR_SIZE;
+}
+
+const StateSlot& slot_at(uint32_t slot) {
+    return *reinterpret_cast<const StateSlot*>(CalStorage::flash_ptr(slot_offset(slot)));
+}
+
+uint32_t slot_checksum(const StateSlot& slot) {
+    return CalStorage::calculate_crc32(reinterpret_cast<const uint8_t*>(&slot),
+                                       offsetof(StateSlot, checksum));
+}
+
+bool slot_valid(uint32_t slot) {
+    const StateSlot& s = slot_at(slot);
+    return s.magic == STATE_MAGIC && s.version == STATE_VERSION &&
+           s.checksum == slot_checksum(s);
+}
+
+bool same_name(const StateSlot& slot, const char* name) {
+    return strncmp(slot.name, name, STATE_NAME_MAX_LEN) == 0;
+}
+
+// Newest valid copy of a name, or -1
+int find(const char* name) {
+    int best = -1;
+    for (uint32_t i = 0; i < STATE_SLOTS; i++) {
+        if (!slot_valid(i) || !same_name(slot_at(i), name)) continue;
+        if (best < 0 || slot_at(i).sequence > slot_at(best).sequence) best = i;
+    }
+    return best;
+}
+
+// The slot holding the current copy of its name (not a stale duplicate)
+bool is_current(uint32_t slot) {
+    return slot_valid(slot) && find(slot_at(slot).name) == static_cast<int>(slot);
+}
+
+uint32_t next_sequence() {
+    uint32_t sequence = 0;
+    for (uint32_t i = 0; i < STATE_SLOTS; i++) {
+        if (slot_valid(i) && slot_at(i).sequence >= sequence) sequence = slot_at(i).sequence + 1;
+    }
+    return sequence;
+}
+
+// Snapshots with a current copy
+uint32_t count() {
+    uint32_t n = 0;
+    for (uint32_t i = 0; i < STATE_SLOTS; i++) {
+        if (is_current(i)) n++;
+    }
+    return n;
+}
+
+// Program a new copy of a snapshot, then erase every other copy of its name.
+// save() leaves one sector spare, so the target is a free sector or a stale
+// duplicate and the old copy survives until the new one is programmed.
+ScpiError write(StateSlot& slot) {
+    int target = -1;
+    for (uint32_t i = 0; i < STATE_SLOTS && target < 0; i++) {
+        if (!slot_valid(i)) target = i;
+    }
+    for (uint32_t i = 0; i < STATE_SLOTS && target < 0; i++) {
+        if (!is_current(i)) target = i;
+    }
+    if (target < 0) return ScpiError::SNAP_FULL;
+
+    slot.sequence = next_sequence();
+    slot.checksum = slot_checksum(slot);
+
+    CalStorage::erase_range(slot_offset(target), 1);
+    if (!CalStorage::program(slot_offset(target), reinterpret_cast<const uint8_t*>(&slot),
+                             sizeof(slot))) {
+        return ScpiError::FLASH_WRITE_FAILED;
+    }
+
+    for (uint32_t i = 0; i < STATE_SLOTS; i++) {
+        if (static_cast<int>(i) != target && slot_valid(i) && same_name(slot_at(i), slot.name)) {
+            CalStorage::erase_range(slot_offset(i), 1);
+        }
+    }
+    return ScpiError::NONE;
+}
+
+// Current copy marked for power-up, newest first if several are
+int find_boot() {
+    int best = -1;
+    for (uint32_t i = 0; i < STATE_SLOTS; i++) {
+        if (!is_current(i) || !(slot_at(i).flags & STATE_FLAG_BOOT)) continue;
+        if (best < 0 || slot_at(i).sequence > slot_at(best).sequence) best = i;
+    }
+    return best;
+}
+
+char boot_name_[STATE_NAME_MAX_LEN];
+
+}  // namespace
+
+ScpiError save(const BoardManager& manager, const char* name) {
+    StateSlot slot;
+    memset(&slot, 0xFF, sizeof(slot));
+    if (!normalize(name, slot.name)) return ScpiError::INVALID_SNAP_NAME;
+
+    int existing = find(slot.name);
+    if (existing < 0 && count() >= STATE_SLOTS - 1) return ScpiError::SNAP_FULL;
+    slot.magic = STATE_MAGIC;
+    slot.version = STATE_VERSION;
+    // A resaved snapshot keeps its power-up mark
+    slot.flags = (existing >= 0) ? (slot_at(existing).flags & STATE_FLAG_BOOT) : 0;
+    manager.capture_output_state(slot.state);
+    return write(slot);
+}
+
+ScpiError restore(BoardManager& manager, const char* name) {
+    char key[STATE_NAME_MAX_LEN];
+    if (!normalize(name, key)) return ScpiError::INVALID_SNAP_NAME;
+    int slot = find(key);
+    if (slot < 0) return ScpiError::SNAP_NOT_FOUND;
+    return manager.restore_output_state(slot_at(slot).state);
+}
+
+ScpiError erase(const char* name) {
+    char key[STATE_NAME_MAX_LEN];
+    if (!normalize(name, key)) return ScpiError::INVALID_SNAP_NAME;
+    if (find(key) < 0) return ScpiError::SNAP_NOT_FOUND;
+    for (uint32_t i = 0; i < STATE_SLOTS; i++) {
+        if (slot_valid(i) && same_name(slot_at(i), key)) {
+            CalStorage::erase_range(slot_offset(i), 1);
+        }
+    }
+    return ScpiError::NONE;
+}
+
+ScpiError set_boot(const char* name) {
+    char key[STATE_NAME_MAX_LEN] = {0};
+    if (name) {
+        if (!normalize(name, key)) return ScpiError::INVALID_SNAP_NAME;
+        if (find(key) < 0) return ScpiError::SNAP_NOT_FOUND;
+    }
+
+    // Rewrite each snapshot whose mark changes; the copy lands in another
+    // slot, which this loop may reach again, already marked as wanted
+    for (uint32_t i = 0; i < STATE_SLOTS; i++) {
+        if (!is_current(i)) continue;
+        bool wanted = name && same_name(slot_at(i), key);
+        bool marked = slot_at(i).flags & STATE_FLAG_BOOT;
+        if (wanted == marked) continue;
+
+        StateSlot slot;
+        memcpy(&slot, &slot_at(i), sizeof(slot));
+        slot.flags ^= STATE_FLAG_BOOT;
+        ScpiError err = write(slot);
+        if (err != ScpiError::NONE) return err;
+    }
+    return ScpiError::NONE;
+}
+
+const char* boot_name() {
+    int slot = find_boot();
+    if (slot < 0) return nullptr;
+    memcpy(boot_name_, slot_at(slot).name, STATE_NAME_MAX_LEN);
+    boot_name_[STATE_NAME_MAX_LEN - 1] = '\0';
+    return boot_name_;
+}
+
+void list(ResponseBuffer& out) {
+    // Current copies in sequence order, one pass per snapshot
+    bool first = true;
+    uint32_t after = 0;
+    while (true) {
+        int next = -1;
+        for (uint32_t i = 0; i < STATE_SLOTS; i++) {
+            if (!is_current(i)) continue;
+            uint32_t sequence = slot_at(i).sequence;
+            if (!first && sequence <= after) continue;
+            if (next < 0 || sequence < slot_at(next).sequence) next = i;
+        }
+        if (next < 0) break;
+
+        if (!first) out.append(",");
+        out.append(slot_at(next).name);  // NUL-terminated by normalize()
+        first = false;
+        after = slot_at(next).sequence;
+    }
+}
+
+const char* restore_boot(BoardManager& manager, ScpiError& error) {
+    error = ScpiError::NONE;
+    const char* name = boot_name();
+    if (!name) return nullptr;
+    error = manager.restore_output_state(slot_at(find_boot()).state);
+    return name;
+}
+
+}  // namespace StateStorage
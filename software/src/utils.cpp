@@ -131,4 +131,122 @@ bool parse_float(const std::string &s, float &out) {
     return true;
 }
 
+namespace {
+
+// Byte-at-a-time CRC tables, generated at compile time
+struct Crc16Table {
+    uint16_t entry[256];
+    constexpr Crc16Table() : entry() {
+        for (int i = 0; i < 256; i++) {
+            uint16_t crc = static_cast<uint16_t>(i << 8);
+            for (int j = 0; j < 8; j++) {
+                crc = (crc & 0x8000) ? static_cast<uint16_t>((crc << 1) ^ 0x1021)
+                                     : static_cast<uint16_t>(crc << 1);
+            }
+            entry[i] = crc;
+        }
+    }
+};
+
+struct Crc32Table {
+    uint32_t entry[256];
+    constexpr Crc32Table() : entry() {
+        for (uint32_t i = 0; i < 256; i++) {
+            uint32_t crc = i;
+            for (int j = 0; j < 8; j++) {
+                crc = (crc & 1) ? (crc >> 1) ^ 0xEDB88320u : crc >> 1;
+            }
+            entry[i] = crc;
+        }
+    }
+};
+
+constexpr Crc16Table CRC16_TABLE;
+constexpr Crc32Table CRC32_TABLE;
+
+static_assert(CRC16_TABLE.entry[1] == 0x1021, "CRC-16 table");
+static_assert(CRC32_TABLE.entry[1] == 0x77073096u, "CRC-32 table");
+
+constexpr char BASE64_ALPHABET[] =
+    "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+
+// Character -> 6-bit value, 0xFF for anything outside the alphabet
+struct Base64Table {
+    uint8_t entry[256];
+    constexpr Base64Table() : entry() {
+        for (int i = 0; i < 256; i++) entry[i] = 0xFF;
+        for (int i = 0; i < 64; i++) {
+            entry[static_cast<uint8_t>(BASE64_ALPHABET[i])] = static_cast<uint8_t>(i);
+        }
+    }
+};
+
+constexpr Base64Table BASE64_TABLE;
+
+static_assert(BASE64_TABLE.entry['/'] == 63, "Base64 table");
+
+}  // namespace
+
+uint16_t crc16_ccitt(const uint8_t* data, size_t length, uint16_t crc) {
+    for (size_t i = 0; i < length; i++) {
+        crc = static_cast<uint16_t>((crc << 8) ^ CRC16_TABLE.entry[(crc >> 8) ^ data[i]]);
+    }
+    return crc;
+}
+
+uint32_t crc32(const uint8_t* data, size_t length, uint32_t crc) {
+    crc = ~crc;
+    for (size_t i = 0; i < length; i++) {
+        crc = (crc >> 8) ^ CRC32_TABLE.entry[(crc ^ data[i]) & 0xFF];
+    }
+    return ~crc;
+}
+
+void base64_encode(const uint8_t* data, size_t length, char* out) {
+    size_t i = 0;
+    for (; i + 3 <= length; i += 3) {
+        uint32_t v = (data[i] << 16) | (data[i + 1] << 8) | data[i + 2];
+        *out++ = BASE64_ALPHABET[(v >> 18) & 0x3F];
+        *out++ = BASE64_ALPHABET[(v >> 12) & 0x3F];
+        *out++ = BASE64_ALPHABET[(v >> 6) & 0x3F];
+        *out++ = BASE64_ALPHABET[v & 0x3F];
+    }
+    if (i < length) {
+        uint32_t v = data[i] << 16;
+        if (i + 1 < length) v |= data[i + 1] << 8;
+        *out++ = BASE64_ALPHABET[(v >> 18) & 0x3F];
+        *out++ = BASE64_ALPHABET[(v >> 12) & 0x3F];
+        *out++ = (i + 1 < length) ? BASE64_ALPHABET[(v >> 6) & 0x3F] : '=';
+        *out++ = '=';
+    }
+    *out = '\0';
+}
+
+int32_t base64_decode(const char* text, size_t length, uint8_t* out, size_t capacity) {
+    if (length % 4 != 0) return -1;
+    size_t written = 0;
+    for (size_t i = 0; i < length; i += 4) {
+        // Padding is only allowed in the last group
+        size_t pad = 0;
+        if (i + 4 == length) {
+            if (text[i + 3] == '=') pad++;
+            if (pad && text[i + 2] == '=') pad++;
+        }
+        uint32_t v = 0;
+        for (size_t j = 0; j < 4 - pad; j++) {
+            uint8_t bits = BASE64_TABLE.entry[static_cast<uint8_t>(text[i + j])];
+            if (bits == 0xFF) return -1;
+            v = (v << 6) | bits;
+        }
+        v <<= 6 * pad;
+
+        size_t n = 3 - pad;
+        if (written + n > capacity) return -1;
+        out[written++] = static_cast<uint8_t>(v >> 16);
+        if (n > 1) out[written++] = static_cast<uint8_t>(v >> 8);
+        if (n > 2) out[written++] = static_cast<uint8_t>(v);
+    }
+    return static_cast<int32_t>(written);
+}
+
 } // namespace utils